@@ -0,0 +1,117 @@
+/*  Times ALU-heavy loops, each built from one of the arithmetic, logic, rotate, shift and bit
+    programs in test/include/test_roms.h, repeated back to back with a jump to the start. Every
+    event is cancelled, so the CPU runs on its own, and emulated MHz is reported for the
+    interpreter, the block cache and the JIT. Flags are almost always overwritten before being
+    read in these loops, which is the case lazy flag evaluation is for.
+    Usage: bench_alu [frames]
+*/
+#include "bench_common.h"
+#include "gameboy.h"
+#include "headless.h"
+#include "test_roms.h"
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    enum Mode { INTERPRETED, BLOCKS, JIT };
+
+    struct Program
+    {
+        const char *name;
+        const std::vector<u8> &code;
+    };
+
+    const Program PROGRAMS[] = {
+        {"add", test::add},
+        {"sub", test::sub},
+        {"and", test::and_op},
+        {"or", test::or_op},
+        {"xor", test::xor_op},
+        {"cp", test::cp},
+        {"cpl", test::cpl},
+        {"swap", test::swap},
+        {"rotate_right_carry", test::rotate_right_carry},
+        {"rotate_right", test::rotate_right},
+        {"rotate_left_carry", test::rotate_left_carry},
+        {"rotate_left", test::rotate_left},
+        {"rotate_left_mem", test::rotate_left_mem},
+        {"shift_left", test::shift_left},
+        {"shift_right_arithmetic", test::shift_right_arithmetic},
+        {"shift_right_logical", test::shift_right_logical},
+        {"shift_right_logical_mem", test::shift_right_logical_mem},
+        {"bit_set", test::bit_set},
+        {"bit_reset", test::bit_reset},
+        {"bit_mem_set", test::bit_mem_set},
+    };
+
+    // Longest loop body a backward JR can reach
+    const size_t MAX_LOOP_SIZE = 126;
+
+    // The program repeated as many times as fits in a loop at 0x150
+    std::vector<u8> loop_rom(const std::vector<u8> &code)
+    {
+        std::vector<u8> rom(0x8000, 0);
+        // Entry point: jp 0x150
+        rom[0x100] = 0xc3; rom[0x101] = 0x50; rom[0x102] = 0x01;
+
+        std::vector<u8> loop;
+        while (loop.size() + code.size() <= MAX_LOOP_SIZE) {
+            loop.insert(loop.end(), code.begin(), code.end());
+        }
+        loop.push_back(0x18);
+        loop.push_back((u8)(-(int)loop.size() - 1));
+        std::copy(loop.begin(), loop.end(), rom.begin() + 0x150);
+        return rom;
+    }
+
+    double cpu_mhz(const std::vector<u8> &rom, int num_frames, Mode mode)
+    {
+        NullVideoSink video;
+        NullAudioSink audio;
+        GameBoy gb(RomImage::from_data(rom), &video, &audio);
+        if (mode == INTERPRETED) {
+            gb.cpu.attach_block_cache(nullptr);
+        }
+        if (mode != JIT) {
+            gb.cpu.attach_jit(nullptr);
+        }
+        gb.cpu.enable_idle_skip = false;
+        gb.run_frame();
+        for (int event = 0; event < Scheduler::NUM_EVENTS; event++) {
+            gb.scheduler.cancel((Scheduler::Event)event);
+        }
+
+        u64 start = gb.cycles();
+        bench::Timer timer;
+        gb.cpu.run_until(start + (u64)num_frames * GameBoy::CYCLES_PER_FRAME);
+        return (gb.cycles() - start) / timer.seconds() / 1e6;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_frames = argc > 1 ? std::stoi(argv[1]) : 1000;
+
+    std::cout << std::left << std::setw(26) << "program" << std::right
+              << std::setw(14) << "interpreted" << std::setw(14) << "block cache"
+              << std::setw(14) << "JIT" << "   (emulated MHz)\n" << std::fixed
+              << std::setprecision(1);
+    double total[3] = {0, 0, 0};
+    for (const Program &program: PROGRAMS) {
+        std::vector<u8> rom = loop_rom(program.code);
+        std::cout << std::left << std::setw(26) << program.name << std::right;
+        for (Mode mode: {INTERPRETED, BLOCKS, JIT}) {
+            double mhz = cpu_mhz(rom, num_frames, mode);
+            total[mode] += mhz;
+            std::cout << std::setw(14) << mhz;
+        }
+        std::cout << "\n";
+    }
+    int n = sizeof(PROGRAMS) / sizeof(PROGRAMS[0]);
+    std::cout << std::left << std::setw(26) << "mean" << std::right << std::setw(14)
+              << total[INTERPRETED] / n << std::setw(14) << total[BLOCKS] / n << std::setw(14)
+              << total[JIT] / n << std::endl;
+    return 0;
+}
@@ -0,0 +1,75 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include "definitions.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+    /*  Write a 32kB, MBC-less ROM to a temporary file and return its path. The program at 0x150
+        is an endless loop of loads, stores and stack operations on WRAM and HRAM, so it stresses
+        instruction fetch and the memory bus without depending on any video or timer state.
+        Each iteration of the loop executes 17 instructions.
+    */
+    inline std::string write_synthetic_rom()
+    {
+        std::vector<u8> rom(0x8000, 0);
+        // Entry point: jp 0x150
+        rom[0x100] = 0xc3; rom[0x101] = 0x50; rom[0x102] = 0x01;
+        const char title[] = "BENCH";
+        std::copy(title, title + sizeof(title) - 1, rom.begin() + 0x134);
+        rom[0x147] = 0x00; // no MBC
+        rom[0x148] = 0x00; // 2 ROM banks
+        rom[0x149] = 0x00; // no RAM
+
+        const std::vector<u8> program = {
+            0x31, 0xfe, 0xdf,   // ld sp, 0xdffe
+            0x21, 0x00, 0xc0,   // ld hl, 0xc000
+        // loop:
+            0x7e,               // ld a, (hl)
+            0x3c,               // inc a
+            0x22,               // ld (hl+), a
+            0x46,               // ld b, (hl)
+            0xe0, 0x80,         // ldh (0x80), a
+            0xf0, 0x81,         // ldh a, (0x81)
+            0xc5,               // push bc
+            0xd1,               // pop de
+            0x80,               // add a, b
+            0xfa, 0x00, 0xc1,   // ld a, (0xc100)
+            0xea, 0x01, 0xc1,   // ld (0xc101), a
+            0x7c,               // ld a, h
+            0xe6, 0x1f,         // and 0x1f
+            0xf6, 0xc0,         // or 0xc0
+            0x67,               // ld h, a
+            0x00,               // nop
+            0x18, 0xe6          // jr loop
+        };
+        std::copy(program.begin(), program.end(), rom.begin() + 0x150);
+
+        std::string path = "/tmp/gb_bench_synthetic.gb";
+        std::ofstream ofs(path, std::ios_base::out | std::ios_base::binary);
+        ofs.write(reinterpret_cast<const char*>(rom.data()), rom.size());
+        return path;
+    }
+
+    class Timer
+    {
+    public:
+        Timer() : start(std::chrono::steady_clock::now()) {}
+
+        double seconds() 
+        {
+            auto dt = std::chrono::steady_clock::now() - start;
+            return std::chrono::duration_cast<std::chrono::duration<double>>(dt).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point start;
+    };
+}
+
+#endif
@@ -0,0 +1,110 @@
+/*  Compares running the emulator one instruction at a time, handling events after every step as
+    the debugger does, against batched execution with Processor::run_until, with and without the
+    block cache and JIT. All run headless and unthrottled for the same number of frames. Steps per
+    frame counts instructions plus one step per stretch spent halted.
+
+    The CPU alone is then timed by cancelling every event and running straight through the same
+    number of cycles, with idle loop skipping off, which shows interpreter and JIT throughput
+    without the PPU and APU. Usage: bench_cpu_loop [rom file] [frames]
+    Intended to be run with blargg's cpu_instrs.gb. Without a ROM file, a synthetic load/store
+    heavy ROM is generated.
+*/
+#include "bench_common.h"
+#include "gameboy.h"
+#include "headless.h"
+#include <iostream>
+#include <string>
+
+namespace
+{
+    enum Mode { STEP, BATCHED, BLOCKS, JIT };
+
+    void configure(GameBoy &gb, Mode mode)
+    {
+        if (mode == STEP || mode == BATCHED) {
+            gb.cpu.attach_block_cache(nullptr);
+        }
+        if (mode != JIT) {
+            gb.cpu.attach_jit(nullptr);
+        }
+    }
+
+    double run(const std::string &rom_file, int num_frames, Mode mode, u64 &cycles, u64 &steps)
+    {
+        NullVideoSink video;
+        NullAudioSink audio;
+        GameBoy gb(RomImage::open(rom_file), &video, &audio);
+        configure(gb, mode);
+
+        bench::Timer timer;
+        if (mode != STEP) {
+            for (int i = 0; i < num_frames; i++) {
+                gb.run_frame();
+            }
+        }
+        else {
+            u64 end = (u64)num_frames * GameBoy::CYCLES_PER_FRAME;
+            while (gb.cycles() < end) {
+                gb.step();
+                steps++;
+            }
+        }
+        double t = timer.seconds();
+        cycles = gb.cycles();
+        return t;
+    }
+
+    // Emulated MHz of the CPU on its own, after the first frame
+    double cpu_only(const std::string &rom_file, int num_frames, Mode mode)
+    {
+        NullVideoSink video;
+        NullAudioSink audio;
+        GameBoy gb(RomImage::open(rom_file), &video, &audio);
+        configure(gb, mode);
+        gb.cpu.enable_idle_skip = false;
+        gb.run_frame();
+        for (int event = 0; event < Scheduler::NUM_EVENTS; event++) {
+            gb.scheduler.cancel((Scheduler::Event)event);
+        }
+
+        u64 start = gb.cycles();
+        bench::Timer timer;
+        gb.cpu.run_until(start + (u64)num_frames * GameBoy::CYCLES_PER_FRAME);
+        return (gb.cycles() - start) / timer.seconds() / 1e6;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::string rom_file = argc > 1 ? argv[1] : bench::write_synthetic_rom();
+    int num_frames = argc > 2 ? std::stoi(argv[2]) : 3000;
+
+    u64 step_cycles, batch_cycles, block_cycles, jit_cycles;
+    u64 steps = 0;
+    double step_time = run(rom_file, num_frames, STEP, step_cycles, steps);
+    double batch_time = run(rom_file, num_frames, BATCHED, batch_cycles, steps);
+    double block_time = run(rom_file, num_frames, BLOCKS, block_cycles, steps);
+    double jit_time = run(rom_file, num_frames, JIT, jit_cycles, steps);
+
+    double cpu_batched = cpu_only(rom_file, num_frames, BATCHED);
+    double cpu_blocks = cpu_only(rom_file, num_frames, BLOCKS);
+    double cpu_jit = cpu_only(rom_file, num_frames, JIT);
+
+    std::cout << "frames:              " << num_frames << "\n"
+              << "step (s):            " << step_time << "\n"
+              << "step MHz:            " << step_cycles / step_time / 1e6 << "\n"
+              << "steps per frame:     " << (double)steps / num_frames << "\n"
+              << "run_until (s):       " << batch_time << "\n"
+              << "run_until MHz:       " << batch_cycles / batch_time / 1e6 << "\n"
+              << "speedup:             "
+              << (batch_cycles / batch_time) / (step_cycles / step_time) << "\n"
+              << "block cache (s):     " << block_time << "\n"
+              << "block cache MHz:     " << block_cycles / block_time / 1e6 << "\n"
+              << "block speedup:       "
+              << (block_cycles / block_time) / (batch_cycles / batch_time) << "\n"
+              << "JIT (s):             " << jit_time << "\n"
+              << "JIT MHz:             " << jit_cycles / jit_time / 1e6 << "\n"
+              << "CPU only MHz:        " << cpu_batched << " interpreted, " << cpu_blocks
+              << " block cache, " << cpu_jit << " JIT" << std::endl;
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*  Times the interpreter's table-generated handlers one opcode at a time. Every opcode is run from
+    WRAM over many executions from the same register state, less the cost of resetting the state
+    between them, so the time left is fetch, dispatch and the handler itself.
+    Usage: bench_dispatch [iterations per opcode]
+*/
+#include "bench_common.h"
+#include "gameboy.h"
+#include "headless.h"
+#include "instructions.h"
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    const u16 CODE = 0xc000;
+
+    void reset(Processor *cpu)
+    {
+        cpu->AF.value = 0x3c00;
+        cpu->load_flags();
+        cpu->BC.value = 0xc190;
+        cpu->DE.value = 0xc1a0;
+        cpu->HL.value = 0xc1b0;
+        cpu->SP.value = 0xdff0;
+        cpu->PC.value = CODE;
+        cpu->IME_flag = false;
+        cpu->ei_count = 0;
+        cpu->halted = false;
+    }
+
+    double time_opcode(Processor *cpu, int iterations, bool execute)
+    {
+        int cycles = 0;
+        bench::Timer timer;
+        for (int i = 0; i < iterations; i++) {
+            reset(cpu);
+            if (execute) {
+                cycles += cpu->execute_next();
+            }
+        }
+        double t = timer.seconds();
+        // Keep the loop from being optimized away
+        if (cycles == -1) {
+            std::cout << cycles;
+        }
+        return t;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = argc > 1 ? std::stoi(argv[1]) : 100000;
+
+    NullVideoSink video;
+    NullAudioSink audio;
+    GameBoy gb(RomImage::open(bench::write_synthetic_rom()), &video, &audio);
+    Processor *cpu = &gb.cpu;
+
+    double reset_time = time_opcode(cpu, iterations, false);
+    double total = 0;
+
+    std::cout << "opcode  mnemonic              time (ns)" << std::endl;
+    for (int opcode = 0; opcode < instr::NUM_INSTRUCTIONS; opcode++) {
+        if (opcode == 0xcb) {
+            continue;
+        }
+        // Instruction followed by immediate operands n = 0x90, nn = 0xd090
+        if (opcode >= instr::CB_PREFIX) {
+            gb.memory.write(CODE, 0xcb);
+            gb.memory.write(CODE + 1, opcode & 0xff);
+        }
+        else {
+            gb.memory.write(CODE, opcode);
+            gb.memory.write(CODE + 1, 0x90);
+            gb.memory.write(CODE + 2, 0xd0);
+        }
+
+        double t = time_opcode(cpu, iterations, true) - reset_time;
+        total += t;
+        std::cout << std::hex << std::setfill('0') << std::setw(3) << opcode << std::dec
+                  << std::setfill(' ') << "     " << std::left << std::setw(22)
+                  << instr::table[opcode].mnemonic << std::right << std::fixed
+                  << std::setprecision(2) << std::setw(9) << t / iterations * 1e9 << std::endl;
+    }
+
+    int num_opcodes = instr::NUM_INSTRUCTIONS - 1;
+    std::cout << "mean (ns):           " << total / num_opcodes / iterations * 1e9 << std::endl;
+    return 0;
+}
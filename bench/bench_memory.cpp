@@ -0,0 +1,51 @@
+/*  Measures how many instructions per second the CPU and memory bus can execute, with the PPU 
+    and APU left idle. Usage: bench_memory [rom file] [instruction count]
+    Without a ROM file, a synthetic load/store heavy ROM is generated.
+*/
+#include "bench_common.h"
+#include "apu.h"
+#include "cartridge.h"
+#include "gpu.h"
+#include "headless.h"
+#include "interrupts.h"
+#include "joypad.h"
+#include "mmu.h"
+#include "processor.h"
+#include "scheduler.h"
+#include "timer.h"
+#include <iostream>
+#include <string>
+
+int main(int argc, char *argv[])
+{
+    std::string rom_file = argc > 1 ? argv[1] : bench::write_synthetic_rom();
+    long long num_instr = argc > 2 ? std::stoll(argv[2]) : 50000000LL;
+
+    // Events are never handled, so the PPU, APU and timer stay idle
+    Scheduler scheduler;
+    Joypad pad;
+    Interrupts interrupts;
+    Timer timer(&interrupts, &scheduler);
+    Cartridge cart(rom_file);
+    NullAudioSink audio;
+    NullVideoSink video;
+    APU apu(&scheduler, &audio);
+    GPU gpu(&interrupts, &scheduler, &video);
+    Memory mem(&interrupts, &cart, &pad, &apu, &gpu, &timer);
+    Processor cpu(&interrupts, &mem, &scheduler);
+    cpu.init_state();
+
+    long long cycles = 0;
+    bench::Timer bench_timer;
+    for (long long i = 0; i < num_instr; i++) {
+        cycles += cpu.step();
+    }
+    double t = bench_timer.seconds();
+
+    std::cout << "instructions:        " << num_instr << "\n"
+              << "emulated cycles:     " << cycles << "\n"
+              << "time (s):            " << t << "\n"
+              << "instructions/s:      " << num_instr / t << "\n"
+              << "emulated MHz:        " << cycles / t / 1e6 << std::endl;
+    return 0;
+}
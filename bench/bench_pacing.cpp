@@ -0,0 +1,75 @@
+/*  Frame pacing accuracy. Each frame spins for a random 2-10ms, standing in for emulation, then
+    waits for its deadline, once with the throttle the frontend used to have (57 fps counted
+    from each frame_drawn, sleeping whole milliseconds) and once with Pacer keyed to emulated
+    cycles. Shows the mean frame time against the real 16.743ms, and percentiles of how far each
+    frame strayed from it. Usage: bench_pacing [frames]
+*/
+#include "pacer.h"
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+
+using namespace std::chrono;
+
+namespace
+{
+    const u64 CYCLES_PER_FRAME = 70224;
+
+    Pacer::Jitter run(int num_frames, std::function<void(u64)> wait)
+    {
+        std::mt19937 rng(1);
+        std::vector<double> frame_ms, ideal_ms;
+        u64 cycles = 0;
+        auto last = steady_clock::now();
+        for (int frame = 0; frame < num_frames; frame++) {
+            auto busy_until = steady_clock::now() + microseconds(2000 + rng() % 8000);
+            while (steady_clock::now() < busy_until) {}
+            cycles += CYCLES_PER_FRAME;
+            wait(cycles);
+
+            auto now = steady_clock::now();
+            frame_ms.push_back(duration<double, std::milli>(now - last).count());
+            ideal_ms.push_back(1000 / Pacer::FRAME_RATE);
+            last = now;
+        }
+        return Pacer::summarize(frame_ms, ideal_ms);
+    }
+
+    void print_row(const std::string &name, const Pacer::Jitter &jitter)
+    {
+        std::cout << std::left << std::setw(20) << name << std::right << std::setw(10)
+                  << jitter.mean_frame_ms << std::setw(10) << jitter.p50 << std::setw(10)
+                  << jitter.p90 << std::setw(10) << jitter.p99 << std::setw(10) << jitter.max
+                  << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_frames = argc > 1 ? std::stoi(argv[1]) : 300;
+
+    std::cout << "frames: " << num_frames << "\n"
+              << std::left << std::setw(20) << "throttle" << std::right << std::setw(10)
+              << "mean" << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10)
+              << "p99" << std::setw(10) << "max" << "   (ms)\n"
+              << std::fixed << std::setprecision(3);
+
+    duration<double> frame_time(1.0 / 57);
+    auto t = steady_clock::now();
+    print_row("57 fps, sleep_for", run(num_frames, [&](u64) {
+        auto dt = steady_clock::now() - t;
+        if (dt < frame_time) {
+            std::this_thread::sleep_for(duration_cast<milliseconds>(frame_time - dt));
+        }
+        t = steady_clock::now();
+    }));
+
+    Pacer pacer;
+    pacer.wait(0);
+    print_row("Pacer", run(num_frames, [&](u64 cycles) { pacer.wait(cycles); }));
+    return 0;
+}
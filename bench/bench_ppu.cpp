@@ -0,0 +1,120 @@
+/*  Times the PPU drawing scanlines on its own, driven straight from its mode change events. VRAM
+    is filled with random tiles and tile maps, the window covers the lower right of the screen
+    and all 40 sprites are visible, so every line draws background, window and 10 sprites. Once
+    with VRAM left alone, where every line is copied from the pre-rendered background cache, once
+    scrolling the background a pixel each way every frame, and once with all tile data rewritten 
+    before every frame, so each tile drawn has to be decoded and rendered into the background 
+    again first. All are timed with each of the compositors the CPU supports, then with every line
+    drawn a dot at a time by the pixel FIFO, which is otherwise only used for lines with registers
+    written during mode 3. The background cache hit rate of each is shown last. 
+    Usage: bench_ppu [frames]
+*/
+#include "bench_common.h"
+#include "gpu.h"
+#include "headless.h"
+#include "registers.h"
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace
+{
+    const int LINES_PER_FRAME = 144;
+
+    void setup(GPU &gpu, std::mt19937 &rng)
+    {
+        // Display is off, so all of VRAM and OAM can be written
+        for (u16 addr = 0x8000; addr < 0xa000; addr++) {
+            gpu.write(addr, rng());
+        }
+        for (int i = 0; i < 40; i++) {
+            // 4 rows of 10 sprites, with every combination of flips and palette
+            gpu.write(0xfe00 + 4*i, 16 + 16 * (i / 10) + 40);
+            gpu.write(0xfe01 + 4*i, 8 + 12 * (i % 10));
+            gpu.write(0xfe02 + 4*i, rng());
+            gpu.write(0xfe03 + 4*i, (i & 1) << 5 | (i & 2) << 5 | (i & 4) << 2);
+        }
+        gpu.write(reg::SCROLLX, 3);
+        gpu.write(reg::SCROLLY, 5);
+        gpu.write(reg::WX, 87);
+        gpu.write(reg::WY, 72);
+        gpu.write(reg::BGP, 0xe4);
+        gpu.write(reg::OBP0, 0xd2);
+        gpu.write(reg::OBP1, 0x1b);
+        // Display, window, sprites and background on, 8x16 sprites
+        gpu.write(reg::LCDC, 0xe7);
+    }
+
+    const char *ISA_NAMES[] = {"scalar", "SSE2", "AVX2"};
+
+    enum Scene { STATIC, SCROLLED, TILES_REWRITTEN, NUM_SCENES };
+
+    // Of the background cache, from the last run of each scene
+    double hit_rate[NUM_SCENES];
+
+    double scanlines_per_second(int num_frames, Scene scene, scanline::Isa compositor, 
+        bool always_fifo = false)
+    {
+        std::mt19937 rng(1);
+        Interrupts interrupts;
+        Scheduler scheduler;
+        NullVideoSink video;
+        GPU gpu(&interrupts, &scheduler, &video);
+        gpu.compositor = compositor;
+        gpu.always_fifo = always_fifo;
+        setup(gpu, rng);
+
+        bench::Timer timer;
+        for (int frame = 0; frame < num_frames; frame++) {
+            gpu.frame_drawn = false;
+            while (!gpu.frame_drawn) {
+                scheduler.now = scheduler.next_deadline();
+                scheduler.pop_due();
+                gpu.update_mode();
+            }
+            if (scene == SCROLLED) {
+                gpu.write(reg::SCROLLX, gpu.read(reg::SCROLLX) + 1);
+                gpu.write(reg::SCROLLY, gpu.read(reg::SCROLLY) + 1);
+            }
+            else if (scene == TILES_REWRITTEN) {
+                // In vertical blank, so VRAM is accessible
+                for (u16 addr = 0x8000; addr < 0x9800; addr++) {
+                    gpu.write(addr, addr + frame);
+                }
+            }
+        }
+        double seconds = timer.seconds();
+        hit_rate[scene] = (double)gpu.bg_cache_hits / (gpu.bg_cache_hits + gpu.bg_cache_misses);
+        return (double)num_frames * LINES_PER_FRAME / seconds;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_frames = argc > 1 ? std::stoi(argv[1]) : 2000;
+
+    std::cout << "frames: " << num_frames << "\n"
+              << std::left << std::setw(12) << "compositor" << std::right << std::setw(16)
+              << "static VRAM" << std::setw(12) << "scrolled" << std::setw(20) 
+              << "tiles rewritten" << "   (scanlines/s)\n" << std::fixed << std::setprecision(0);
+    auto print_row = [num_frames](const char *name, scanline::Isa isa, bool always_fifo) {
+        std::cout << std::left << std::setw(12) << name << std::right 
+                  << std::setw(16) << scanlines_per_second(num_frames, STATIC, isa, always_fifo) 
+                  << std::setw(12) << scanlines_per_second(num_frames, SCROLLED, isa, always_fifo)
+                  << std::setw(20) 
+                  << scanlines_per_second(num_frames, TILES_REWRITTEN, isa, always_fifo) 
+                  << std::endl;
+    };
+    for (int isa = scanline::SCALAR; isa <= scanline::detect(); isa++) {
+        print_row(ISA_NAMES[isa], (scanline::Isa)isa, false);
+    }
+    // The FIFO doesn't use the background cache, so the hit rates are from the last compositor
+    std::cout << std::left << std::setw(12) << "bg hit rate" << std::right << std::setprecision(1)
+              << std::setw(15) << 100 * hit_rate[STATIC] << "%" 
+              << std::setw(11) << 100 * hit_rate[SCROLLED] << "%" 
+              << std::setw(19) << 100 * hit_rate[TILES_REWRITTEN] << "%" << std::endl
+              << std::setprecision(0);
+    print_row("pixel FIFO", scanline::detect(), true);
+    return 0;
+}
@@ -0,0 +1,121 @@
+/*  Measures cartridge load time and resident memory per emulator instance for three ways of 
+    getting the ROM into memory:
+        copy   - every instance reads the file into its own buffer
+        mmap   - every instance maps the file itself
+        shared - one mapped RomImage is handed to every instance
+    Usage: bench_rom_load [rom file] [instances]
+    Without a ROM file, an 8MB MBC5 ROM is generated.
+*/
+#include "bench_common.h"
+#include "cartridge.h"
+#include "rom_image.h"
+#include "util.h"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+struct MemoryUsage
+{
+    // In kB
+    long resident;
+    long shared;
+};
+
+MemoryUsage memory_usage()
+{
+    long pages_total = 0, pages_resident = 0, pages_shared = 0;
+    std::ifstream statm("/proc/self/statm");
+    statm >> pages_total >> pages_resident >> pages_shared;
+    long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+    return {pages_resident * page_kb, pages_shared * page_kb};
+}
+
+std::string write_large_rom()
+{
+    // 512 banks of 16kB, every byte holding its bank number
+    std::vector<u8> rom(512 * 0x4000);
+    for (size_t i = 0; i < rom.size(); i++) {
+        rom[i] = (i / 0x4000) & 0xff;
+    }
+    rom[0x147] = 0x19; // MBC5
+    rom[0x148] = 0x08; // 8MB
+    rom[0x149] = 0x00;
+    std::string path = "/tmp/gb_bench_large.gb";
+    std::ofstream ofs(path, std::ios_base::out | std::ios_base::binary);
+    ofs.write(reinterpret_cast<const char*>(rom.data()), rom.size());
+    return path;
+}
+
+// Read one byte from every page of every bank, so the whole ROM is resident
+long touch_rom(Cartridge &cart, int num_banks)
+{
+    long sum = 0;
+    for (int bank = 0; bank < num_banks; bank++) {
+        cart.write(0x2000, bank & 0xff);
+        cart.write(0x3000, bank >> 8);
+        for (int addr = 0x4000; addr < 0x8000; addr += 0x100) {
+            sum += cart.read(addr);
+        }
+    }
+    return sum;
+}
+
+template <typename Loader>
+void run(const std::string &name, int instances, int num_banks, Loader load)
+{
+    MemoryUsage before = memory_usage();
+    std::vector<std::unique_ptr<Cartridge>> carts;
+
+    bench::Timer timer;
+    for (int i = 0; i < instances; i++) {
+        carts.emplace_back(new Cartridge(load()));
+    }
+    double t = timer.seconds();
+
+    long checksum = 0;
+    for (auto &cart: carts) {
+        checksum += touch_rom(*cart, num_banks);
+    }
+    MemoryUsage after = memory_usage();
+    long resident = after.resident - before.resident;
+    long shared = after.shared - before.shared;
+
+    std::cout << name << ":\n"
+              << "    load time per instance (us):     " << 1e6 * t / instances << "\n"
+              << "    resident per instance (kB):      " << resident / instances << "\n"
+              << "    private resident per instance:   " << (resident - shared) / instances << "\n"
+              << "    (checksum " << checksum << ")" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string rom_file = argc > 1 ? argv[1] : write_large_rom();
+    int instances = argc > 2 ? std::stoi(argv[2]) : 32;
+    int num_banks = RomImage::open(rom_file)->size() / RomImage::BANK_SIZE;
+
+    std::cout << "ROM: " << rom_file << ", " << num_banks << " banks, " << instances 
+              << " instances" << std::endl;
+
+    {
+        // Previous loader, reading one byte at a time through an istream_iterator
+        bench::Timer timer;
+        std::ifstream ifs(rom_file, std::ios_base::in | std::ios_base::binary);
+        ifs.unsetf(std::ios_base::skipws);
+        std::vector<u8> rom((std::istream_iterator<u8>(ifs)), std::istream_iterator<u8>());
+        std::cout << "istream_iterator load (us):          " << 1e6 * timer.seconds() << "\n";
+    }
+
+    std::shared_ptr<const RomImage> shared_rom = RomImage::open(rom_file);
+    run("shared", instances, num_banks, [&]() { return shared_rom; });
+    run("mmap", instances, num_banks, [&]() { return RomImage::open(rom_file); });
+    run("copy", instances, num_banks, [&]() {
+        std::vector<u8> rom;
+        utils::load_file(rom, rom_file);
+        return RomImage::from_data(rom);
+    });
+    return 0;
+}
@@ -3,9 +3,9 @@
 
 #include "definitions.h"
 #include "audio_buffer.h"
+#include "audio_sink.h"
+#include "scheduler.h"
 #include <vector>
-#include <SDL2/SDL.h>
-#include <SDL2/SDL_audio.h>
 #include <map>
 #include <vector>
 #include <iterator>
@@ -14,10 +14,14 @@ class APU
 {
 public:
 
-    APU();
-    ~APU();
+    /*  Samples are passed to the sink each time the buffer is flushed. Sound generation runs 
+        lazily, catching up to the current time whenever registers are accessed, the frame 
+        sequencer event fires or the buffer is flushed
+    */
+    APU(Scheduler *sched, AudioSink *sink);
 
-    void step(int cycles);
+    // Handle APU_FRAME_SEQUENCER event - clock length counters, frequency sweep and envelopes
+    void step_frame_sequencer();
 
     void start();
 
@@ -25,7 +29,7 @@ public:
     
     void write(u16 addr, u8 data);
 
-    // Pass samples to SDL and return number of queued samples 
+    // Pass samples to the audio sink and return number of queued samples 
     int flush_buffer();
 
 private:
@@ -77,14 +81,14 @@ private:
     std::vector<u8> wave_pattern_RAM;
     std::map<u16, bool> unused_addr;
 
-    unsigned int clock;
-    unsigned int frame_clock;
-    unsigned int audio_sampling_clock;
+    // Time sound generation has been run up to
+    u64 clock;
+    u64 next_frame_step;
     unsigned int frame_step;
     unsigned int wave_RAM_pos;
 
-    SDL_AudioDeviceID device_id;
-    SDL_AudioSpec spec;
+    Scheduler *scheduler;
+    AudioSink *audio_sink;
 
     AudioBuffer right_channel_buffer;
     AudioBuffer left_channel_buffer;
@@ -95,13 +99,15 @@ private:
 
     void reset();
 
+    // Run sound generation up to the given time
+    void catch_up(u64 time);
+
     void clock_waveform_generators();
     void clock_length_counters();
     void clock_freq_sweep();
     void clock_vol_envelope();
 
     void init_registers();
-    void setup_sdl();
 
     void update_status();
     void update_reg_NRx0(int channel, u8 data);
@@ -0,0 +1,22 @@
+#ifndef AUDIO_SINK_H
+#define AUDIO_SINK_H
+
+#include "definitions.h"
+
+/*  Receives audio from the APU as interleaved left/right 16-bit samples at 48kHz
+*/
+class AudioSink
+{
+public:
+    virtual ~AudioSink() {}
+
+    // Begin playback
+    virtual void start() {}
+
+    // Queue num_frames left/right sample pairs, return the number of pairs still waiting to play
+    virtual int queue_samples(const i16 *samples, int num_frames) = 0;
+
+    static const int SAMPLE_RATE = 48000;
+};
+
+#endif
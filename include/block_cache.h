@@ -0,0 +1,121 @@
+#ifndef BLOCK_CACHE_H
+#define BLOCK_CACHE_H
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "definitions.h"
+
+class Memory;
+class Processor;
+
+// Instruction handler, given any immediate operand in imm
+typedef int (*BlockHandler)(Processor *cpu, u16 imm);
+// Run of instructions compiled by the JIT, which also advances the clock and PC past them
+typedef void (*NativeCode)(Processor *cpu);
+
+struct DecodedInstruction
+{
+    BlockHandler handler;
+    u16 imm;
+    // Address of the following instruction, which PC is set to before running the handler
+    u16 next_pc;
+    // May write memory, and so schedule events, raise interrupts or invalidate code
+    bool writes_memory;
+    u16 opcode;
+};
+
+struct NativeRun
+{
+    NativeCode code;
+    // Index of the first instruction replaced, and the number replaced
+    u16 first;
+    u16 count;
+    // Machine cycles taken by every instruction in the run before the last
+    int cycles_before_last;
+    bool writes_memory;
+    // Whether F has to be up to date on entry, and whether the run leaves new flags in it
+    bool reads_flags;
+    bool writes_flags;
+};
+
+/*  A straight-line run of decoded instructions, ending after a jump, call, return, HALT, STOP or
+    EI, or at the end of its 256-byte page. Every instruction before the last has fixed timing
+*/
+struct Block
+{
+    u16 start;
+    // Address of the last instruction, and of the instruction following it
+    u16 last;
+    u16 end;
+    // Static target of a JP, JR, CALL or RST ending the block, or NO_TARGET
+    u32 target;
+    // Machine cycles taken by every instruction before the last
+    int cycles_before_last;
+    std::vector<DecodedInstruction> instrs;
+
+    // Blocks chained on the fall through and the branch target, only within the same page
+    Block *next_fall_through;
+    Block *next_target;
+
+    // Times run, until compiled by the JIT, and the compiled runs in order
+    u32 executions;
+    std::vector<NativeRun> native_runs;
+
+    static const u32 NO_TARGET = 0x10000;
+};
+
+/*  Decoded blocks of code in ROM, WRAM and HRAM. Code is partitioned by 256-byte page, keyed by
+    both the CPU page and the host memory mapped into it, so every ROM bank (or the boot ROM) has
+    its own blocks and switching banks just selects a different partition.
+
+    ROM can't be written. Pages of WRAM and HRAM holding blocks are write-protected by the MMU,
+    and writing to one drops every block in the page. Any invalidation or change to the cartridge
+    mapping bumps generation, so the CPU can stop running a block that may be stale.
+*/
+class BlockCache
+{
+public:
+    BlockCache(Memory *mem);
+
+    // Block starting at addr, decoded on first use. Null if code at addr can't be cached
+    Block *lookup(u16 addr);
+    // Block to run after block, when execution continued at addr
+    Block *successor(Block *block, u16 addr);
+
+    // Called by the MMU on writes to a protected page, and when cartridge banks are remapped
+    void invalidate(u16 addr);
+    void remap();
+
+    u64 generation;
+
+    u64 blocks_built;
+    u64 invalidations;
+
+    static const int MAX_BLOCK_SIZE = 64;
+
+private:
+    struct CodePage
+    {
+        const u8 *mem;
+        bool stale;
+        Block *blocks[0x100];
+        std::vector<std::unique_ptr<Block>> storage;
+    };
+
+    CodePage *code_page(u16 addr);
+    Block *build(CodePage *page, u16 addr);
+    void clear(CodePage *page);
+
+    Memory *memory;
+
+    std::map<std::pair<int, const u8*>, std::unique_ptr<CodePage>> pages;
+    // Partition last used for each CPU page
+    const u8 *last_mem[0x100];
+    CodePage *last_page[0x100];
+    // Partitions in WRAM and HRAM, which may be invalidated
+    std::vector<CodePage*> ram_pages;
+};
+
+#endif
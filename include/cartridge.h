@@ -1,9 +1,12 @@
 #ifndef CARTRIDGE_H
 #define CARTRIDGE_H
 
+#include <memory>
 #include <string>
 #include <vector>
 #include "definitions.h"
+#include "mbc.h"
+#include "rom_image.h"
 
 typedef std::vector<u8>::iterator mem_iter;
 
@@ -20,9 +23,20 @@ public:
     };
 
     Cartridge(std::string rom_filename); 
+    // Share an already loaded ROM between any number of cartridges
+    Cartridge(std::shared_ptr<const RomImage> rom);
 
     u8 read(u16 addr);
-    void write(u16 addr, u8 data);
+    // Returns whether the write switched any of the banks below
+    bool write(u16 addr, u8 data);
+
+    /*  Host pointers to the currently selected banks, which the MMU maps directly into its page 
+        table. Only change on writes to 0x0000 - 0x7fff. sram_base is nullptr when cartridge RAM 
+        isn't plain memory, and must be accessed through read/write
+    */
+    const u8 *rom0_base() { return controller->rom0_base; }
+    const u8 *romx_base() { return controller->romx_base; }
+    u8 *sram_base() { return controller->sram_base; }
 
     MBCType mbc;
     std::string title;
@@ -32,39 +46,17 @@ public:
     int num_ram_banks;
     
 private:
-    // Specific MBC type read/write implementations
-    u8 none_read(u16 addr);
-    u8 mbc1_read(u16 addr);
-    u8 mbc2_read(u16 addr);
-    u8 mbc3_read(u16 addr);
-    u8 mbc5_read(u16 addr);
-
-    void none_write(u16 addr, u8 data);
-    void mbc1_write(u16 addr, u8 data);
-    void mbc2_write(u16 addr, u8 data);
-    void mbc3_write(u16 addr, u8 data);
-    void mbc5_write(u16 addr, u8 data);
-
     // Initialization functions
     void read_header();
     void set_type(u8 val);
 
-    bool mode;
-    bool enable_ram;
-    bool enable_rtc;
-
     const int rom_bank_size;
     const int ram_bank_size;
-    int current_rom_bank;
-    int current_ram_bank;
-    int current_rtc;
 
-    std::vector<u8> read_only_mem;
+    std::shared_ptr<const RomImage> rom_image;
     std::vector<u8> random_access_mem;
-    std::vector<u8> clock_registers;
 
-    u8 mask_ignore_bits;
-    
+    std::unique_ptr<MemoryBankController> controller;
 };
 
-#endif
\ No newline at end of file
+#endif
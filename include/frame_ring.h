@@ -0,0 +1,77 @@
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include "definitions.h"
+#include <atomic>
+#include <vector>
+
+// A finished frame, as drawn by the GPU
+struct Frame
+{
+    // Frames started since power on before this one, counting those that weren't drawn
+    u64 number;
+    // Cycles since power on when the frame was finished
+    u64 cycles;
+    // One byte per pixel holding the shade (0 - 3) after palette lookup, top row first
+    const u8 *pixels;
+};
+
+/*  Frames for the GPU to draw into, allocated once. Consumers (the display, a recorder, anything
+    exporting observations) borrow finished frames in place, from any thread, and release them
+    when done. The GPU never draws into a borrowed frame, or the latest, so a borrowed frame
+    doesn't change until it's released. Borrowing and releasing only touch an atomic count per
+    slot, so neither side ever waits.
+
+    A frame started while consumers hold on to every other slot is drawn into a spare that is
+    never published, and is dropped.
+*/
+class FrameRing
+{
+public:
+    FrameRing(int width, int height);
+
+    // Producer side, the GPU. Row y of the frame being drawn
+    u8 *draw_row(int y) { return &pixels[drawing][y * width]; }
+    /*  Finish the frame being drawn and start another. Returns the finished frame, or nullptr if
+        it was drawn into the spare and dropped
+    */
+    const Frame *publish(u64 number, u64 cycles);
+
+    /*  Consumer side. Borrow the most recently finished frame, or get nullptr if there hasn't been
+        one yet. Must be released
+    */
+    const Frame *borrow_latest();
+    /*  Borrow a particular frame, to keep one passed to VideoSink::draw_frame past the call. Only
+        valid for a frame that is already borrowed or is still the latest
+    */
+    void borrow(const Frame *frame);
+    void release(const Frame *frame);
+
+    const int width;
+    const int height;
+
+    // Frames finished while every slot was borrowed. Only read by the producer
+    u64 frames_dropped;
+
+    static const int NUM_SLOTS = 4;
+
+private:
+    // The last slot is the spare, never published or borrowed
+    static const int SPARE = NUM_SLOTS;
+    // Slot state while the GPU draws into it, otherwise the number of borrows
+    static const int DRAWING = -1;
+
+    Frame frames[NUM_SLOTS + 1];
+    std::vector<u8> pixels[NUM_SLOTS + 1];
+    std::atomic<int> state[NUM_SLOTS + 1];
+
+    int drawing;
+    // Slot of the most recently finished frame, -1 before the first
+    std::atomic<int> latest;
+
+    int slot(const Frame *frame) const { return (int)(frame - frames); }
+    // Claim a slot that isn't borrowed or the latest to draw into, or the spare
+    int claim_slot();
+};
+
+#endif
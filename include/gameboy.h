@@ -0,0 +1,67 @@
+#ifndef GAMEBOY_H
+#define GAMEBOY_H
+
+#include <memory>
+#include <string>
+#include "definitions.h"
+#include "apu.h"
+#include "block_cache.h"
+#include "cartridge.h"
+#include "gpu.h"
+#include "interrupts.h"
+#include "joypad.h"
+#include "mmu.h"
+#include "processor.h"
+#include "rom_image.h"
+#include "scheduler.h"
+#include "timer.h"
+
+/*  A complete emulator instance, owning and wiring together every component. Instances share no
+    state beyond the (immutable) ROM image, so any number may run in parallel on separate threads.
+*/
+class GameBoy
+{
+public:
+    // If boot_rom_path is empty, the CPU starts at 0x100 in the post-boot state
+    GameBoy(std::shared_ptr<const RomImage> rom, VideoSink *video, AudioSink *audio,
+        const std::string &boot_rom_path = "");
+
+    // Execute a single instruction and handle any events that became due. Returns cycles taken
+    int step(bool print = false);
+
+    /*  Run until the next frame is drawn and flush audio, returning the sample frames still queued
+        for playback. With the display disabled no frame is ever drawn, so this also returns after
+        one frame's worth of cycles
+    */
+    int run_frame();
+
+    // Cycles emulated since power on
+    u64 cycles() const { return scheduler.now; }
+
+    // Cycles fast-forwarded through guest idle loops during the last run_frame
+    u64 idle_cycles_last_frame;
+
+    // Cycles in one frame - 154 lines of 456 cycles
+    static const int CYCLES_PER_FRAME;
+
+    // Declared in construction order
+    Scheduler scheduler;
+    Joypad joypad;
+    Interrupts interrupts;
+    Timer timer;
+    Cartridge cartridge;
+    APU apu;
+    GPU gpu;
+    Memory memory;
+    BlockCache block_cache;
+    Processor cpu;
+    Jit jit;
+
+private:
+    // Run the handlers of all events due at or before the current time
+    void handle_events();
+
+    bool frame_budget_done;
+};
+
+#endif
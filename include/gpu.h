@@ -4,26 +4,51 @@
 #include <vector>
 #include <map>
 #include "definitions.h"
-#include "window.h"
+#include "frame_ring.h"
+#include "video_sink.h"
 #include "interrupts.h"
+#include "scheduler.h"
+#include "scanline.h"
+#include "pixel_fifo.h"
+
+class Memory;
 
 class GPU 
 {
+    friend class PixelFifo;
+
 public:
-    /*  The interrupts object is shared with the cpu and memory, GPU triggers the window to 
-        draw once per frame, once full frame is drawn and vertical blank mode is entered
+    /*  The interrupts object is shared with the cpu and memory, GPU passes the frame to the video
+        sink once per frame, once full frame is drawn and vertical blank mode is entered
     */
-    GPU(Interrupts *inter, GameWindow *win);
+    GPU(Interrupts *inter, Scheduler *sched, VideoSink *sink);
 
-    // Advance GPU by the given number of CPU cycles 
-    void step(unsigned int cpu_cycles);
+    /*  Handle PPU_MODE event - move to the next mode, drawing the scanline at the end of mode 3.
+        Lines are drawn all at once at the end of mode 3 with the registers as they are then,
+        unless a register that affects drawing is written during mode 3. From then on, the line 
+        is drawn by a pixel FIFO, kept up to date with every such write, and mode 3 lasts as long
+        as the FIFO takes to finish the line
+    */
+    void update_mode();
 
     // Access VRAM, OAM and GPU registers
     u8 read(u16 addr);
     void write(u16 addr, u8 data);
 
-    // Initiate DMA transfer. Copies 160 bytes from src to OAM (sprite table)
+    /*  Initiate DMA transfer. Copies 160 bytes from src to OAM (sprite table). The copy is done 
+        immediately, but OAM stays inaccessible to the CPU until the DMA_END event
+    */
     void dma_transfer(std::vector<u8>::iterator src);
+    // Handle DMA_END event
+    void end_dma();
+
+    /*  The MMU maps VRAM directly into its page table while the CPU is allowed to access it, and 
+        is notified whenever that changes (mode 3 entered/left or display toggled)
+    */
+    void attach_memory(Memory *mem);
+    void attach_video_sink(VideoSink *sink);
+    bool vram_accessible();
+    u8 *vram_data();
 
     // 160 x 144
     static const int LCD_WIDTH;
@@ -31,6 +56,35 @@ public:
 
     // Flag used controlling timing between frames, must be reset externally
     bool frame_drawn;
+
+    // Instruction set used to put each line through the background palette. Defaults to the best
+    // the CPU supports
+    scanline::Isa compositor;
+
+    // Draw every line with the pixel FIFO, not just lines with registers written in mode 3
+    bool always_fifo;
+
+    /*  Which frames are drawn and passed to the video sink. The rest still go through every mode 
+        with the same timing, interrupts and VRAM/OAM blocking, but lines aren't drawn unless the 
+        pixel FIFO is needed to time mode 3, and the sink isn't called
+    */
+    enum RenderPolicy { RENDER_ALWAYS, RENDER_EVERY_NTH, RENDER_ON_REQUEST, RENDER_NEVER };
+    /*  With RENDER_EVERY_NTH, the last of every interval frames is drawn. Applies from the current
+        frame on, lines of it already drawn or skipped stay that way
+    */
+    void set_render_policy(RenderPolicy policy, int interval = 1);
+    // Draw the next frame to start, with RENDER_EVERY_NTH or RENDER_ON_REQUEST. Reset once it has
+    bool render_requested;
+
+    // Background and window tiles drawn from the background cache, and those rendered into it first
+    u64 bg_cache_hits;
+    u64 bg_cache_misses;
+
+    /*  Frames are drawn into here, and each one drawn is published to it when vertical blank
+        starts, numbered and stamped with the cycle count. Consumers that need a frame past the
+        video sink's draw_frame call borrow it from here instead of copying it
+    */
+    FrameRing frames;
     
 private:
     /*  Four modes the GPU cycles through. Each scanline starts in mode 2, in which OAM is being
@@ -41,7 +95,7 @@ private:
         additional scanlines.
 
         The exact timing between OAM and VRAM modes varies per scanline depending on a number of 
-        factors, but is treated as a constant here.
+        factors, but is treated as a constant here except on lines drawn by the pixel FIFO.
     */
     enum Mode { HBLANK, VBLANK, OAM, VRAM };
 
@@ -58,25 +112,48 @@ private:
         bool signed_tile_map;
     } LCD_control;
 
-    int clock;
     int line;
     Mode mode;
+    // Time of the next mode transition
+    u64 next_mode_change;
+    // Time mode 3 of the current line started
+    u64 mode_3_start;
+
+    PixelFifo fifo;
+    // Whether the current line is being drawn by the FIFO
+    bool fifo_line;
+    RenderPolicy render_policy;
+    int render_interval;
+    // Whether the current frame is drawn, and the number of frames started before it
+    bool render_frame;
+    u64 frame_count;
+    bool dma_active;
 
     // Used to trigger LCDSTAT interrupt
     bool stat_irq_signal; 
 
-    GameWindow *window;
+    VideoSink *display;
     Interrupts *interrupts;
+    Scheduler *scheduler;
+    Memory *memory;
 
-    // Data passed to window to be drawn to texture 
-    std::vector<u8> screen_texture;
-    // True for color 0 on window/bg - used when sprite drawn in background
-    std::vector<std::vector<u8>> transparent;
+    // Whether VRAM was accessible by the CPU the last time the MMU was notified
+    bool vram_mapped;
+
+    // Color indices of the background and window on the current line
+    std::vector<u8> line_colors;
+    // Pixels of the current line where background or window isn't color 0, which hides sprites 
+    // drawn behind the background
+    scanline::Mask bg_opaque;
 
     // VRAM, addresses 0x8000 - 0x9fff (8kB)
     std::vector<u8> video_RAM;
     // object attribute memory (OAM), addresses 0xfe00 - 0xfe90 (160 bytes = 40 sprites)
     std::vector<u8> sprite_attribute_table;
+    /*  Sprites covering each line, bit i set for sprite i, leaving out sprites hidden by their x
+        coordinate. Updated whenever OAM is written or the sprite height changes
+    */
+    std::vector<u64> line_sprites;
 
     // Video control registers - addresses 0xff40 - 0xff4b
     std::map<u16, u8> registers;
@@ -85,25 +162,78 @@ private:
     u8 bg_palette[4];
     u8 sprite_palette[2][4];
 
-    void draw_pixel(int x, int y, int color);
-    
     void draw_scanline();
     void draw_background();
     void draw_sprites();
     void draw_window();
+    // Sprites drawn on the current line, highest priority first. Returns the number of sprites
+    int select_sprites(int sprites[]);
+    // The pixels of a sprite on the current line, with flips applied
+    const u8 *sprite_row(int sprite);
+    // Run the FIFO up to the current time, starting it first if the line isn't using it yet
+    void run_fifo();
+    // Decide whether the frame starting now is drawn
+    void start_frame();
+    // Publish the frame drawn and pass it to the video sink
+    void finish_frame();
+    /*  While the display is off, the GPU stays at the start of line 0 in mode 0 and VRAM and OAM 
+        are accessible. The only event is one per frame's worth of cycles, setting frame_drawn
+    */
+    void turn_display_off();
+    void turn_display_on();
     void change_mode(Mode m);
+    static int mode_duration(Mode m);
     void increment_line();
     void update_color_palettes();
     void update_STAT_register();
     void update_LCD_control(u8 byte);
+    void update_vram_access();
+    void update_line_sprites(int sprite);
+    void update_all_line_sprites();
 
-    // Retrieve pixel data from a tile stored in VRAM 
-    u8 read_pixel(std::vector<u8>::iterator &tile_data, int x, int y, bool invert_y, bool invert_x);
+    /*  Tiles in VRAM (384 of 16 bytes each, from 0x8000) decoded to one color index per pixel, 
+        both as stored and flipped horizontally for sprites. Writing tile data marks the tile 
+        dirty, and it's decoded again the next time it's drawn
+    */
+    std::vector<u8> tile_cache;
+    std::vector<bool> tile_dirty;
+
+    // The 8 color indices of row y of a tile
+    const u8 *tile_row(int tile, int y, bool flip_x);
+    void decode_tile(int tile);
+    // Tile number of a background or window tile map entry, for the selected tile data
+    int bg_tile(u8 index);
+    // Start of a screen line in the frame being drawn
+    u8 *screen_row(int y) { return frames.draw_row(y); }
+
+    /*  Each tile map rendered to a 256 x 256 background of color indices, for both kinds of tile 
+        data addressing. Cells (one tile in the map) are marked dirty when their tile map entry is 
+        written or the tile it refers to has changed, and rendered again the next time a line 
+        needs them. Tile data writes are only recorded per tile when made, and the cells referring 
+        to them looked up the next time any line is drawn
+    */
+    std::vector<u8> bg_cache;
+    // One bit per cell, 32 to a row of the tile map
+    std::vector<u32> bg_dirty;
+    // Tiles written since the backgrounds were last brought up to date, 64 per word
+    std::vector<u64> bg_changed_tiles;
+
+    /*  Row y of the background for a tile map and the current tile data addressing, with the 
+        cells covering width pixels from x (wrapping around) up to date
+    */
+    const u8 *background_row(u16 map_addr, int y, int x, int width);
+    void render_cell(int bg, int cell);
+    void mark_changed_cells();
 
     static const int BACKGROUND_DIM;
     static const int TILE_MAP_DIM;
     static const int TILE_DIM;
     static const int BYTES_PER_TILE;
+    static const int NUM_TILES;
+    static const int NUM_BACKGROUNDS;
+    static const int FRAME_CYCLES;
+    static const int NUM_SPRITES;
+    static const int MAX_SPRITES_PER_LINE;
     static const u16 TILE_MAP_0_ADDR;
     static const u16 TILE_MAP_1_ADDR;
     static const u16 TILE_DATA_0_ADDR;
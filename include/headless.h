@@ -0,0 +1,51 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "audio_sink.h"
+#include "video_sink.h"
+#include <vector>
+
+// Video and audio backends that need no display or audio device
+
+// Discards every frame
+class NullVideoSink : public VideoSink
+{
+public:
+    void draw_frame(const Frame &frame) override;
+};
+
+// Discards all audio
+class NullAudioSink : public AudioSink
+{
+public:
+    int queue_samples(const i16 *samples, int num_frames) override;
+};
+
+// Keeps a copy of the most recent frame
+class BufferVideoSink : public VideoSink
+{
+public:
+    BufferVideoSink();
+
+    void draw_frame(const Frame &frame) override;
+
+    // Same layout as passed to draw_frame - top row first
+    const std::vector<u8>& frame() const { return last_frame; }
+    long frame_count() const { return num_frames; }
+
+private:
+    std::vector<u8> last_frame;
+    long num_frames;
+};
+
+// Accumulates all audio in memory until cleared
+class BufferAudioSink : public AudioSink
+{
+public:
+    int queue_samples(const i16 *data, int num_frames) override;
+
+    // Interleaved left/right samples
+    std::vector<i16> samples;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef INPUT_MOVIE_H
+#define INPUT_MOVIE_H
+
+#include <string>
+#include <vector>
+#include "definitions.h"
+#include "joypad.h"
+
+/*  Scripted joypad input, for replaying the same inputs on every run. Movie files are text, with
+    one entry per line giving a frame number and the buttons held from the start of that frame
+    until the next entry:
+
+        # frame  buttons
+        60       start
+        64       -
+        120      a+right
+
+    Buttons are any of right, left, up, down, a, b, select and start joined by '+', or '-' for
+    none. Entries must be in increasing frame order, and blank lines and '#' comments are ignored.
+*/
+class InputMovie
+{
+public:
+    // Empty movie, no buttons are ever pressed
+    InputMovie();
+
+    // Returns false and prints the problem if the file can't be read or parsed
+    bool load(const std::string &file_path);
+    bool parse(const std::string &text);
+
+    // Bitmask of buttons held during the given frame, bit n set for Joypad key n
+    u8 buttons(long frame) const;
+
+    // Press and release keys to match the buttons held during the given frame
+    void apply(Joypad *pad, long frame) const;
+
+private:
+    struct Entry
+    {
+        long frame;
+        u8 buttons;
+    };
+
+    std::vector<Entry> entries;
+};
+
+#endif
@@ -0,0 +1,573 @@
+#ifndef INSTRUCTIONS_H
+#define INSTRUCTIONS_H
+
+#include "definitions.h"
+
+/*  Description of every instruction, indexed by opcode, with CB-prefixed instructions at 
+    CB_PREFIX + opcode. The interpreter's handlers are generated from this table at compile time 
+    (see processor.cpp), so decoding, timing and disassembly can't drift apart.
+
+    Operands are registers, IMM for bytes following the opcode, or MEM for (HL). LD_MEM takes the 
+    register pair holding the address instead, and arg is added to HL afterwards (LD (HL+), A).
+    Cycles are in machine cycles, with cycles_taken used when a conditional branch is taken. 
+    CB-prefixed entries count the whole instruction, prefix included.
+*/
+namespace instr
+{
+    enum Kind : u8
+    {
+        NOP, STOP, HALT, INVALID, PREFIX, DI, EI,
+        LD, LD_IMM, LD_MEM, LD_HIGH, LD_ABS, LD_NN_SP, LD_HL_SP, PUSH, POP,
+        ADD, ADC, SUB, SBC, AND, XOR, OR, CP, INC, DEC,
+        RLCA, RRCA, RLA, RRA, DAA, CPL, SCF, CCF,
+        JP, JR, CALL, RET, RETI, RST,
+        RLC, RRC, RL, RR, SLA, SRA, SWAP, SRL, BIT, RES, SET
+    };
+
+    enum Operand : u8 
+    {
+        NONE, A, B, C, D, E, H, L, AF, BC, DE, HL, SP, IMM, MEM
+    };
+
+    enum Condition : u8 
+    {
+        ALWAYS, IF_NZ, IF_Z, IF_NC, IF_C
+    };
+
+    struct Instruction
+    {
+        const char *mnemonic;
+        Kind kind;
+        Operand dst;
+        Operand src;
+        Condition cond;
+        // RST address, bit number, or HL increment
+        i8 arg;
+        // Bytes, including the CB prefix and immediate operands
+        u8 length;
+        u8 cycles;
+        u8 cycles_taken;
+    };
+
+    constexpr bool is_pair(Operand op) { return op >= AF && op <= SP; }
+
+    constexpr int CB_PREFIX = 0x100;
+    constexpr int NUM_INSTRUCTIONS = 0x200;
+
+    inline constexpr Instruction table[NUM_INSTRUCTIONS] = {
+    {"NOP",               NOP,      NONE, NONE, ALWAYS,  0, 1, 1, 1}, // 00
+    {"LD BC, n",          LD_IMM,   BC,   IMM,  ALWAYS,  0, 3, 3, 3}, // 01
+    {"LD (BC), A",        LD_MEM,   BC,   A,    ALWAYS,  0, 1, 2, 2}, // 02
+    {"INC BC",            INC,      BC,   NONE, ALWAYS,  0, 1, 2, 2}, // 03
+    {"INC B",             INC,      B,    NONE, ALWAYS,  0, 1, 1, 1}, // 04
+    {"DEC B",             DEC,      B,    NONE, ALWAYS,  0, 1, 1, 1}, // 05
+    {"LD B, n",           LD_IMM,   B,    IMM,  ALWAYS,  0, 2, 2, 2}, // 06
+    {"RLCA",              RLCA,     NONE, NONE, ALWAYS,  0, 1, 1, 1}, // 07
+    {"LD (nn), SP",       LD_NN_SP, NONE, NONE, ALWAYS,  0, 3, 5, 5}, // 08
+    {"ADD HL, BC",        ADD,      HL,   BC,   ALWAYS,  0, 1, 2, 2}, // 09
+    {"LD A, (BC)",        LD_MEM,   A,    BC,   ALWAYS,  0, 1, 2, 2}, // 0a
+    {"DEC BC",            DEC,      BC,   NONE, ALWAYS,  0, 1, 2, 2}, // 0b
+    {"INC C",             INC,      C,    NONE, ALWAYS,  0, 1, 1, 1}, // 0c
+    {"DEC C",             DEC,      C,    NONE, ALWAYS,  0, 1, 1, 1}, // 0d
+    {"LD C, n",           LD_IMM,   C,    IMM,  ALWAYS,  0, 2, 2, 2}, // 0e
+    {"RRCA",              RRCA,     NONE, NONE, ALWAYS,  0, 1, 1, 1}, // 0f
+    {"STOP",              STOP,     NONE, NONE, ALWAYS,  0, 1, 0, 0}, // 10
+    {"LD DE, n",          LD_IMM,   DE,   IMM,  ALWAYS,  0, 3, 3, 3}, // 11
+    {"LD (DE), A",        LD_MEM,   DE,   A,    ALWAYS,  0, 1, 2, 2}, // 12
+    {"INC DE",            INC,      DE,   NONE, ALWAYS,  0, 1, 2, 2}, // 13
+    {"INC D",             INC,      D,    NONE, ALWAYS,  0, 1, 1, 1}, // 14
+    {"DEC D",             DEC,      D,    NONE, ALWAYS,  0, 1, 1, 1}, // 15
+    {"LD D, n",           LD_IMM,   D,    IMM,  ALWAYS,  0, 2, 2, 2}, // 16
+    {"RLA",               RLA,      NONE, NONE, ALWAYS,  0, 1, 1, 1}, // 17
+    {"JR PC + n",         JR,       NONE, NONE, ALWAYS,  0, 2, 3, 3}, // 18
+    {"ADD HL, DE",        ADD,      HL,   DE,   ALWAYS,  0, 1, 2, 2}, // 19
+    {"LD A, (DE)",        LD_MEM,   A,    DE,   ALWAYS,  0, 1, 2, 2}, // 1a
+    {"DEC DE",            DEC,      DE,   NONE, ALWAYS,  0, 1, 2, 2}, // 1b
+    {"INC E",             INC,      E,    NONE, ALWAYS,  0, 1, 1, 1}, // 1c
+    {"DEC E",             DEC,      E,    NONE, ALWAYS,  0, 1, 1, 1}, // 1d
+    {"LD E, n",           LD_IMM,   E,    IMM,  ALWAYS,  0, 2, 2, 2}, // 1e
+    {"RRA",               RRA,      NONE, NONE, ALWAYS,  0, 1, 1, 1}, // 1f
+    {"JR NZ, PC + n",     JR,       NONE, NONE, IF_NZ,   0, 2, 2, 3}, // 20
+    {"LD HL, n",          LD_IMM,   HL,   IMM,  ALWAYS,  0, 3, 3, 3}, // 21
+    {"LD (HL++), A",      LD_MEM,   HL,   A,    ALWAYS,  1, 1, 2, 2}, // 22
+    {"INC HL",            INC,      HL,   NONE, ALWAYS,  0, 1, 2, 2}, // 23
+    {"INC H",             INC,      H,    NONE, ALWAYS,  0, 1, 1, 1}, // 24
+    {"DEC H",             DEC,      H,    NONE, ALWAYS,  0, 1, 1, 1}, // 25
+    {"LD H, n",           LD_IMM,   H,    IMM,  ALWAYS,  0, 2, 2, 2}, // 26
+    {"DAA",               DAA,      NONE, NONE, ALWAYS,  0, 1, 1, 1}, // 27
+    {"JR Z, PC + n",      JR,       NONE, NONE, IF_Z,    0, 2, 2, 3}, // 28
+    {"ADD HL, HL",        ADD,      HL,   HL,   ALWAYS,  0, 1, 2, 2}, // 29
+    {"LD A, (HL + )",     LD_MEM,   A,    HL,   ALWAYS,  1, 1, 2, 2}, // 2a
+    {"DEC HL",            DEC,      HL,   NONE, ALWAYS,  0, 1, 2, 2}, // 2b
+    {"INC L",             INC,      L,    NONE, ALWAYS,  0, 1, 1, 1}, // 2c
+    {"DEC L",             DEC,      L,    NONE, ALWAYS,  0, 1, 1, 1}, // 2d
+    {"LD L, n",           LD_IMM,   L,    IMM,  ALWAYS,  0, 2, 2, 2}, // 2e
+    {"CPL",               CPL,      NONE, NONE, ALWAYS,  0, 1, 1, 1}, // 2f
+    {"JR NC, PC + n",     JR,       NONE, NONE, IF_NC,   0, 2, 2, 3}, // 30
+    {"LD SP, n",          LD_IMM,   SP,   IMM,  ALWAYS,  0, 3, 3, 3}, // 31
+    {"LD (HL-), A",       LD_MEM,   HL,   A,    ALWAYS, -1, 1, 2, 2}, // 32
+    {"INC SP",            INC,      SP,   NONE, ALWAYS,  0, 1, 2, 2}, // 33
+    {"INC (HL)",          INC,      MEM,  NONE, ALWAYS,  0, 1, 3, 3}, // 34
+    {"DEC (HL)",          DEC,      MEM,  NONE, ALWAYS,  0, 1, 3, 3}, // 35
+    {"LD (HL), n",        LD_MEM,   HL,   IMM,  ALWAYS,  0, 2, 3, 3}, // 36
+    {"SCF",               SCF,      NONE, NONE, ALWAYS,  0, 1, 1, 1}, // 37
+    {"JR C, PC + n",      JR,       NONE, NONE, IF_C,    0, 2, 2, 3}, // 38
+    {"ADD HL, SP",        ADD,      HL,   SP,   ALWAYS,  0, 1, 2, 2}, // 39
+    {"LD A, (HL-)",       LD_MEM,   A,    HL,   ALWAYS, -1, 1, 2, 2}, // 3a
+    {"DEC SP",            DEC,      SP,   NONE, ALWAYS,  0, 1, 2, 2}, // 3b
+    {"INC A",             INC,      A,    NONE, ALWAYS,  0, 1, 1, 1}, // 3c
+    {"DEC A",             DEC,      A,    NONE, ALWAYS,  0, 1, 1, 1}, // 3d
+    {"LD A, n",           LD_IMM,   A,    IMM,  ALWAYS,  0, 2, 2, 2}, // 3e
+    {"CCF",               CCF,      NONE, NONE, ALWAYS,  0, 1, 1, 1}, // 3f
+    {"LD B, B",           LD,       B,    B,    ALWAYS,  0, 1, 1, 1}, // 40
+    {"LD B, C",           LD,       B,    C,    ALWAYS,  0, 1, 1, 1}, // 41
+    {"LD B, D",           LD,       B,    D,    ALWAYS,  0, 1, 1, 1}, // 42
+    {"LD B, E",           LD,       B,    E,    ALWAYS,  0, 1, 1, 1}, // 43
+    {"LD B, H",           LD,       B,    H,    ALWAYS,  0, 1, 1, 1}, // 44
+    {"LD B, L",           LD,       B,    L,    ALWAYS,  0, 1, 1, 1}, // 45
+    {"LD B, (HL)",        LD_MEM,   B,    HL,   ALWAYS,  0, 1, 2, 2}, // 46
+    {"LD B, A",           LD,       B,    A,    ALWAYS,  0, 1, 1, 1}, // 47
+    {"LD C, B",           LD,       C,    B,    ALWAYS,  0, 1, 1, 1}, // 48
+    {"LD C, C",           LD,       C,    C,    ALWAYS,  0, 1, 1, 1}, // 49
+    {"LD C, D",           LD,       C,    D,    ALWAYS,  0, 1, 1, 1}, // 4a
+    {"LD C, E",           LD,       C,    E,    ALWAYS,  0, 1, 1, 1}, // 4b
+    {"LD C, H",           LD,       C,    H,    ALWAYS,  0, 1, 1, 1}, // 4c
+    {"LD C, L",           LD,       C,    L,    ALWAYS,  0, 1, 1, 1}, // 4d
+    {"LD C, (HL)",        LD_MEM,   C,    HL,   ALWAYS,  0, 1, 2, 2}, // 4e
+    {"LD C, A",           LD,       C,    A,    ALWAYS,  0, 1, 1, 1}, // 4f
+    {"LD D, B",           LD,       D,    B,    ALWAYS,  0, 1, 1, 1}, // 50
+    {"LD D, C",           LD,       D,    C,    ALWAYS,  0, 1, 1, 1}, // 51
+    {"LD D, D",           LD,       D,    D,    ALWAYS,  0, 1, 1, 1}, // 52
+    {"LD D, E",           LD,       D,    E,    ALWAYS,  0, 1, 1, 1}, // 53
+    {"LD D, H",           LD,       D,    H,    ALWAYS,  0, 1, 1, 1}, // 54
+    {"LD D, L",           LD,       D,    L,    ALWAYS,  0, 1, 1, 1}, // 55
+    {"LD D, (HL)",        LD_MEM,   D,    HL,   ALWAYS,  0, 1, 2, 2}, // 56
+    {"LD D, A",           LD,       D,    A,    ALWAYS,  0, 1, 1, 1}, // 57
+    {"LD E, B",           LD,       E,    B,    ALWAYS,  0, 1, 1, 1}, // 58
+    {"LD E, C",           LD,       E,    C,    ALWAYS,  0, 1, 1, 1}, // 59
+    {"LD E, D",           LD,       E,    D,    ALWAYS,  0, 1, 1, 1}, // 5a
+    {"LD E, E",           LD,       E,    E,    ALWAYS,  0, 1, 1, 1}, // 5b
+    {"LD E, H",           LD,       E,    H,    ALWAYS,  0, 1, 1, 1}, // 5c
+    {"LD E, L",           LD,       E,    L,    ALWAYS,  0, 1, 1, 1}, // 5d
+    {"LD E, (HL)",        LD_MEM,   E,    HL,   ALWAYS,  0, 1, 2, 2}, // 5e
+    {"LD E, A",           LD,       E,    A,    ALWAYS,  0, 1, 1, 1}, // 5f
+    {"LD H, B",           LD,       H,    B,    ALWAYS,  0, 1, 1, 1}, // 60
+    {"LD H, C",           LD,       H,    C,    ALWAYS,  0, 1, 1, 1}, // 61
+    {"LD H, D",           LD,       H,    D,    ALWAYS,  0, 1, 1, 1}, // 62
+    {"LD H, E",           LD,       H,    E,    ALWAYS,  0, 1, 1, 1}, // 63
+    {"LD H, H",           LD,       H,    H,    ALWAYS,  0, 1, 1, 1}, // 64
+    {"LD H, L",           LD,       H,    L,    ALWAYS,  0, 1, 1, 1}, // 65
+    {"LD H, (HL)",        LD_MEM,   H,    HL,   ALWAYS,  0, 1, 2, 2}, // 66
+    {"LD H, A",           LD,       H,    A,    ALWAYS,  0, 1, 1, 1}, // 67
+    {"LD L, B",           LD,       L,    B,    ALWAYS,  0, 1, 1, 1}, // 68
+    {"LD L, C",           LD,       L,    C,    ALWAYS,  0, 1, 1, 1}, // 69
+    {"LD L, D",           LD,       L,    D,    ALWAYS,  0, 1, 1, 1}, // 6a
+    {"LD L, E",           LD,       L,    E,    ALWAYS,  0, 1, 1, 1}, // 6b
+    {"LD L, H",           LD,       L,    H,    ALWAYS,  0, 1, 1, 1}, // 6c
+    {"LD L, L",           LD,       L,    L,    ALWAYS,  0, 1, 1, 1}, // 6d
+    {"LD L, (HL)",        LD_MEM,   L,    HL,   ALWAYS,  0, 1, 2, 2}, // 6e
+    {"LD L, A",           LD,       L,    A,    ALWAYS,  0, 1, 1, 1}, // 6f
+    {"LD (HL), B",        LD_MEM,   HL,   B,    ALWAYS,  0, 1, 2, 2}, // 70
+    {"LD (HL), C",        LD_MEM,   HL,   C,    ALWAYS,  0, 1, 2, 2}, // 71
+    {"LD (HL), D",        LD_MEM,   HL,   D,    ALWAYS,  0, 1, 2, 2}, // 72
+    {"LD (HL), E",        LD_MEM,   HL,   E,    ALWAYS,  0, 1, 2, 2}, // 73
+    {"LD (HL), H",        LD_MEM,   HL,   H,    ALWAYS,  0, 1, 2, 2}, // 74
+    {"LD (HL), L",        LD_MEM,   HL,   L,    ALWAYS,  0, 1, 2, 2}, // 75
+    {"HALT",              HALT,     NONE, NONE, ALWAYS,  0, 1, 0, 0}, // 76
+    {"LD (HL), A",        LD_MEM,   HL,   A,    ALWAYS,  0, 1, 2, 2}, // 77
+    {"LD A, B",           LD,       A,    B,    ALWAYS,  0, 1, 1, 1}, // 78
+    {"LD A, C",           LD,       A,    C,    ALWAYS,  0, 1, 1, 1}, // 79
+    {"LD A, D",           LD,       A,    D,    ALWAYS,  0, 1, 1, 1}, // 7a
+    {"LD A, E",           LD,       A,    E,    ALWAYS,  0, 1, 1, 1}, // 7b
+    {"LD A, H",           LD,       A,    H,    ALWAYS,  0, 1, 1, 1}, // 7c
+    {"LD A, L",           LD,       A,    L,    ALWAYS,  0, 1, 1, 1}, // 7d
+    {"LD A, (HL)",        LD_MEM,   A,    HL,   ALWAYS,  0, 1, 2, 2}, // 7e
+    {"LD A, A",           LD,       A,    A,    ALWAYS,  0, 1, 1, 1}, // 7f
+    {"ADD B",             ADD,      A,    B,    ALWAYS,  0, 1, 1, 1}, // 80
+    {"ADD C",             ADD,      A,    C,    ALWAYS,  0, 1, 1, 1}, // 81
+    {"ADD D",             ADD,      A,    D,    ALWAYS,  0, 1, 1, 1}, // 82
+    {"ADD E",             ADD,      A,    E,    ALWAYS,  0, 1, 1, 1}, // 83
+    {"ADD H",             ADD,      A,    H,    ALWAYS,  0, 1, 1, 1}, // 84
+    {"ADD L",             ADD,      A,    L,    ALWAYS,  0, 1, 1, 1}, // 85
+    {"ADD (HL)",          ADD,      A,    MEM,  ALWAYS,  0, 1, 2, 2}, // 86
+    {"ADD A",             ADD,      A,    A,    ALWAYS,  0, 1, 1, 1}, // 87
+    {"ADC B",             ADC,      A,    B,    ALWAYS,  0, 1, 1, 1}, // 88
+    {"ADC C",             ADC,      A,    C,    ALWAYS,  0, 1, 1, 1}, // 89
+    {"ADC D",             ADC,      A,    D,    ALWAYS,  0, 1, 1, 1}, // 8a
+    {"ADC E",             ADC,      A,    E,    ALWAYS,  0, 1, 1, 1}, // 8b
+    {"ADC H",             ADC,      A,    H,    ALWAYS,  0, 1, 1, 1}, // 8c
+    {"ADC L",             ADC,      A,    L,    ALWAYS,  0, 1, 1, 1}, // 8d
+    {"ADC (HL)",          ADC,      A,    MEM,  ALWAYS,  0, 1, 2, 2}, // 8e
+    {"ADC A",             ADC,      A,    A,    ALWAYS,  0, 1, 1, 1}, // 8f
+    {"SUB B",             SUB,      A,    B,    ALWAYS,  0, 1, 1, 1}, // 90
+    {"SUB C",             SUB,      A,    C,    ALWAYS,  0, 1, 1, 1}, // 91
+    {"SUB D",             SUB,      A,    D,    ALWAYS,  0, 1, 1, 1}, // 92
+    {"SUB E",             SUB,      A,    E,    ALWAYS,  0, 1, 1, 1}, // 93
+    {"SUB H",             SUB,      A,    H,    ALWAYS,  0, 1, 1, 1}, // 94
+    {"SUB L",             SUB,      A,    L,    ALWAYS,  0, 1, 1, 1}, // 95
+    {"SUB (HL)",          SUB,      A,    MEM,  ALWAYS,  0, 1, 2, 2}, // 96
+    {"SUB A",             SUB,      A,    A,    ALWAYS,  0, 1, 1, 1}, // 97
+    {"SBC B",             SBC,      A,    B,    ALWAYS,  0, 1, 1, 1}, // 98
+    {"SBC C",             SBC,      A,    C,    ALWAYS,  0, 1, 1, 1}, // 99
+    {"SBC D",             SBC,      A,    D,    ALWAYS,  0, 1, 1, 1}, // 9a
+    {"SBC E",             SBC,      A,    E,    ALWAYS,  0, 1, 1, 1}, // 9b
+    {"SBC H",             SBC,      A,    H,    ALWAYS,  0, 1, 1, 1}, // 9c
+    {"SBC L",             SBC,      A,    L,    ALWAYS,  0, 1, 1, 1}, // 9d
+    {"SBC (HL)",          SBC,      A,    MEM,  ALWAYS,  0, 1, 2, 2}, // 9e
+    {"SBC A",             SBC,      A,    A,    ALWAYS,  0, 1, 1, 1}, // 9f
+    {"AND B",             AND,      A,    B,    ALWAYS,  0, 1, 1, 1}, // a0
+    {"AND C",             AND,      A,    C,    ALWAYS,  0, 1, 1, 1}, // a1
+    {"AND D",             AND,      A,    D,    ALWAYS,  0, 1, 1, 1}, // a2
+    {"AND E",             AND,      A,    E,    ALWAYS,  0, 1, 1, 1}, // a3
+    {"AND H",             AND,      A,    H,    ALWAYS,  0, 1, 1, 1}, // a4
+    {"AND L",             AND,      A,    L,    ALWAYS,  0, 1, 1, 1}, // a5
+    {"AND (HL)",          AND,      A,    MEM,  ALWAYS,  0, 1, 2, 2}, // a6
+    {"AND A",             AND,      A,    A,    ALWAYS,  0, 1, 1, 1}, // a7
+    {"XOR B",             XOR,      A,    B,    ALWAYS,  0, 1, 1, 1}, // a8
+    {"XOR C",             XOR,      A,    C,    ALWAYS,  0, 1, 1, 1}, // a9
+    {"XOR D",             XOR,      A,    D,    ALWAYS,  0, 1, 1, 1}, // aa
+    {"XOR E",             XOR,      A,    E,    ALWAYS,  0, 1, 1, 1}, // ab
+    {"XOR H",             XOR,      A,    H,    ALWAYS,  0, 1, 1, 1}, // ac
+    {"XOR L",             XOR,      A,    L,    ALWAYS,  0, 1, 1, 1}, // ad
+    {"XOR (HL)",          XOR,      A,    MEM,  ALWAYS,  0, 1, 2, 2}, // ae
+    {"XOR A",             XOR,      A,    A,    ALWAYS,  0, 1, 1, 1}, // af
+    {"OR B",              OR,       A,    B,    ALWAYS,  0, 1, 1, 1}, // b0
+    {"OR C",              OR,       A,    C,    ALWAYS,  0, 1, 1, 1}, // b1
+    {"OR D",              OR,       A,    D,    ALWAYS,  0, 1, 1, 1}, // b2
+    {"OR E",              OR,       A,    E,    ALWAYS,  0, 1, 1, 1}, // b3
+    {"OR H",              OR,       A,    H,    ALWAYS,  0, 1, 1, 1}, // b4
+    {"OR L",              OR,       A,    L,    ALWAYS,  0, 1, 1, 1}, // b5
+    {"OR (HL)",           OR,       A,    MEM,  ALWAYS,  0, 1, 2, 2}, // b6
+    {"OR A",              OR,       A,    A,    ALWAYS,  0, 1, 1, 1}, // b7
+    {"CP B",              CP,       A,    B,    ALWAYS,  0, 1, 1, 1}, // b8
+    {"CP C",              CP,       A,    C,    ALWAYS,  0, 1, 1, 1}, // b9
+    {"CP D",              CP,       A,    D,    ALWAYS,  0, 1, 1, 1}, // ba
+    {"CP E",              CP,       A,    E,    ALWAYS,  0, 1, 1, 1}, // bb
+    {"CP H",              CP,       A,    H,    ALWAYS,  0, 1, 1, 1}, // bc
+    {"CP L",              CP,       A,    L,    ALWAYS,  0, 1, 1, 1}, // bd
+    {"CP (HL)",           CP,       A,    MEM,  ALWAYS,  0, 1, 2, 2}, // be
+    {"CP A",              CP,       A,    A,    ALWAYS,  0, 1, 1, 1}, // bf
+    {"RET NZ",            RET,      NONE, NONE, IF_NZ,   0, 1, 2, 5}, // c0
+    {"POP BC",            POP,      BC,   NONE, ALWAYS,  0, 1, 3, 3}, // c1
+    {"JP NZ, nn",         JP,       NONE, NONE, IF_NZ,   0, 3, 3, 4}, // c2
+    {"JP nn",             JP,       NONE, NONE, ALWAYS,  0, 3, 4, 4}, // c3
+    {"CALL NZ, nn",       CALL,     NONE, NONE, IF_NZ,   0, 3, 3, 6}, // c4
+    {"PUSH BC",           PUSH,     BC,   NONE, ALWAYS,  0, 1, 4, 4}, // c5
+    {"ADD n",             ADD,      A,    IMM,  ALWAYS,  0, 2, 2, 2}, // c6
+    {"RST $00",           RST,      NONE, NONE, ALWAYS,  0, 1, 4, 4}, // c7
+    {"RET Z",             RET,      NONE, NONE, IF_Z,    0, 1, 2, 5}, // c8
+    {"RET",               RET,      NONE, NONE, ALWAYS,  0, 1, 4, 4}, // c9
+    {"JP Z, nn",          JP,       NONE, NONE, IF_Z,    0, 3, 3, 4}, // ca
+    {"CBPREFIX",          PREFIX,   NONE, NONE, ALWAYS,  0, 1, 0, 0}, // cb
+    {"CALL Z, nn",        CALL,     NONE, NONE, IF_Z,    0, 3, 3, 6}, // cc
+    {"CALL nn",           CALL,     NONE, NONE, ALWAYS,  0, 3, 6, 6}, // cd
+    {"ADC n",             ADC,      A,    IMM,  ALWAYS,  0, 2, 2, 2}, // ce
+    {"RST $08",           RST,      NONE, NONE, ALWAYS,  8, 1, 4, 4}, // cf
+    {"RET NC",            RET,      NONE, NONE, IF_NC,   0, 1, 2, 5}, // d0
+    {"POP DE",            POP,      DE,   NONE, ALWAYS,  0, 1, 3, 3}, // d1
+    {"JP NC, nn",         JP,       NONE, NONE, IF_NC,   0, 3, 3, 4}, // d2
+    {"INVALID",           INVALID,  NONE, NONE, ALWAYS,  0, 1, 0, 0}, // d3
+    {"CALL NC, nn",       CALL,     NONE, NONE, IF_NC,   0, 3, 3, 6}, // d4
+    {"PUSH DE",           PUSH,     DE,   NONE, ALWAYS,  0, 1, 4, 4}, // d5
+    {"SUB n",             SUB,      A,    IMM,  ALWAYS,  0, 2, 2, 2}, // d6
+    {"RST $10",           RST,      NONE, NONE, ALWAYS, 16, 1, 4, 4}, // d7
+    {"RET C",             RET,      NONE, NONE, IF_C,    0, 1, 2, 5}, // d8
+    {"RETI",              RETI,     NONE, NONE, ALWAYS,  0, 1, 4, 4}, // d9
+    {"JP C, nn",          JP,       NONE, NONE, IF_C,    0, 3, 3, 4}, // da
+    {"INVALID",           INVALID,  NONE, NONE, ALWAYS,  0, 1, 0, 0}, // db
+    {"CALL C, nn",        CALL,     NONE, NONE, IF_C,    0, 3, 3, 6}, // dc
+    {"INVALID",           INVALID,  NONE, NONE, ALWAYS,  0, 1, 0, 0}, // dd
+    {"SBC n",             SBC,      A,    IMM,  ALWAYS,  0, 2, 2, 2}, // de
+    {"RST $18",           RST,      NONE, NONE, ALWAYS, 24, 1, 4, 4}, // df
+    {"LD ($FF00 + n), A", LD_HIGH,  IMM,  A,    ALWAYS,  0, 2, 3, 3}, // e0
+    {"POP HL",            POP,      HL,   NONE, ALWAYS,  0, 1, 3, 3}, // e1
+    {"LD ($FF00 + C), A", LD_HIGH,  C,    A,    ALWAYS,  0, 1, 2, 2}, // e2
+    {"INVALID",           INVALID,  NONE, NONE, ALWAYS,  0, 1, 0, 0}, // e3
+    {"INVALID",           INVALID,  NONE, NONE, ALWAYS,  0, 1, 0, 0}, // e4
+    {"PUSH HL",           PUSH,     HL,   NONE, ALWAYS,  0, 1, 4, 4}, // e5
+    {"AND n",             AND,      A,    IMM,  ALWAYS,  0, 2, 2, 2}, // e6
+    {"RST $20",           RST,      NONE, NONE, ALWAYS, 32, 1, 4, 4}, // e7
+    {"ADD SP, n",         ADD,      SP,   IMM,  ALWAYS,  0, 2, 4, 4}, // e8
+    {"JP (HL)",           JP,       NONE, HL,   ALWAYS,  0, 1, 1, 1}, // e9
+    {"LD (nn), A",        LD_ABS,   IMM,  A,    ALWAYS,  0, 3, 4, 4}, // ea
+    {"INVALID",           INVALID,  NONE, NONE, ALWAYS,  0, 1, 0, 0}, // eb
+    {"INVALID",           INVALID,  NONE, NONE, ALWAYS,  0, 1, 0, 0}, // ec
+    {"INVALID",           INVALID,  NONE, NONE, ALWAYS,  0, 1, 0, 0}, // ed
+    {"XOR n",             XOR,      A,    IMM,  ALWAYS,  0, 2, 2, 2}, // ee
+    {"RST $28",           RST,      NONE, NONE, ALWAYS, 40, 1, 4, 4}, // ef
+    {"LD A, ($FF00 + n)", LD_HIGH,  A,    IMM,  ALWAYS,  0, 2, 3, 3}, // f0
+    {"POP AF",            POP,      AF,   NONE, ALWAYS,  0, 1, 3, 3}, // f1
+    {"LD A, ($FF00 + C)", LD_HIGH,  A,    C,    ALWAYS,  0, 1, 2, 2}, // f2
+    {"DI",                DI,       NONE, NONE, ALWAYS,  0, 1, 1, 1}, // f3
+    {"INVALID",           INVALID,  NONE, NONE, ALWAYS,  0, 1, 0, 0}, // f4
+    {"PUSH AF",           PUSH,     AF,   NONE, ALWAYS,  0, 1, 4, 4}, // f5
+    {"OR n",              OR,       A,    IMM,  ALWAYS,  0, 2, 2, 2}, // f6
+    {"RST $30",           RST,      NONE, NONE, ALWAYS, 48, 1, 4, 4}, // f7
+    {"LD HL, SP + n",     LD_HL_SP, NONE, NONE, ALWAYS,  0, 2, 3, 3}, // f8
+    {"LD SP, HL",         LD,       SP,   HL,   ALWAYS,  0, 1, 2, 2}, // f9
+    {"LD A, (nn)",        LD_ABS,   A,    IMM,  ALWAYS,  0, 3, 4, 4}, // fa
+    {"EI",                EI,       NONE, NONE, ALWAYS,  0, 1, 1, 1}, // fb
+    {"INVALID",           INVALID,  NONE, NONE, ALWAYS,  0, 1, 0, 0}, // fc
+    {"INVALID",           INVALID,  NONE, NONE, ALWAYS,  0, 1, 0, 0}, // fd
+    {"CP n",              CP,       A,    IMM,  ALWAYS,  0, 2, 2, 2}, // fe
+    {"RST $38",           RST,      NONE, NONE, ALWAYS, 56, 1, 4, 4}, // ff
+    {"RLC B",             RLC,      B,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 00
+    {"RLC C",             RLC,      C,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 01
+    {"RLC D",             RLC,      D,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 02
+    {"RLC E",             RLC,      E,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 03
+    {"RLC H",             RLC,      H,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 04
+    {"RLC L",             RLC,      L,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 05
+    {"RLC (HL)",          RLC,      MEM,  NONE, ALWAYS,  0, 2, 4, 4}, // cb 06
+    {"RLC A",             RLC,      A,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 07
+    {"RRC B",             RRC,      B,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 08
+    {"RRC C",             RRC,      C,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 09
+    {"RRC D",             RRC,      D,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 0a
+    {"RRC E",             RRC,      E,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 0b
+    {"RRC H",             RRC,      H,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 0c
+    {"RRC L",             RRC,      L,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 0d
+    {"RRC (HL)",          RRC,      MEM,  NONE, ALWAYS,  0, 2, 4, 4}, // cb 0e
+    {"RRC A",             RRC,      A,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 0f
+    {"RL B",              RL,       B,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 10
+    {"RL C",              RL,       C,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 11
+    {"RL D",              RL,       D,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 12
+    {"RL E",              RL,       E,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 13
+    {"RL H",              RL,       H,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 14
+    {"RL L",              RL,       L,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 15
+    {"RL (HL)",           RL,       MEM,  NONE, ALWAYS,  0, 2, 4, 4}, // cb 16
+    {"RL A",              RL,       A,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 17
+    {"RR B",              RR,       B,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 18
+    {"RR C",              RR,       C,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 19
+    {"RR D",              RR,       D,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 1a
+    {"RR E",              RR,       E,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 1b
+    {"RR H",              RR,       H,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 1c
+    {"RR L",              RR,       L,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 1d
+    {"RR (HL)",           RR,       MEM,  NONE, ALWAYS,  0, 2, 4, 4}, // cb 1e
+    {"RR A",              RR,       A,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 1f
+    {"SLA B",             SLA,      B,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 20
+    {"SLA C",             SLA,      C,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 21
+    {"SLA D",             SLA,      D,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 22
+    {"SLA E",             SLA,      E,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 23
+    {"SLA H",             SLA,      H,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 24
+    {"SLA L",             SLA,      L,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 25
+    {"SLA (HL)",          SLA,      MEM,  NONE, ALWAYS,  0, 2, 4, 4}, // cb 26
+    {"SLA A",             SLA,      A,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 27
+    {"SRA B",             SRA,      B,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 28
+    {"SRA C",             SRA,      C,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 29
+    {"SRA D",             SRA,      D,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 2a
+    {"SRA E",             SRA,      E,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 2b
+    {"SRA H",             SRA,      H,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 2c
+    {"SRA L",             SRA,      L,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 2d
+    {"SRA (HL)",          SRA,      MEM,  NONE, ALWAYS,  0, 2, 4, 4}, // cb 2e
+    {"SRA A",             SRA,      A,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 2f
+    {"SWAP B",            SWAP,     B,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 30
+    {"SWAP C",            SWAP,     C,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 31
+    {"SWAP D",            SWAP,     D,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 32
+    {"SWAP E",            SWAP,     E,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 33
+    {"SWAP H",            SWAP,     H,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 34
+    {"SWAP L",            SWAP,     L,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 35
+    {"SWAP (HL)",         SWAP,     MEM,  NONE, ALWAYS,  0, 2, 4, 4}, // cb 36
+    {"SWAP A",            SWAP,     A,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 37
+    {"SRL B",             SRL,      B,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 38
+    {"SRL C",             SRL,      C,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 39
+    {"SRL D",             SRL,      D,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 3a
+    {"SRL E",             SRL,      E,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 3b
+    {"SRL H",             SRL,      H,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 3c
+    {"SRL L",             SRL,      L,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 3d
+    {"SRL (HL)",          SRL,      MEM,  NONE, ALWAYS,  0, 2, 4, 4}, // cb 3e
+    {"SRL A",             SRL,      A,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 3f
+    {"BIT 0, B",          BIT,      B,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 40
+    {"BIT 0, C",          BIT,      C,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 41
+    {"BIT 0, D",          BIT,      D,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 42
+    {"BIT 0, E",          BIT,      E,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 43
+    {"BIT 0, H",          BIT,      H,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 44
+    {"BIT 0, L",          BIT,      L,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 45
+    {"BIT 0, (HL)",       BIT,      MEM,  NONE, ALWAYS,  0, 2, 3, 3}, // cb 46
+    {"BIT 0, A",          BIT,      A,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 47
+    {"BIT 1, B",          BIT,      B,    NONE, ALWAYS,  1, 2, 2, 2}, // cb 48
+    {"BIT 1, C",          BIT,      C,    NONE, ALWAYS,  1, 2, 2, 2}, // cb 49
+    {"BIT 1, D",          BIT,      D,    NONE, ALWAYS,  1, 2, 2, 2}, // cb 4a
+    {"BIT 1, E",          BIT,      E,    NONE, ALWAYS,  1, 2, 2, 2}, // cb 4b
+    {"BIT 1, H",          BIT,      H,    NONE, ALWAYS,  1, 2, 2, 2}, // cb 4c
+    {"BIT 1, L",          BIT,      L,    NONE, ALWAYS,  1, 2, 2, 2}, // cb 4d
+    {"BIT 1, (HL)",       BIT,      MEM,  NONE, ALWAYS,  1, 2, 3, 3}, // cb 4e
+    {"BIT 1, A",          BIT,      A,    NONE, ALWAYS,  1, 2, 2, 2}, // cb 4f
+    {"BIT 2, B",          BIT,      B,    NONE, ALWAYS,  2, 2, 2, 2}, // cb 50
+    {"BIT 2, C",          BIT,      C,    NONE, ALWAYS,  2, 2, 2, 2}, // cb 51
+    {"BIT 2, D",          BIT,      D,    NONE, ALWAYS,  2, 2, 2, 2}, // cb 52
+    {"BIT 2, E",          BIT,      E,    NONE, ALWAYS,  2, 2, 2, 2}, // cb 53
+    {"BIT 2, H",          BIT,      H,    NONE, ALWAYS,  2, 2, 2, 2}, // cb 54
+    {"BIT 2, L",          BIT,      L,    NONE, ALWAYS,  2, 2, 2, 2}, // cb 55
+    {"BIT 2, (HL)",       BIT,      MEM,  NONE, ALWAYS,  2, 2, 3, 3}, // cb 56
+    {"BIT 2, A",          BIT,      A,    NONE, ALWAYS,  2, 2, 2, 2}, // cb 57
+    {"BIT 3, B",          BIT,      B,    NONE, ALWAYS,  3, 2, 2, 2}, // cb 58
+    {"BIT 3, C",          BIT,      C,    NONE, ALWAYS,  3, 2, 2, 2}, // cb 59
+    {"BIT 3, D",          BIT,      D,    NONE, ALWAYS,  3, 2, 2, 2}, // cb 5a
+    {"BIT 3, E",          BIT,      E,    NONE, ALWAYS,  3, 2, 2, 2}, // cb 5b
+    {"BIT 3, H",          BIT,      H,    NONE, ALWAYS,  3, 2, 2, 2}, // cb 5c
+    {"BIT 3, L",          BIT,      L,    NONE, ALWAYS,  3, 2, 2, 2}, // cb 5d
+    {"BIT 3, (HL)",       BIT,      MEM,  NONE, ALWAYS,  3, 2, 3, 3}, // cb 5e
+    {"BIT 3, A",          BIT,      A,    NONE, ALWAYS,  3, 2, 2, 2}, // cb 5f
+    {"BIT 4, B",          BIT,      B,    NONE, ALWAYS,  4, 2, 2, 2}, // cb 60
+    {"BIT 4, C",          BIT,      C,    NONE, ALWAYS,  4, 2, 2, 2}, // cb 61
+    {"BIT 4, D",          BIT,      D,    NONE, ALWAYS,  4, 2, 2, 2}, // cb 62
+    {"BIT 4, E",          BIT,      E,    NONE, ALWAYS,  4, 2, 2, 2}, // cb 63
+    {"BIT 4, H",          BIT,      H,    NONE, ALWAYS,  4, 2, 2, 2}, // cb 64
+    {"BIT 4, L",          BIT,      L,    NONE, ALWAYS,  4, 2, 2, 2}, // cb 65
+    {"BIT 4, (HL)",       BIT,      MEM,  NONE, ALWAYS,  4, 2, 3, 3}, // cb 66
+    {"BIT 4, A",          BIT,      A,    NONE, ALWAYS,  4, 2, 2, 2}, // cb 67
+    {"BIT 5, B",          BIT,      B,    NONE, ALWAYS,  5, 2, 2, 2}, // cb 68
+    {"BIT 5, C",          BIT,      C,    NONE, ALWAYS,  5, 2, 2, 2}, // cb 69
+    {"BIT 5, D",          BIT,      D,    NONE, ALWAYS,  5, 2, 2, 2}, // cb 6a
+    {"BIT 5, E",          BIT,      E,    NONE, ALWAYS,  5, 2, 2, 2}, // cb 6b
+    {"BIT 5, H",          BIT,      H,    NONE, ALWAYS,  5, 2, 2, 2}, // cb 6c
+    {"BIT 5, L",          BIT,      L,    NONE, ALWAYS,  5, 2, 2, 2}, // cb 6d
+    {"BIT 5, (HL)",       BIT,      MEM,  NONE, ALWAYS,  5, 2, 3, 3}, // cb 6e
+    {"BIT 5, A",          BIT,      A,    NONE, ALWAYS,  5, 2, 2, 2}, // cb 6f
+    {"BIT 6, B",          BIT,      B,    NONE, ALWAYS,  6, 2, 2, 2}, // cb 70
+    {"BIT 6, C",          BIT,      C,    NONE, ALWAYS,  6, 2, 2, 2}, // cb 71
+    {"BIT 6, D",          BIT,      D,    NONE, ALWAYS,  6, 2, 2, 2}, // cb 72
+    {"BIT 6, E",          BIT,      E,    NONE, ALWAYS,  6, 2, 2, 2}, // cb 73
+    {"BIT 6, H",          BIT,      H,    NONE, ALWAYS,  6, 2, 2, 2}, // cb 74
+    {"BIT 6, L",          BIT,      L,    NONE, ALWAYS,  6, 2, 2, 2}, // cb 75
+    {"BIT 6, (HL)",       BIT,      MEM,  NONE, ALWAYS,  6, 2, 3, 3}, // cb 76
+    {"BIT 6, A",          BIT,      A,    NONE, ALWAYS,  6, 2, 2, 2}, // cb 77
+    {"BIT 7, B",          BIT,      B,    NONE, ALWAYS,  7, 2, 2, 2}, // cb 78
+    {"BIT 7, C",          BIT,      C,    NONE, ALWAYS,  7, 2, 2, 2}, // cb 79
+    {"BIT 7, D",          BIT,      D,    NONE, ALWAYS,  7, 2, 2, 2}, // cb 7a
+    {"BIT 7, E",          BIT,      E,    NONE, ALWAYS,  7, 2, 2, 2}, // cb 7b
+    {"BIT 7, H",          BIT,      H,    NONE, ALWAYS,  7, 2, 2, 2}, // cb 7c
+    {"BIT 7, L",          BIT,      L,    NONE, ALWAYS,  7, 2, 2, 2}, // cb 7d
+    {"BIT 7, (HL)",       BIT,      MEM,  NONE, ALWAYS,  7, 2, 3, 3}, // cb 7e
+    {"BIT 7, A",          BIT,      A,    NONE, ALWAYS,  7, 2, 2, 2}, // cb 7f
+    {"RES 0, B",          RES,      B,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 80
+    {"RES 0, C",          RES,      C,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 81
+    {"RES 0, D",          RES,      D,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 82
+    {"RES 0, E",          RES,      E,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 83
+    {"RES 0, H",          RES,      H,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 84
+    {"RES 0, L",          RES,      L,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 85
+    {"RES 0, (HL)",       RES,      MEM,  NONE, ALWAYS,  0, 2, 4, 4}, // cb 86
+    {"RES 0, A",          RES,      A,    NONE, ALWAYS,  0, 2, 2, 2}, // cb 87
+    {"RES 1, B",          RES,      B,    NONE, ALWAYS,  1, 2, 2, 2}, // cb 88
+    {"RES 1, C",          RES,      C,    NONE, ALWAYS,  1, 2, 2, 2}, // cb 89
+    {"RES 1, D",          RES,      D,    NONE, ALWAYS,  1, 2, 2, 2}, // cb 8a
+    {"RES 1, E",          RES,      E,    NONE, ALWAYS,  1, 2, 2, 2}, // cb 8b
+    {"RES 1, H",          RES,      H,    NONE, ALWAYS,  1, 2, 2, 2}, // cb 8c
+    {"RES 1, L",          RES,      L,    NONE, ALWAYS,  1, 2, 2, 2}, // cb 8d
+    {"RES 1, (HL)",       RES,      MEM,  NONE, ALWAYS,  1, 2, 4, 4}, // cb 8e
+    {"RES 1, A",          RES,      A,    NONE, ALWAYS,  1, 2, 2, 2}, // cb 8f
+    {"RES 2, B",          RES,      B,    NONE, ALWAYS,  2, 2, 2, 2}, // cb 90
+    {"RES 2, C",          RES,      C,    NONE, ALWAYS,  2, 2, 2, 2}, // cb 91
+    {"RES 2, D",          RES,      D,    NONE, ALWAYS,  2, 2, 2, 2}, // cb 92
+    {"RES 2, E",          RES,      E,    NONE, ALWAYS,  2, 2, 2, 2}, // cb 93
+    {"RES 2, H",          RES,      H,    NONE, ALWAYS,  2, 2, 2, 2}, // cb 94
+    {"RES 2, L",          RES,      L,    NONE, ALWAYS,  2, 2, 2, 2}, // cb 95
+    {"RES 2, (HL)",       RES,      MEM,  NONE, ALWAYS,  2, 2, 4, 4}, // cb 96
+    {"RES 2, A",          RES,      A,    NONE, ALWAYS,  2, 2, 2, 2}, // cb 97
+    {"RES 3, B",          RES,      B,    NONE, ALWAYS,  3, 2, 2, 2}, // cb 98
+    {"RES 3, C",          RES,      C,    NONE, ALWAYS,  3, 2, 2, 2}, // cb 99
+    {"RES 3, D",          RES,      D,    NONE, ALWAYS,  3, 2, 2, 2}, // cb 9a
+    {"RES 3, E",          RES,      E,    NONE, ALWAYS,  3, 2, 2, 2}, // cb 9b
+    {"RES 3, H",          RES,      H,    NONE, ALWAYS,  3, 2, 2, 2}, // cb 9c
+    {"RES 3, L",          RES,      L,    NONE, ALWAYS,  3, 2, 2, 2}, // cb 9d
+    {"RES 3, (HL)",       RES,      MEM,  NONE, ALWAYS,  3, 2, 4, 4}, // cb 9e
+    {"RES 3, A",          RES,      A,    NONE, ALWAYS,  3, 2, 2, 2}, // cb 9f
+    {"RES 4, B",          RES,      B,    NONE, ALWAYS,  4, 2, 2, 2}, // cb a0
+    {"RES 4, C",          RES,      C,    NONE, ALWAYS,  4, 2, 2, 2}, // cb a1
+    {"RES 4, D",          RES,      D,    NONE, ALWAYS,  4, 2, 2, 2}, // cb a2
+    {"RES 4, E",          RES,      E,    NONE, ALWAYS,  4, 2, 2, 2}, // cb a3
+    {"RES 4, H",          RES,      H,    NONE, ALWAYS,  4, 2, 2, 2}, // cb a4
+    {"RES 4, L",          RES,      L,    NONE, ALWAYS,  4, 2, 2, 2}, // cb a5
+    {"RES 4, (HL)",       RES,      MEM,  NONE, ALWAYS,  4, 2, 4, 4}, // cb a6
+    {"RES 4, A",          RES,      A,    NONE, ALWAYS,  4, 2, 2, 2}, // cb a7
+    {"RES 5, B",          RES,      B,    NONE, ALWAYS,  5, 2, 2, 2}, // cb a8
+    {"RES 5, C",          RES,      C,    NONE, ALWAYS,  5, 2, 2, 2}, // cb a9
+    {"RES 5, D",          RES,      D,    NONE, ALWAYS,  5, 2, 2, 2}, // cb aa
+    {"RES 5, E",          RES,      E,    NONE, ALWAYS,  5, 2, 2, 2}, // cb ab
+    {"RES 5, H",          RES,      H,    NONE, ALWAYS,  5, 2, 2, 2}, // cb ac
+    {"RES 5, L",          RES,      L,    NONE, ALWAYS,  5, 2, 2, 2}, // cb ad
+    {"RES 5, (HL)",       RES,      MEM,  NONE, ALWAYS,  5, 2, 4, 4}, // cb ae
+    {"RES 5, A",          RES,      A,    NONE, ALWAYS,  5, 2, 2, 2}, // cb af
+    {"RES 6, B",          RES,      B,    NONE, ALWAYS,  6, 2, 2, 2}, // cb b0
+    {"RES 6, C",          RES,      C,    NONE, ALWAYS,  6, 2, 2, 2}, // cb b1
+    {"RES 6, D",          RES,      D,    NONE, ALWAYS,  6, 2, 2, 2}, // cb b2
+    {"RES 6, E",          RES,      E,    NONE, ALWAYS,  6, 2, 2, 2}, // cb b3
+    {"RES 6, H",          RES,      H,    NONE, ALWAYS,  6, 2, 2, 2}, // cb b4
+    {"RES 6, L",          RES,      L,    NONE, ALWAYS,  6, 2, 2, 2}, // cb b5
+    {"RES 6, (HL)",       RES,      MEM,  NONE, ALWAYS,  6, 2, 4, 4}, // cb b6
+    {"RES 6, A",          RES,      A,    NONE, ALWAYS,  6, 2, 2, 2}, // cb b7
+    {"RES 7, B",          RES,      B,    NONE, ALWAYS,  7, 2, 2, 2}, // cb b8
+    {"RES 7, C",          RES,      C,    NONE, ALWAYS,  7, 2, 2, 2}, // cb b9
+    {"RES 7, D",          RES,      D,    NONE, ALWAYS,  7, 2, 2, 2}, // cb ba
+    {"RES 7, E",          RES,      E,    NONE, ALWAYS,  7, 2, 2, 2}, // cb bb
+    {"RES 7, H",          RES,      H,    NONE, ALWAYS,  7, 2, 2, 2}, // cb bc
+    {"RES 7, L",          RES,      L,    NONE, ALWAYS,  7, 2, 2, 2}, // cb bd
+    {"RES 7, (HL)",       RES,      MEM,  NONE, ALWAYS,  7, 2, 4, 4}, // cb be
+    {"RES 7, A",          RES,      A,    NONE, ALWAYS,  7, 2, 2, 2}, // cb bf
+    {"SET 0, B",          SET,      B,    NONE, ALWAYS,  0, 2, 2, 2}, // cb c0
+    {"SET 0, C",          SET,      C,    NONE, ALWAYS,  0, 2, 2, 2}, // cb c1
+    {"SET 0, D",          SET,      D,    NONE, ALWAYS,  0, 2, 2, 2}, // cb c2
+    {"SET 0, E",          SET,      E,    NONE, ALWAYS,  0, 2, 2, 2}, // cb c3
+    {"SET 0, H",          SET,      H,    NONE, ALWAYS,  0, 2, 2, 2}, // cb c4
+    {"SET 0, L",          SET,      L,    NONE, ALWAYS,  0, 2, 2, 2}, // cb c5
+    {"SET 0, (HL)",       SET,      MEM,  NONE, ALWAYS,  0, 2, 4, 4}, // cb c6
+    {"SET 0, A",          SET,      A,    NONE, ALWAYS,  0, 2, 2, 2}, // cb c7
+    {"SET 1, B",          SET,      B,    NONE, ALWAYS,  1, 2, 2, 2}, // cb c8
+    {"SET 1, C",          SET,      C,    NONE, ALWAYS,  1, 2, 2, 2}, // cb c9
+    {"SET 1, D",          SET,      D,    NONE, ALWAYS,  1, 2, 2, 2}, // cb ca
+    {"SET 1, E",          SET,      E,    NONE, ALWAYS,  1, 2, 2, 2}, // cb cb
+    {"SET 1, H",          SET,      H,    NONE, ALWAYS,  1, 2, 2, 2}, // cb cc
+    {"SET 1, L",          SET,      L,    NONE, ALWAYS,  1, 2, 2, 2}, // cb cd
+    {"SET 1, (HL)",       SET,      MEM,  NONE, ALWAYS,  1, 2, 4, 4}, // cb ce
+    {"SET 1, A",          SET,      A,    NONE, ALWAYS,  1, 2, 2, 2}, // cb cf
+    {"SET 2, B",          SET,      B,    NONE, ALWAYS,  2, 2, 2, 2}, // cb d0
+    {"SET 2, C",          SET,      C,    NONE, ALWAYS,  2, 2, 2, 2}, // cb d1
+    {"SET 2, D",          SET,      D,    NONE, ALWAYS,  2, 2, 2, 2}, // cb d2
+    {"SET 2, E",          SET,      E,    NONE, ALWAYS,  2, 2, 2, 2}, // cb d3
+    {"SET 2, H",          SET,      H,    NONE, ALWAYS,  2, 2, 2, 2}, // cb d4
+    {"SET 2, L",          SET,      L,    NONE, ALWAYS,  2, 2, 2, 2}, // cb d5
+    {"SET 2, (HL)",       SET,      MEM,  NONE, ALWAYS,  2, 2, 4, 4}, // cb d6
+    {"SET 2, A",          SET,      A,    NONE, ALWAYS,  2, 2, 2, 2}, // cb d7
+    {"SET 3, B",          SET,      B,    NONE, ALWAYS,  3, 2, 2, 2}, // cb d8
+    {"SET 3, C",          SET,      C,    NONE, ALWAYS,  3, 2, 2, 2}, // cb d9
+    {"SET 3, D",          SET,      D,    NONE, ALWAYS,  3, 2, 2, 2}, // cb da
+    {"SET 3, E",          SET,      E,    NONE, ALWAYS,  3, 2, 2, 2}, // cb db
+    {"SET 3, H",          SET,      H,    NONE, ALWAYS,  3, 2, 2, 2}, // cb dc
+    {"SET 3, L",          SET,      L,    NONE, ALWAYS,  3, 2, 2, 2}, // cb dd
+    {"SET 3, (HL)",       SET,      MEM,  NONE, ALWAYS,  3, 2, 4, 4}, // cb de
+    {"SET 3, A",          SET,      A,    NONE, ALWAYS,  3, 2, 2, 2}, // cb df
+    {"SET 4, B",          SET,      B,    NONE, ALWAYS,  4, 2, 2, 2}, // cb e0
+    {"SET 4, C",          SET,      C,    NONE, ALWAYS,  4, 2, 2, 2}, // cb e1
+    {"SET 4, D",          SET,      D,    NONE, ALWAYS,  4, 2, 2, 2}, // cb e2
+    {"SET 4, E",          SET,      E,    NONE, ALWAYS,  4, 2, 2, 2}, // cb e3
+    {"SET 4, H",          SET,      H,    NONE, ALWAYS,  4, 2, 2, 2}, // cb e4
+    {"SET 4, L",          SET,      L,    NONE, ALWAYS,  4, 2, 2, 2}, // cb e5
+    {"SET 4, (HL)",       SET,      MEM,  NONE, ALWAYS,  4, 2, 4, 4}, // cb e6
+    {"SET 4, A",          SET,      A,    NONE, ALWAYS,  4, 2, 2, 2}, // cb e7
+    {"SET 5, B",          SET,      B,    NONE, ALWAYS,  5, 2, 2, 2}, // cb e8
+    {"SET 5, C",          SET,      C,    NONE, ALWAYS,  5, 2, 2, 2}, // cb e9
+    {"SET 5, D",          SET,      D,    NONE, ALWAYS,  5, 2, 2, 2}, // cb ea
+    {"SET 5, E",          SET,      E,    NONE, ALWAYS,  5, 2, 2, 2}, // cb eb
+    {"SET 5, H",          SET,      H,    NONE, ALWAYS,  5, 2, 2, 2}, // cb ec
+    {"SET 5, L",          SET,      L,    NONE, ALWAYS,  5, 2, 2, 2}, // cb ed
+    {"SET 5, (HL)",       SET,      MEM,  NONE, ALWAYS,  5, 2, 4, 4}, // cb ee
+    {"SET 5, A",          SET,      A,    NONE, ALWAYS,  5, 2, 2, 2}, // cb ef
+    {"SET 6, B",          SET,      B,    NONE, ALWAYS,  6, 2, 2, 2}, // cb f0
+    {"SET 6, C",          SET,      C,    NONE, ALWAYS,  6, 2, 2, 2}, // cb f1
+    {"SET 6, D",          SET,      D,    NONE, ALWAYS,  6, 2, 2, 2}, // cb f2
+    {"SET 6, E",          SET,      E,    NONE, ALWAYS,  6, 2, 2, 2}, // cb f3
+    {"SET 6, H",          SET,      H,    NONE, ALWAYS,  6, 2, 2, 2}, // cb f4
+    {"SET 6, L",          SET,      L,    NONE, ALWAYS,  6, 2, 2, 2}, // cb f5
+    {"SET 6, (HL)",       SET,      MEM,  NONE, ALWAYS,  6, 2, 4, 4}, // cb f6
+    {"SET 6, A",          SET,      A,    NONE, ALWAYS,  6, 2, 2, 2}, // cb f7
+    {"SET 7, B",          SET,      B,    NONE, ALWAYS,  7, 2, 2, 2}, // cb f8
+    {"SET 7, C",          SET,      C,    NONE, ALWAYS,  7, 2, 2, 2}, // cb f9
+    {"SET 7, D",          SET,      D,    NONE, ALWAYS,  7, 2, 2, 2}, // cb fa
+    {"SET 7, E",          SET,      E,    NONE, ALWAYS,  7, 2, 2, 2}, // cb fb
+    {"SET 7, H",          SET,      H,    NONE, ALWAYS,  7, 2, 2, 2}, // cb fc
+    {"SET 7, L",          SET,      L,    NONE, ALWAYS,  7, 2, 2, 2}, // cb fd
+    {"SET 7, (HL)",       SET,      MEM,  NONE, ALWAYS,  7, 2, 4, 4}, // cb fe
+    {"SET 7, A",          SET,      A,    NONE, ALWAYS,  7, 2, 2, 2}, // cb ff
+    };
+}
+
+#endif
@@ -3,17 +3,29 @@
 
 #include "definitions.h"
 
+/*  Interrupt request (IF) and enable (IE) registers. The set of interrupts both requested and 
+    enabled is recomputed only when either register changes, so the CPU can check for pending
+    interrupts without any memory accesses.
+*/
 class Interrupts 
 {
 public:
     Interrupts();
 
+    // IF register
     u8 read();
     void write(u8 data);
 
     void set(int bit);
     void clear(int bit);
 
+    // IE register
+    u8 read_enable();
+    void write_enable(u8 data);
+
+    // Requested and enabled interrupts, lowest bit has highest priority
+    u8 pending() const { return pending_mask; }
+
     static const u8 VBLANK_bit;
     static const u8 LCDSTAT_bit;
     static const u8 TIMER_bit;
@@ -21,7 +33,11 @@ public:
     static const u8 JOYPAD_bit;
 
 private:
+    void update_pending();
+
     u8 reg;
+    u8 enable_reg;
+    u8 pending_mask;
 };
 
-#endif
\ No newline at end of file
+#endif
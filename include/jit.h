@@ -0,0 +1,60 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <cstddef>
+#include "definitions.h"
+#include "block_cache.h"
+
+class Processor;
+class Memory;
+class Scheduler;
+
+/*  Recompiles hot blocks from the block cache to x86-64 code. Each block is split into runs of
+    instructions with fixed timing that don't branch and write memory at most in their last
+    instruction, which is all run_block needs to keep its checks between instructions exact.
+    Everything else (branches, rotates, DAA, 16-bit arithmetic, read-modify-write) is left to the
+    interpreter's handlers.
+
+    Within a run guest registers are pinned in host registers, flags are only materialized when
+    something can observe them, reads from WRAM and HRAM are inlined and anything else calls out
+    to Memory. The clock is brought up to date before every call out, so MMIO sees the same time
+    as under the interpreter.
+
+    Only available on x86-64 with the System V ABI. Elsewhere, or if executable memory can't be
+    allocated, compile does nothing and every block stays interpreted.
+*/
+class Jit
+{
+public:
+    Jit(Processor *cpu, Memory *mem, Scheduler *sched);
+    ~Jit();
+
+    Jit(const Jit&) = delete;
+    Jit& operator=(const Jit&) = delete;
+
+    bool supported() const { return code != nullptr; }
+
+    // Translate runs of block's instructions, recording them in block->native_runs
+    void compile(Block *block);
+
+    // Executions of a block before it's compiled
+    static const u32 THRESHOLD = 16;
+    // Shorter runs are cheaper to interpret than to enter and leave
+    static const int MIN_RUN = 3;
+
+    u64 blocks_compiled;
+    u64 instructions_compiled;
+    // Code space isn't reclaimed when blocks are invalidated. Once full, compiling stops
+    size_t code_used;
+
+    static const size_t CODE_SIZE = 8 << 20;
+
+private:
+    Processor *cpu;
+    Memory *memory;
+    Scheduler *scheduler;
+
+    u8 *code;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef MBC_H
+#define MBC_H
+
+#include <cstddef>
+#include <vector>
+#include "definitions.h"
+
+/*  Memory bank controllers. Each controller only runs logic when its control registers (writes to
+    0x0000 - 0x7fff) or non-plain cartridge RAM are accessed. The currently selected banks are kept
+    as host pointers, so reading banked ROM or RAM costs the same as reading a flat array:
+
+        rom0_base - 0x0000 - 0x3fff
+        romx_base - 0x4000 - 0x7fff
+        sram_base - 0xa000 - 0xbfff, or nullptr if RAM is disabled, absent or not plain memory (RTC
+                    registers, MBC2's 4-bit RAM), in which case read_ram/write_ram must be used
+*/
+class MemoryBankController
+{
+public:
+    // ROM is not owned by the controller, and must be a whole number of banks
+    MemoryBankController(const u8 *rom, size_t rom_size, std::vector<u8> &ram);
+    virtual ~MemoryBankController() {}
+
+    // Write to a control register in 0x0000 - 0x7fff
+    virtual void write_control(u16 addr, u8 data) = 0;
+
+    // Access cartridge RAM in 0xa000 - 0xbfff while sram_base is null
+    virtual u8 read_ram(u16 addr);
+    virtual void write_ram(u16 addr, u8 data);
+
+    const u8 *rom0_base;
+    const u8 *romx_base;
+    u8 *sram_base;
+
+protected:
+    // Select banks, wrapping bank numbers to the size of the ROM/RAM
+    void select_rom_banks(int bank0, int bankx);
+    void select_ram_bank(bool enable, int bank);
+
+    const u8 *read_only_mem;
+    std::vector<u8> &random_access_mem;
+    int num_rom_banks;
+    int num_ram_banks;
+
+    static const int ROM_BANK_SIZE;
+    static const int RAM_BANK_SIZE;
+};
+
+class NoController : public MemoryBankController
+{
+public:
+    NoController(const u8 *rom, size_t rom_size, std::vector<u8> &ram);
+    void write_control(u16 addr, u8 data) override;
+};
+
+class MBC1Controller : public MemoryBankController
+{
+public:
+    MBC1Controller(const u8 *rom, size_t rom_size, std::vector<u8> &ram);
+    void write_control(u16 addr, u8 data) override;
+
+private:
+    void update_banks();
+
+    bool enable_ram;
+    // 0 - upper bank bits only apply to 0x4000 - 0x7fff, 1 - also to 0x0000 - 0x3fff and RAM
+    bool mode;
+    // 5 bit register at 0x2000 - 0x3fff and 2 bit register at 0x4000 - 0x5fff
+    int bank_low;
+    int bank_high;
+};
+
+class MBC2Controller : public MemoryBankController
+{
+public:
+    MBC2Controller(const u8 *rom, size_t rom_size, std::vector<u8> &ram);
+    void write_control(u16 addr, u8 data) override;
+    u8 read_ram(u16 addr) override;
+    void write_ram(u16 addr, u8 data) override;
+
+private:
+    bool enable_ram;
+    // Built in 512 x 4-bit RAM, mirrored through 0xa000 - 0xbfff
+    std::vector<u8> internal_ram;
+};
+
+class MBC3Controller : public MemoryBankController
+{
+public:
+    MBC3Controller(const u8 *rom, size_t rom_size, std::vector<u8> &ram);
+    void write_control(u16 addr, u8 data) override;
+    u8 read_ram(u16 addr) override;
+    void write_ram(u16 addr, u8 data) override;
+
+private:
+    void update_banks();
+
+    bool enable_ram;
+    // 0 - 3 select a RAM bank, 8 - 0xc select an RTC register, anything else maps nothing
+    int ram_bank;
+    std::vector<u8> clock_registers;
+};
+
+class MBC5Controller : public MemoryBankController
+{
+public:
+    MBC5Controller(const u8 *rom, size_t rom_size, std::vector<u8> &ram);
+    void write_control(u16 addr, u8 data) override;
+
+private:
+    void update_banks();
+
+    bool enable_ram;
+    // 9 bit ROM bank number, bank 0 may be selected for 0x4000 - 0x7fff
+    int rom_bank;
+    int ram_bank;
+};
+
+#endif
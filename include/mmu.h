@@ -7,14 +7,16 @@
 #include "apu.h"
 #include "gpu.h"
 #include "interrupts.h"
+#include "timer.h"
 #include <iterator>
 #include <string>
 
+class BlockCache;
 
 class Memory
 {    
 public:
-    Memory(Interrupts *inter, Cartridge *cart, Joypad *pad, APU *audio, GPU *video, 
+    Memory(Interrupts *inter, Cartridge *cart, Joypad *pad, APU *audio, GPU *video, Timer *time,
         bool enable_boot = 0);
 
     void write(u16 addr, u8 data);
@@ -23,14 +25,31 @@ public:
     
     void load_boot(std::string s);
 
+    /*  Rebuild the page table. Only needs to happen when the memory layout seen by the CPU 
+        changes: boot ROM unmapped, cartridge bank switched or RAM enabled/disabled, or VRAM 
+        becoming (in)accessible as the PPU changes mode
+    */
+    void map_pages();
+    void map_cartridge_pages();
+    void map_video_pages();
+
+    /*  Host memory mapped into the 256-byte page containing addr, or nullptr if the page is 
+        memory-mapped IO
+    */
+    const u8 *read_page_base(u16 addr) const { return read_pages[addr >> 8].mem; }
+
+    /*  Route writes to the page of WRAM or HRAM containing addr through the slow path, which 
+        invalidates the block cache's code in that page and then lifts the protection again
+    */
+    void attach_block_cache(BlockCache *cache);
+    void protect_code(u16 addr);
+
     void set_access_break_pt(u16 addr);
 
     void clear_access_break_pt();
 
     bool pause();
 
-    u8& get_mem_reference(u16 addr);
-
     std::vector<u8> boot_ROM;
     
     std::vector<u8> internal_RAM;
@@ -38,20 +57,59 @@ public:
     std::vector<u8> wave_pattern_RAM;
     std::vector<u8> high_RAM;
     std::vector<u8> io_registers;
-    u8 ie_reg;
 
     bool paused;
     bool vram_updated;
-    bool reset_clock;
+
+    /*  Count every write, and every read of a register that can change without a scheduled 
+        event (DIV, TIMA, joypad, serial, APU). Used by the CPU to prove that a loop is idle
+    */
+    u64 write_count;
+    u64 volatile_read_count;
 
     bool audio_trigger[4]; 
     bool reload_audio_counter[4];
 
 private:
+    /*  Every 256-byte page of the address space is either backed by plain memory, in which case 
+        the page holds a host pointer to its first byte, or by memory-mapped IO, in which case 
+        the pointer is null and the handler says which component services the access
+    */
+    enum PageHandler : u8 { CARTRIDGE, VIDEO, OAM, IO, CODE };
+
+    struct ReadPage 
+    {
+        const u8 *mem;
+        PageHandler handler;
+    };
+
+    struct WritePage 
+    {
+        u8 *mem;
+        PageHandler handler;
+    };
+
+    ReadPage read_pages[0x100];
+    WritePage write_pages[0x100];
+
+    u8 read_mmio(PageHandler handler, u16 addr);
+    void write_mmio(PageHandler handler, u16 addr, u8 data);
+
+    void map_page(int page, const u8 *read_mem, u8 *write_mem, PageHandler handler);
+    void map_wram_page(int page);
+    void write_code(u16 addr);
+    void set_code_protection(u16 addr, bool protect);
+
+    BlockCache *block_cache;
+    // WRAM pages (by offset from 0xc000) and HRAM holding cached code
+    bool wram_code[0x20];
+    bool hram_code;
+
     Joypad *joypad;
     Cartridge *cartridge;
     APU *apu;
     GPU *gpu;
+    Timer *timer;
     Interrupts *interrupts;
     
     std::vector<u8> io_read_masks;
@@ -73,4 +131,27 @@ private:
     void dma_transfer(u8 src);
 };
 
+inline u8 Memory::read(u16 addr) 
+{
+    const ReadPage &page = read_pages[addr >> 8];
+    if (page.mem != nullptr) {
+        return page.mem[addr & 0xff];
+    }
+    return read_mmio(page.handler, addr);
+}
+
+inline void Memory::write(u16 addr, u8 data)
+{
+    if (enable_break_pt && addr == break_pt) 
+        paused = true; 
+    write_count++;
+
+    const WritePage &page = write_pages[addr >> 8];
+    if (page.mem != nullptr) {
+        page.mem[addr & 0xff] = data;
+        return;
+    }
+    write_mmio(page.handler, addr, data);
+}
+
 #endif
\ No newline at end of file
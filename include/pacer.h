@@ -0,0 +1,85 @@
+#ifndef PACER_H
+#define PACER_H
+
+#include "definitions.h"
+#include <chrono>
+#include <vector>
+
+/*  Keeps emulation running at the speed of the real hardware by the wall clock. Each call to wait
+    gives the number of cycles emulated so far, and blocks until that much time at 4194304 Hz
+    has passed since timing started. Deadlines are worked out from the start every time rather
+    than added up frame by frame, so rounding never builds up into drift. Falling further behind
+    than MAX_LAG (a pause, the window being dragged) starts timing again from there instead of
+    running flat out to catch up.
+
+    Sleeping can overshoot by as much as a scheduler tick, so the pacer sleeps until shortly
+    before the deadline and yields in a loop for the rest. How long it leaves for that follows
+    how far recent sleeps have overshot.
+
+    With AUDIO sync, the deadlines are nudged a little every frame to keep the audio device's
+    queue near TARGET_AUDIO_FRAMES, so the emulator follows the sound card's clock and never
+    underruns.
+*/
+class Pacer
+{
+public:
+    enum Sync { CYCLES, AUDIO };
+
+    explicit Pacer(Sync sync = CYCLES);
+
+    /*  Block until the wall clock reaches the time cycles (counted since power on) should take.
+        queued_audio is the number of sample frames waiting to play, used with AUDIO sync
+    */
+    void wait(u64 cycles, int queued_audio = 0);
+
+    // Start timing again from the next wait, e.g. after emulation has been paused
+    void reset();
+
+    /*  How far the wall time between consecutive waits strayed from the emulated time between
+        them, as percentiles over every frame since the pacer was created, in milliseconds
+    */
+    struct Jitter
+    {
+        int frames;
+        double mean_frame_ms;
+        double p50;
+        double p90;
+        double p99;
+        double max;
+    };
+    Jitter jitter() const;
+
+    // Summary of a list of frame times, each paired with the time the frame should have taken
+    static Jitter summarize(const std::vector<double> &frame_ms, const std::vector<double> &ideal_ms);
+
+    static const double CLOCK_RATE;
+    static const double FRAME_RATE;
+    static const int TARGET_AUDIO_FRAMES;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Sync sync;
+    bool started;
+    // Wall time at which start_cycles was reached, deadlines are measured from here
+    Clock::time_point start_time;
+    u64 start_cycles;
+
+    Clock::time_point last_time;
+    u64 last_cycles;
+    std::vector<double> frame_ms;
+    std::vector<double> ideal_ms;
+
+    // Recent worst case of sleep overshooting its wake time
+    Clock::duration oversleep;
+
+    void start(Clock::time_point now, u64 cycles);
+    Clock::time_point deadline(u64 cycles) const;
+    void sleep_until(Clock::time_point time);
+
+    static const Clock::duration MAX_LAG;
+    static const Clock::duration MAX_SPIN;
+    static const Clock::duration MAX_AUDIO_CORRECTION;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef PIXEL_FIFO_H
+#define PIXEL_FIFO_H
+
+#include "definitions.h"
+
+class GPU;
+
+/*  Draws one line of the screen a dot (cycle) at a time during mode 3, for the lines where the
+    GPU's whole-line renderer can't be used. The background fetcher reads a tile row every 6 dots
+    into a FIFO, which shifts one pixel out to the screen per dot. Registers are read when each
+    tile is fetched and each pixel is shifted out, so writes part way through the line only change
+    the pixels after them.
+
+    Mode 3 lasts 172 dots for a line with nothing else going on, and is made longer by the pixels
+    discarded for fine horizontal scrolling, restarting the fetcher for the window and pausing it to
+    fetch sprites. Sprites are selected and mixed by the same rules as the whole-line renderer, so a
+    line without mid-line register writes comes out the same either way.
+*/
+class PixelFifo
+{
+public:
+    explicit PixelFifo(GPU *video);
+
+    // Set up for mode 3 of the GPU's current line
+    void start();
+    // Run one dot. Nothing happens once the line is finished
+    void step();
+
+    bool done() const { return x == WIDTH; }
+    // No pixels are shifted out faster than one a dot, so the line can't finish any sooner
+    int min_dots_left() const { return WIDTH - x; }
+
+    // Dots run since start
+    int dots;
+
+private:
+    GPU *gpu;
+
+    static const int WIDTH = 160;
+    static const int FETCH_DOTS = 6;
+    static const int SPRITE_FETCH_DOTS = 6;
+    static const int MAX_SPRITES = 10;
+
+    // Next pixel to be shifted out to the screen
+    int x;
+
+    // Color indices waiting to be shifted out, from pos to the end
+    u8 pixels[8];
+    int pixels_pos;
+    // Background pixels still to be dropped before the first shown, for fine scrolling
+    int discard;
+
+    // Dots into the current tile fetch, starting negative for the fetch wasted at line start
+    int fetch_dot;
+    // Tiles fetched so far, from the left of the background or window
+    int fetch_x;
+    u8 fetched[8];
+
+    bool window;
+    int window_y;
+
+    // Sprites on the line in priority order, and those fetched so far with their row of pixels
+    int sprites[MAX_SPRITES];
+    int num_sprites;
+    bool sprite_fetched[MAX_SPRITES];
+    bool sprite_behind_bg[MAX_SPRITES];
+    bool sprite_palette[MAX_SPRITES];
+    int sprite_x[MAX_SPRITES];
+    u8 sprite_row[MAX_SPRITES][8];
+    // Sprite being fetched and the dots left, while the fetcher and FIFO are paused
+    int sprite_fetch;
+    int sprite_dots;
+
+    void fetch_tile();
+    void fetch_sprite(int n);
+    // Next unfetched sprite starting at x, or -1
+    int sprite_at_x();
+    bool window_starts();
+    void shift_out();
+};
+
+#endif
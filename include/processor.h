@@ -3,30 +3,63 @@
 
 #include <map>
 #include "definitions.h"
+#include "block_cache.h"
+#include "jit.h"
 #include "interrupts.h"
 #include "util.h"
 #include "mmu.h"
+#include "scheduler.h"
 #include "operations.h"
 
 class Processor
 {
 public:
-    Processor(Interrupts *inter, Memory *mem);
+    Processor(Interrupts *inter, Memory *mem, Scheduler *sched);
     void init_state();
+
+    /*  Both advance the scheduler's clock by the cycles taken. step executes (at most) a single 
+        instruction with optional disassembly, for the debugger, and returns the cycles taken.
+        run_until executes instructions back to back until the target time or the next event 
+        deadline is reached, or an access breakpoint is hit.
+    */
     int step(bool print = false);
+    void run_until(u64 target);
+
+    /*  run_until executes code from the block cache when one is attached, falling back to the 
+        interpreter for code it can't cache and around interrupt dispatch
+    */
+    void attach_block_cache(BlockCache *cache);
+    // Blocks run Jit::THRESHOLD times are compiled, if a JIT is attached
+    void attach_jit(Jit *compiler);
+    void run_block(Block *block, u64 target, u64 deadline);
+    // Handler for an opcode whose immediate operand has already been fetched
+    static BlockHandler block_handler(int opcode);
+
+    /*  Flags are evaluated lazily. ALU operations keep Z and C up to date in flag_result and 
+        flag_carry, which is all conditional jumps, ADC, SBC and the rotates read, and record 
+        what they did in flag_op, flag_x and flag_y so N and H can be worked out later. F is only 
+        written by sync_flags, when something reads it as a whole - PUSH AF, DAA, the JIT, idle 
+        loop detection or the debugger. Anything writing F directly calls load_flags after.
+    */
     void set_flags(u8 mask, bool b);
-    void update_timer(int cycles);
-    void process_interrupts();
-    void execute(u8 instr);
-    void cb_execute(u8 instr);
+    void sync_flags();
+    void load_flags();
+    // Returns machine cycles taken to dispatch an interrupt, if any
+    int process_interrupts();
+    // Fetch, decode and execute one instruction, returning machine cycles taken
+    int execute_next();
+    // Machine cycles to stay halted for, to reach the given deadline
+    int halt_cycles(u64 deadline);
+    // Called by run_until after a short backward jump, or a jump to itself
+    void skip_idle_loop(u64 deadline);
 
     u8 fetch_byte();
     u16 fetch_word();
 
-    bool zero_flag();         // Z
-    bool subtract_flag();     // N
-    bool half_carry_flag();   // H
-    bool carry_flag();        // C
+    bool zero_flag() { return flag_result == 0; }    // Z
+    bool subtract_flag();                               // N
+    bool half_carry_flag();                             // H
+    bool carry_flag() { return flag_carry; }            // C
 
     bool interrupt_pending();
     
@@ -46,31 +79,56 @@ public:
     u8 &H;
     u8 &L;
 
+    // Last flag-producing operation, and how N and H follow from its operands
+    enum FlagOp : u8 { 
+        FLAGS_SYNCED,   // F is up to date
+        FLAGS_ADD,      // N reset, H from carry into bit 4 of flag_x + flag_y
+        FLAGS_SUB,      // N set, H from borrow into bit 4 of flag_x - flag_y
+        FLAGS_AND,      // N reset, H set
+        FLAGS_CPL,      // N and H set
+        FLAGS_LOGIC     // N and H reset
+    };
+    u8 flag_op;
+    u8 flag_x;
+    u8 flag_y;
+    // Zero flag is set if and only if this is 0
+    u8 flag_result;
+    bool flag_carry;
+
     Memory *memory; 
     Interrupts *interrupts;
+    Scheduler *scheduler;
+    BlockCache *block_cache;
+    Jit *jit;
 
-    reg16 internal_timer;
-    u8 timer_lsb;
-
-    u8 &div_reg;
-    
     bool IME_flag;
     int ei_count;
-    bool cond_taken;
-    int timer_count;
     bool halted;
     bool halt_bug;
 
+    /*  Idle loop detection in run_until - busy waits on LY, STAT, IF, or a flag set by an 
+        interrupt handler are fast-forwarded to the next event. Can be disabled for accuracy 
+        comparisons, and counts the cycles skipped
+    */
+    bool enable_idle_skip;
+    u64 idle_cycles_skipped;
+
+    // CPU state at the head of the last iteration of a possible idle loop
+    u16 idle_head;
+    u16 idle_regs[5];
+    bool idle_ime;
+    u64 idle_start;
+    u64 idle_write_count;
+    u64 idle_volatile_read_count;
+
     static const u8 ZERO = 1 << 7;       
     static const u8 SUBTRACT = 1 << 6;   
     static const u8 HALF_CARRY = 1 << 5; 
     static const u8 CARRY = 1 << 4;      
 
-    static const int instr_cycles[256];
-    static const int instr_cycles_cond[256];
-    static const int cb_instr_cycles[256];
     static const u16 interrupt_addr[5];
-    static const int div_cycles = 256;
+    // Longest backward jump, in bytes, considered as a possible idle loop
+    static const int MAX_IDLE_LOOP_SIZE = 32;
 };    
 
 #endif
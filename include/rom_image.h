@@ -0,0 +1,53 @@
+#ifndef ROM_IMAGE_H
+#define ROM_IMAGE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "definitions.h"
+
+/*  Immutable cartridge ROM contents. Files are memory-mapped read-only, so loading is O(1) in the
+    ROM size and the pages are shared with every other mapping of the same file, including those
+    in other processes. A single RomImage may also be handed to any number of Cartridge instances.
+
+    The image is always a whole number of 16kB banks and at least 2 banks long, with any padding
+    past the end of the file reading as 0. A file that can't be read gives an image of all 0s,
+    with loaded() false.
+*/
+class RomImage
+{
+public:
+    static std::shared_ptr<const RomImage> open(const std::string &file_path);
+    static std::shared_ptr<const RomImage> from_data(const std::vector<u8> &rom);
+
+    ~RomImage();
+
+    RomImage(const RomImage&) = delete;
+    RomImage& operator=(const RomImage&) = delete;
+
+    const u8 *data() const { return bytes; }
+    size_t size() const { return length; }
+    // False if the file couldn't be read
+    bool loaded() const { return file_loaded; }
+
+    static const size_t BANK_SIZE;
+
+private:
+    RomImage();
+
+    static size_t padded_size(size_t file_size);
+    // Image held in memory, padded from rom
+    static std::shared_ptr<RomImage> make(const std::vector<u8> &rom);
+    // Image read into memory, for when the file can't be mapped
+    static std::shared_ptr<const RomImage> load(const std::string &file_path);
+
+    const u8 *bytes;
+    size_t length;
+    bool file_loaded;
+
+    // Length of the memory mapping, 0 if the contents are held in buffer instead
+    size_t mapped_length;
+    std::vector<u8> buffer;
+};
+
+#endif
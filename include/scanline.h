@@ -0,0 +1,43 @@
+#ifndef SCANLINE_H
+#define SCANLINE_H
+
+#include "definitions.h"
+
+/*  Building blocks the PPU draws a scanline with: decoding rows of tile data, and putting a whole
+    line of background and window color indices through the palette at once. The palette pass has
+    SSE2 and AVX2 versions on x86-64, picked at runtime, and a scalar version everywhere, which all
+    give identical results.
+*/
+namespace scanline
+{
+    const int WIDTH = 160;
+
+    // Instruction sets the palette pass can use, from slowest to fastest
+    enum Isa { SCALAR, SSE2, AVX2 };
+
+    // Fastest instruction set supported by this CPU
+    Isa detect();
+
+    // One bit per pixel of a line, pixel i in bit i % 64 of bits[i / 64]
+    struct Mask
+    {
+        u64 bits[3];
+
+        bool test(int i) const { return (bits[i / 64] >> (i % 64)) & 1; }
+        void set(int i) { bits[i / 64] |= (u64)1 << (i % 64); }
+        void clear() { bits[0] = bits[1] = bits[2] = 0; }
+    };
+
+    /*  Decode one row of a tile, 2 bits per pixel spread across 2 bytes, one storing the lower
+        bit and one the upper, with the leftmost pixel in the highest bit. Writes 8 color indices,
+        leftmost first
+    */
+    void decode_row(u8 lsb, u8 msb, u8 *out);
+
+    /*  Look up each of the WIDTH color indices in the 4 entry palette, writing the results to out,
+        and set opaque for every pixel whose color index isn't 0. isa must be supported
+    */
+    void compose(Isa isa, const u8 *colors, const u8 *palette, u8 *out, Mask &opaque);
+}
+
+#endif
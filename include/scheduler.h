@@ -0,0 +1,67 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "definitions.h"
+
+/*  Global event scheduler. Time is counted in CPU clock cycles (4194304 Hz) since power on, and 
+    every component that needs to do work at a particular time schedules an event for it rather 
+    than being stepped after every instruction. The CPU then only has to run until the earliest
+    deadline before control returns to the event handlers.
+
+    Each event type is scheduled at most once at a time, so events are kept in a small binary 
+    min-heap indexed by event type, which makes rescheduling and cancelling O(log n).
+*/
+class Scheduler
+{
+public:
+    enum Event {
+        // PPU mode transition (OAM -> VRAM -> HBLANK -> OAM/VBLANK ...)
+        PPU_MODE,
+        // TIMA overflow
+        TIMER,
+        // APU frame sequencer step, 512 Hz
+        APU_FRAME_SEQUENCER,
+        // OAM DMA transfer complete
+        DMA_END,
+        // End of the cycle budget for one frame, for when the PPU isn't producing frames
+        FRAME_END,
+        NUM_EVENTS
+    };
+
+    Scheduler();
+
+    // (Re)schedule an event at an absolute time, replacing any earlier deadline for it
+    void schedule(Event event, u64 time);
+    void cancel(Event event);
+    bool scheduled(Event event) const;
+
+    // Time of the earliest event, or never if nothing is scheduled
+    u64 next_deadline() const { return heap_size > 0 ? heap[0].time : NEVER; }
+
+    // Remove and return the earliest event if it is due at or before now, otherwise NUM_EVENTS
+    Event pop_due();
+
+    // Current time. Advanced by the CPU as it executes instructions
+    u64 now;
+
+    static const u64 NEVER;
+
+private:
+    struct Entry
+    {
+        u64 time;
+        Event event;
+    };
+
+    void sift_up(int index);
+    void sift_down(int index);
+    void swap_entries(int a, int b);
+    void remove(int index);
+
+    Entry heap[NUM_EVENTS];
+    int heap_size;
+    // Position of each event in the heap, or -1 if not scheduled
+    int position[NUM_EVENTS];
+};
+
+#endif
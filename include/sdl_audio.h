@@ -0,0 +1,23 @@
+#ifndef SDL_AUDIO_H
+#define SDL_AUDIO_H
+
+#include "audio_sink.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_audio.h>
+
+// Plays audio through the default SDL audio device
+class SDLAudio : public AudioSink
+{
+public:
+    SDLAudio();
+    ~SDLAudio();
+
+    void start() override;
+    int queue_samples(const i16 *samples, int num_frames) override;
+
+private:
+    SDL_AudioDeviceID device_id;
+    SDL_AudioSpec spec;
+};
+
+#endif
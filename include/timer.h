@@ -0,0 +1,49 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "definitions.h"
+#include "interrupts.h"
+#include "scheduler.h"
+
+/*  Divider and timer registers (0xff04 - 0xff07). Both are derived from the current time when 
+    read. DIV is the upper byte of a 16 bit counter incremented every cycle, and TIMA increments on
+    each falling edge of the counter bit selected by TAC, ANDed with the timer enable, so it is 
+    counted up from the last time it was written. Only TIMA overflowing is scheduled as an event, 
+    so no work is done between overflows.
+
+    Since the edge is taken after the AND, resetting the counter by writing DIV, or changing TAC, 
+    while the selected bit is set increments TIMA as well.
+*/
+class Timer
+{
+public:
+    Timer(Interrupts *inter, Scheduler *sched);
+
+    u8 read(u16 addr);
+    void write(u16 addr, u8 data);
+
+    // Handle TIMER event - reload TIMA from TMA and request an interrupt
+    void overflow();
+
+private:
+    // Bring tima up to date with the current time
+    void update();
+    void increment();
+    // Whether the selected counter bit ANDed with the enable is set
+    bool signal();
+    void schedule_overflow();
+
+    Interrupts *interrupts;
+    Scheduler *scheduler;
+
+    // Time the counter was last reset, by writing DIV
+    u64 div_start;
+    // Time tima was last brought up to date
+    u64 tima_time;
+
+    u8 tima;
+    u8 tma;
+    u8 tac;
+};
+
+#endif
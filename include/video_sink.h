@@ -0,0 +1,18 @@
+#ifndef VIDEO_SINK_H
+#define VIDEO_SINK_H
+
+#include "definitions.h"
+#include "frame_ring.h"
+
+/*  Receives each completed frame from the GPU, 160 x 144 pixels. The frame belongs to the GPU's
+    FrameRing, and is only valid for the duration of the call unless the sink borrows it from
+    there.
+*/
+class VideoSink
+{
+public:
+    virtual ~VideoSink() {}
+    virtual void draw_frame(const Frame &frame) = 0;
+};
+
+#endif
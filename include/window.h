@@ -3,58 +3,102 @@
 
 #include "definitions.h"
 #include "joypad.h"
+#include "frame_ring.h"
+#include "video_sink.h"
 #include <GL/glew.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_opengl.h>
+#include <atomic>
 #include <string>
 #include <map>
+#include <thread>
 
+/*  SDL window showing the emulator's frames, and the source of joypad input. The window and its
+    events belong to the thread that creates it, but the OpenGL context is handed to a render
+    thread, which uploads and draws frames and waits on buffer swaps. draw_frame only borrows the
+    frame from the GPU's FrameRing, hands it over with an atomic exchange and posts a semaphore if
+    the render thread hasn't been woken already, so emulation never waits for the driver, the
+    display or a lock. A frame the render thread hasn't got to yet is replaced by the next one.
 
-class GameWindow 
+    Only OpenGL 3.3 core is needed, which Mesa's llvmpipe software rasterizer provides on machines
+    without a GPU.
+*/
+class GameWindow : public VideoSink
 {
 public:
-    GameWindow(Joypad *pad, int scale = 4, std::string title = "");
+    /*  Frames passed to draw_frame are borrowed from frames. With vsync, buffer swaps on the
+        render thread wait for the display's vertical blank
+    */
+    GameWindow(Joypad *pad, FrameRing *frames, int scale = 4, std::string title = "",
+        bool vsync = false);
 
     ~GameWindow();
 
+    // Whether the window has been closed or escape pressed, as of the last process_input
     bool closed();
 
     bool paused();
 
     bool frame_drawn();
 
+    /*  Handle every SDL event waiting since the last call, passing keys on to the joypad. Events
+        are only seen here, so this should be called regularly but not per instruction
+    */
     void process_input();
 
-    void draw_frame(u8 pixel_buffer[]);
+    void draw_frame(const Frame &frame) override;
+
+    // Whether vsync was asked for and is supported
+    bool vsync() const { return vsync_enabled; }
+
+    // Frames passed to draw_frame that were replaced before the render thread drew them
+    u64 frames_dropped() const { return dropped; }
 
     bool draw;
 
 private:
     Joypad *joypad;
+    FrameRing *frames;
     SDL_Window *sdl_window;
     SDL_GLContext gl_context;
-    SDL_Event event;
     GLuint shader_id;
     GLuint screen_tex;
     GLuint sprite_tex;
     const int window_scale;
     std::map<SDL_Keycode, bool> key_pressed;
+    bool vsync_enabled;
     
     bool pause;
     bool quit;
 
-    // shader uniforms
-    bool background;
-    int scrollx;
-    int scrolly;
-    int tex_type;
+    // Uniform locations, looked up once the shader is linked
+    GLint screen_texture_loc;
+    GLint palette_loc;
+    GLint invert_colors_loc;
     
-    int current_palette;
+    // Changed by input on the window's thread, read by the render thread
+    std::atomic<int> current_palette;
     static const unsigned int color_palettes[9][4];
-    bool invert_colors;
+    std::atomic<bool> invert_colors;
+
+    // Latest frame from draw_frame, until the render thread takes it
+    std::atomic<const Frame *> pending;
+    u64 dropped;
+    std::thread render_thread;
+    std::atomic<bool> rendering;
+    /*  Wakes the render thread for a new frame, a change of colours or to stop. Posted at most
+        once until the render thread wakes and clears wake_posted, so its count stays at 0 or 1
+    */
+    SDL_sem *wakeup;
+    std::atomic<bool> wake_posted;
 
     enum Textures { BACKGROUND, SPRITES, WINDOW };
 
+    void handle_event(const SDL_Event &event);
+    void render_loop();
+    void wake_renderer();
+    void upload(const Frame &frame);
+    void present(int palette, bool invert);
     void compile_shader();
     void init_window(std::string title);
     void init_glcontext();
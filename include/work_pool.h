@@ -0,0 +1,59 @@
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*  Fixed size thread pool with work stealing. Tasks are dealt round robin onto per-worker queues.
+    Workers take from the back of their own queue, and once it's empty steal from the front of the
+    others', so uneven task lengths (e.g. ROMs that run at very different speeds) don't leave
+    threads idle while work remains.
+*/
+class WorkPool
+{
+public:
+    // num_workers <= 0 uses one worker per hardware thread
+    explicit WorkPool(int num_workers = 0);
+    // Finishes all queued tasks before returning
+    ~WorkPool();
+
+    WorkPool(const WorkPool&) = delete;
+    WorkPool& operator=(const WorkPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    // Block until every submitted task has completed
+    void wait();
+
+    int size() const { return workers.size(); }
+
+private:
+    struct Worker
+    {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void run(int index);
+    bool take_task(int index, std::function<void()> &task);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    // Guards the counters below
+    std::mutex state_lock;
+    std::condition_variable task_available;
+    std::condition_variable tasks_done;
+    // Tasks sitting in a queue, and tasks submitted but not yet completed
+    int num_queued;
+    int num_pending;
+    unsigned int next_worker;
+    bool stopping;
+};
+
+#endif
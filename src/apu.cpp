@@ -3,13 +3,13 @@
 #include "util.h"
 #include <iostream>
 #include <cassert>
+#include <cstring>
 #include <algorithm>
 
 
-APU::APU() : 
+APU::APU(Scheduler *sched, AudioSink *sink) : 
     clock{0},
-    frame_clock{0},
-    audio_sampling_clock{0},
+    next_frame_step{0x2000},
     frame_step{0}, 
     master_enable{0}, 
     volume_left{0}, 
@@ -20,6 +20,8 @@ APU::APU() :
     AUDIO_SAMPLE_RATE{48000},
     AMPLITUDE{200},
     LFSR{0},
+    scheduler(sched),
+    audio_sink(sink),
     right_channel_buffer(0x8000, 4194304.0 / 4.0, 48000.0),
     left_channel_buffer(0x8000, 4194304.0 / 4.0, 48000.0)
 {
@@ -32,17 +34,13 @@ APU::APU() :
     for (auto &ch: channels) {
         memset(&ch, 0, sizeof(Channel));
     }
-    setup_sdl();
-}
-
-APU::~APU()
-{
-    SDL_CloseAudioDevice(device_id);
-    SDL_Quit();
+    // Frame sequencer updates at 2^9 Hz, which means 1 tick per 2^13 cpu cycles
+    scheduler->schedule(Scheduler::APU_FRAME_SEQUENCER, next_frame_step);
 }
 
 u8 APU::read(u16 addr) 
 {
+    catch_up(scheduler->now);
     if (addr >= 0xff30) {
         return wave_pattern_RAM[addr - 0xff30];
     }
@@ -56,6 +54,7 @@ u8 APU::read(u16 addr)
 
 void APU::write(u16 addr, u8 data) 
 {
+    catch_up(scheduler->now);
     if (addr >= 0xff30) {
         wave_pattern_RAM[addr - 0xff30] = data;
         return;
@@ -131,40 +130,40 @@ void APU::reset()
     }
 }
 
-void APU::step(int cycles)
+void APU::catch_up(u64 time)
 {
-    for (int i = 0; i < (cycles / 4); i++) {
-        clock += 4;
-        frame_clock += 4;
-        audio_sampling_clock += 4;
-
+    // Waveform generators are clocked every machine cycle
+    for (; clock + 4 <= time; clock += 4) {
         clock_waveform_generators();
+    }
+}
 
-        // Frame sequencer updates at 2^9 Hz, which means 1 tick per 2^13 cpu cycles
-        if (frame_clock >= 0x2000)
-        {
-            frame_clock -= 0x2000;
-            frame_step++;
-            frame_step %= 8;
-
-            if ((frame_step & 1) == 0)
-            {
-                // Length counter clocked at 256 Hz
-                clock_length_counters();
-            }
-            if ((frame_step == 2 || frame_step == 6))
-            {
-                // Frequency counter clocked at 128 Hz
-                clock_freq_sweep();
-            }
-            if (frame_step == 7)
-            {
-                // Volume counter clocked at 64 Hz
-                clock_vol_envelope();
-            }
-            update_status();
-        }
+void APU::step_frame_sequencer()
+{
+    catch_up(next_frame_step);
+
+    frame_step++;
+    frame_step %= 8;
+
+    if ((frame_step & 1) == 0)
+    {
+        // Length counters clocked at 256 Hz
+        clock_length_counters();
+    }
+    if ((frame_step == 2 || frame_step == 6))
+    {
+        // Frequency counter clocked at 128 Hz
+        clock_freq_sweep();
     }
+    if (frame_step == 7)
+    {
+        // Volume counter clocked at 64 Hz
+        clock_vol_envelope();
+    }
+    update_status();
+
+    next_frame_step += 0x2000;
+    scheduler->schedule(Scheduler::APU_FRAME_SEQUENCER, next_frame_step);
 }
 
 void APU::clock_waveform_generators()
@@ -471,21 +470,20 @@ void APU::trigger_channel(int channel_num)
 
 void APU::start()
 {
-    SDL_PauseAudioDevice(device_id, 0);
+    audio_sink->start();
 }
 
 int APU::flush_buffer()
 {   
+    catch_up(scheduler->now);
     int size;
     right_channel_buffer.downsample(right, size);
     left_channel_buffer.downsample(left, size);
-    // std::cout << SDL_GetQueuedAudioSize(device_id) << std::endl;
     for (int i = 0; i < right.size(); i++) {
         output_buffer[2*i] = left[i];
         output_buffer[2*i + 1] = right[i];
     }
-    SDL_QueueAudio(device_id, output_buffer.data(), 2 * size * sizeof(i16));   
-    return SDL_GetQueuedAudioSize(device_id);
+    return audio_sink->queue_samples(output_buffer.data(), size);
 }
 
 void APU::init_registers()
@@ -522,34 +520,3 @@ void APU::init_registers()
         unused_addr[i] = (read_masks.find(i) == read_masks.end());
     }
 }
-
-void APU::setup_sdl()
-{
-    for (int i = 0; i < SDL_GetNumAudioDevices(0); i++)
-    {
-        SDL_Log("%s", SDL_GetAudioDeviceName(i, 0));
-    }
-
-    SDL_AudioSpec obtained;
-    SDL_zero(spec);
-
-    spec.freq = AUDIO_SAMPLE_RATE;
-    spec.format = AUDIO_S16SYS;
-    spec.channels = 2;
-    spec.samples = AUDIO_SAMPLE_RATE / 60;
-    spec.callback = NULL;
-    spec.userdata = NULL;
-
-    if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0)
-    {
-        SDL_Log("Unable to initialize SDL: %s", SDL_GetError());
-    }
-    
-    device_id = SDL_OpenAudioDevice(NULL, 0, &spec, &obtained, 0);
-    spec = obtained;
-    SDL_Log("Audio rate: %d", spec.freq);
-    if (device_id == 0)
-    {
-        SDL_Log("Failed to open audio: %s", SDL_GetError());
-    }
-}
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include "block_cache.h"
+#include "instructions.h"
+#include "mmu.h"
+#include "processor.h"
+#include <algorithm>
+
+namespace
+{
+    bool ends_block(const instr::Instruction &ins)
+    {
+        switch (ins.kind)
+        {
+        case instr::JP:
+        case instr::JR:
+        case instr::CALL:
+        case instr::RET:
+        case instr::RETI:
+        case instr::RST:
+        case instr::HALT:
+        case instr::STOP:
+        // Interrupts may be dispatched after the next instruction
+        case instr::EI:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool writes_memory(const instr::Instruction &ins)
+    {
+        switch (ins.kind)
+        {
+        case instr::LD_MEM:
+            return instr::is_pair(ins.dst);
+        case instr::LD_HIGH:
+        case instr::LD_ABS:
+            return ins.src == instr::A;
+        case instr::LD_NN_SP:
+        case instr::PUSH:
+        case instr::CALL:
+        case instr::RST:
+            return true;
+        case instr::INC:
+        case instr::DEC:
+        case instr::RLC:
+        case instr::RRC:
+        case instr::RL:
+        case instr::RR:
+        case instr::SLA:
+        case instr::SRA:
+        case instr::SWAP:
+        case instr::SRL:
+        case instr::RES:
+        case instr::SET:
+            return ins.dst == instr::MEM;
+        default:
+            return false;
+        }
+    }
+
+    u32 branch_target(const instr::Instruction &ins, u16 next_pc, u16 imm)
+    {
+        switch (ins.kind)
+        {
+        case instr::JP:
+            return ins.src == instr::HL ? Block::NO_TARGET : imm;
+        case instr::JR:
+            return (u16)(next_pc + (i8)imm);
+        case instr::CALL:
+            return imm;
+        case instr::RST:
+            return ins.arg;
+        default:
+            return Block::NO_TARGET;
+        }
+    }
+}
+
+BlockCache::BlockCache(Memory *mem) :
+    generation(0), blocks_built(0), invalidations(0), memory(mem), last_mem{}, last_page{}
+{
+    memory->attach_block_cache(this);
+}
+
+Block *BlockCache::lookup(u16 addr)
+{
+    CodePage *page = code_page(addr);
+    if (page == nullptr) {
+        return nullptr;
+    }
+    if (page->stale) {
+        clear(page);
+    }
+    Block *block = page->blocks[addr & 0xff];
+    if (block == nullptr) {
+        block = build(page, addr);
+    }
+    return block;
+}
+
+Block *BlockCache::successor(Block *block, u16 addr)
+{
+    Block **link;
+    if (addr == block->end) {
+        link = &block->next_fall_through;
+    }
+    else if (addr == block->target) {
+        link = &block->next_target;
+    }
+    else {
+        return lookup(addr);
+    }
+    if (*link == nullptr) {
+        Block *next = lookup(addr);
+        // Pages are invalidated as a whole, so links never point into another page
+        if (next != nullptr && (next->start >> 8) == (block->start >> 8)) {
+            *link = next;
+        }
+        return next;
+    }
+    return *link;
+}
+
+void BlockCache::invalidate(u16 addr)
+{
+    int page = addr >> 8;
+    const u8 *mem = page == 0xff ? memory->high_RAM.data() : memory->read_page_base(addr);
+    // Blocks are freed on next lookup, since the CPU may still be running one of them
+    for (CodePage *code: ram_pages) {
+        if (code->mem == mem) {
+            code->stale = true;
+        }
+    }
+    generation++;
+    invalidations++;
+}
+
+void BlockCache::remap()
+{
+    generation++;
+}
+
+BlockCache::CodePage *BlockCache::code_page(u16 addr)
+{
+    int page = addr >> 8;
+    // HRAM shares its page with the IO registers, so isn't in the MMU's page table
+    const u8 *mem = page == 0xff ? memory->high_RAM.data() : memory->read_page_base(addr);
+    if (last_page[page] != nullptr && last_mem[page] == mem) {
+        return last_page[page];
+    }
+
+    // Only ROM can't change under the cache, and only writes to WRAM and HRAM are tracked
+    bool rom = page < 0x80;
+    bool ram = (page >= 0xc0 && page <= 0xfd) || page == 0xff;
+    if (mem == nullptr || !(rom || ram)) {
+        return nullptr;
+    }
+
+    std::unique_ptr<CodePage> &code = pages[std::make_pair(page, mem)];
+    if (!code) {
+        code.reset(new CodePage());
+        code->mem = mem;
+        code->stale = false;
+        if (ram) {
+            ram_pages.push_back(code.get());
+        }
+    }
+    last_mem[page] = mem;
+    last_page[page] = code.get();
+    return code.get();
+}
+
+Block *BlockCache::build(CodePage *page, u16 addr)
+{
+    // Blocks stay within their page, and HRAM ends before IE at 0xffff
+    u32 limit = (addr >> 8) == 0xff ? 0xffff : (addr & 0xff00) + 0x100;
+
+    std::unique_ptr<Block> block(new Block());
+    block->start = addr;
+    block->target = Block::NO_TARGET;
+    block->cycles_before_last = 0;
+    block->next_fall_through = nullptr;
+    block->next_target = nullptr;
+    block->executions = 0;
+
+    u32 pc = addr;
+    int cycles = 0;
+    while (pc < limit && block->instrs.size() < MAX_BLOCK_SIZE) {
+        int opcode = memory->read(pc);
+        if (opcode == 0xcb) {
+            if (pc + 1 >= limit) {
+                break;
+            }
+            opcode = instr::CB_PREFIX | memory->read(pc + 1);
+        }
+        const instr::Instruction &ins = instr::table[opcode];
+        if (pc + ins.length > limit) {
+            break;
+        }
+        u16 imm = 0;
+        if (opcode < instr::CB_PREFIX && ins.length >= 2) {
+            imm = memory->read(pc + 1);
+            if (ins.length == 3) {
+                imm |= memory->read(pc + 2) << 8;
+            }
+        }
+        u16 next_pc = pc + ins.length;
+        block->instrs.push_back({Processor::block_handler(opcode), imm, next_pc, 
+            writes_memory(ins), (u16)opcode});
+        block->last = pc;
+        block->end = next_pc;
+        block->cycles_before_last = cycles;
+        cycles += ins.cycles;
+        pc = next_pc;
+
+        if (ends_block(ins)) {
+            block->target = branch_target(ins, next_pc, imm);
+            break;
+        }
+    }
+    if (block->instrs.empty()) {
+        // Instruction straddles the end of the page, leave it to the interpreter
+        return nullptr;
+    }
+
+    Block *result = block.get();
+    page->blocks[addr & 0xff] = result;
+    page->storage.push_back(std::move(block));
+    blocks_built++;
+    if ((addr >> 8) >= 0x80) {
+        memory->protect_code(addr);
+    }
+    return result;
+}
+
+void BlockCache::clear(CodePage *page)
+{
+    page->storage.clear();
+    std::fill(std::begin(page->blocks), std::end(page->blocks), nullptr);
+    page->stale = false;
+}
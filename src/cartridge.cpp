@@ -4,220 +4,75 @@
 #include <iostream>
 #include <iterator>
 #include <cerrno>
-#include <cassert>
 #include <cstring>
 #include <algorithm>
 #include <map>
 
-Cartridge::Cartridge(std::string file_name) :
-    mode(0),
-    enable_ram(false),
-    current_rom_bank(1),
-    current_ram_bank(0),
+Cartridge::Cartridge(std::string file_name) : Cartridge(RomImage::open(file_name)) {}
+
+Cartridge::Cartridge(std::shared_ptr<const RomImage> rom) :
     rom_bank_size(0x4000), // 16kB
-    ram_bank_size(0x2000) // 8kB
+    ram_bank_size(0x2000), // 8kB
+    rom_image(rom)
 {
-    utils::load_file(read_only_mem, file_name);
     read_header();
-    if (mbc == MBC3) {
-        clock_registers.resize(5, 0);
-    }
-}
-
-u8 Cartridge::read(u16 addr)
-{
-    if (mbc == NONE) {
-        return none_read(addr);
-    }
-    else if (mbc == MBC1) {
-        return mbc1_read(addr);
-    }
-    else if (mbc == MBC2) {
-        return mbc2_read(addr);
-    }
-    else if (mbc == MBC3) {
-        return mbc3_read(addr);
-    }
-    else if (mbc == MBC5) {
-        return mbc5_read(addr);
-    }
-}
-
-void Cartridge::write(u16 addr, u8 data)
-{
-    if (mbc == NONE) {
-        none_write(addr, data); 
-    }
-    else if (mbc == MBC1) {
-        mbc1_write(addr, data);
-    }
-    else if (mbc == MBC2) {
-        mbc2_write(addr, data);
-    }
-    else if (mbc == MBC3) {  
-        mbc3_write(addr, data);
-    }
-    else if (mbc == MBC5) {
-        mbc5_write(addr, data);
-    }
-}
 
-u8 Cartridge::none_read(u16 addr) 
-{
-    if (addr <= 0x7fff) {
-        return read_only_mem[addr];
-    }
-    else if (addr >= 0xa000 && addr <= 0xbfff) {
-        return 0xff;
+    const u8 *rom_data = rom_image->data();
+    size_t rom_size = rom_image->size();
+    switch (mbc)
+    {
+    case NONE:
+        controller.reset(new NoController(rom_data, rom_size, random_access_mem));
+        break;
+    case MBC1:
+        controller.reset(new MBC1Controller(rom_data, rom_size, random_access_mem));
+        break;
+    case MBC2:
+        controller.reset(new MBC2Controller(rom_data, rom_size, random_access_mem));
+        break;
+    case MBC3:
+        controller.reset(new MBC3Controller(rom_data, rom_size, random_access_mem));
+        break;
+    case MBC5:
+        controller.reset(new MBC5Controller(rom_data, rom_size, random_access_mem));
+        break;
     }
 }
 
-void Cartridge::none_write(u16 addr, u8 data)
-{
-    return;
-}
-
-u8 Cartridge::mbc1_read(u16 addr) 
+u8 Cartridge::read(u16 addr)
 {
     if (addr <= 0x3fff) {
-        if (mode == 0) {
-            return read_only_mem[addr];
-        }
-        else {
-            u8 bank_no = current_rom_bank & 0x60; // 2 msb
-            return read_only_mem[addr + (bank_no & mask_ignore_bits) * rom_bank_size];
-        }
+        return controller->rom0_base[addr];
     }
-    else if (addr >= 0x4000 && addr <= 0x7fff) {
-        return read_only_mem[addr + ((current_rom_bank & mask_ignore_bits)-1) * rom_bank_size];
+    else if (addr <= 0x7fff) {
+        return controller->romx_base[addr - 0x4000];
     }
-    else if (addr >= 0xa000 && addr <= 0xbfff) {
-        addr -= 0xa000;
-        if (!enable_ram || num_ram_banks == 0) {
-            return 0xff;
-        }
-        if (mode == 1) {
-            addr += (current_ram_bank % num_ram_banks) * ram_bank_size;
-        }
-        return random_access_mem[addr];
+    else if (controller->sram_base != nullptr) {
+        return controller->sram_base[addr - 0xa000];
     }
     else {
-        assert(false);
-    }
-}
-
-void Cartridge::mbc1_write(u16 addr, u8 data)
-{
-    if (addr <= 0x1fff) {
-        enable_ram = (data & 0xf) == 0xa;
-    }
-    else if (addr >= 0x2000 && addr <= 0x3fff) {
-        current_rom_bank &= (7 << 5);
-        current_rom_bank |= (0x1f & data);
-        if ((current_rom_bank & 0x1f) == 0) {
-            current_rom_bank++;
-        }
-    }
-    else if (addr >= 0x4000 && addr <= 0x5fff) {
-        current_ram_bank = data & 0x3;
-        current_rom_bank &= (0x1f);
-        current_rom_bank |= (data & 3) << 5;
-        if ((current_rom_bank & 0x1f) == 0) {
-            current_rom_bank++;
-        }
-    }
-    else if (addr >= 0x6000 && addr <= 0x7fff) {
-        mode = (bool)data;
-    }
-    else if (addr >= 0xa000 && addr <= 0xbfff) {
-        addr -= 0xa000;
-        if (!enable_ram || num_ram_banks == 0) {
-            return;
-        }
-        else {
-            if (mode == 1) {
-                addr += (current_ram_bank % num_ram_banks) * ram_bank_size;
-            }
-            random_access_mem[addr] = data;
-        }
-    }
-}
-
-u8 Cartridge::mbc2_read(u16 addr)
-{
-    assert(false);
-    return 0;
-}
-
-void Cartridge::mbc2_write(u16 addr, u8 data)
-{
-    assert(false);
-}
-
-u8 Cartridge::mbc3_read(u16 addr)
-{
-    if (addr <= 0x3fff) {
-        return read_only_mem[addr];
-    }
-    else if (addr >= 0x4000 && addr <= 0x7fff) {
-        return read_only_mem[addr + ((current_rom_bank & mask_ignore_bits) - 1) * rom_bank_size];
-    }
-    else if (addr >= 0xa000 && addr <= 0xbfff) {
-        addr -= 0xa000;
-        if (!enable_ram) { // enables both RAM and RTC
-            return 0xff;
-        }
-        else if (current_ram_bank <= 3) { // Not sure if less than 4 ram banks possible
-            addr += (current_ram_bank % num_ram_banks) * ram_bank_size;
-            return random_access_mem[addr];
-        }
-        else if (current_ram_bank >= 8 && current_ram_bank <= 0xc) {
-            return clock_registers[current_rtc - 8];
-        }
-        else { // Not sure if bank number wraps around like MBC1
-            return 0xff;
-        }
+        return controller->read_ram(addr);
     }
 }
 
-void Cartridge::mbc3_write(u16 addr, u8 data)
+bool Cartridge::write(u16 addr, u8 data)
 {
-    if (addr <= 0x1fff) {
-        enable_ram = (data & 0xf) == 0xa;
-    }
-    else if (addr >= 0x2000 && addr <= 0x3fff) {
-        data &= 0x7f;
-        current_rom_bank = (data == 0) ? 1 : data;
-    }
-    else if (addr >= 0x4000 && addr <= 0x5fff) {
-        current_ram_bank = data % 0xd;
+    if (addr <= 0x7fff) {
+        const u8 *rom0 = controller->rom0_base;
+        const u8 *romx = controller->romx_base;
+        u8 *sram = controller->sram_base;
+        controller->write_control(addr, data);
+        // Games often rewrite the bank they already have selected
+        return controller->rom0_base != rom0 || controller->romx_base != romx
+            || controller->sram_base != sram;
     }
-    else if (addr >= 0x6000 && addr <= 0x7fff) {
-        // Latch clock
+    else if (controller->sram_base != nullptr) {
+        controller->sram_base[addr - 0xa000] = data;
     }
-    else if (addr >= 0xa000 && addr <= 0xbfff) {
-        addr -= 0xa000;
-        if (enable_ram) {
-            if (current_ram_bank <= 3) {
-                addr += (current_ram_bank % num_ram_banks) * ram_bank_size;
-                random_access_mem[addr] = data;
-            }
-            else if (current_ram_bank >= 8 && current_ram_bank <= 0xc) {
-                clock_registers[current_ram_bank - 8] = data;
-            }
-        }
+    else {
+        controller->write_ram(addr, data);
     }
-}
-
-u8 Cartridge::mbc5_read(u16 addr)
-{
-    assert(false);
-    return 0;
-}
-
-void Cartridge::mbc5_write(u16 addr, u8 data)
-{
-    assert(false);
+    return false;
 }
  
 void Cartridge::read_header()
@@ -228,24 +83,16 @@ void Cartridge::read_header()
     u16 TITLE_START = 0x134;
     u16 TITLE_END = 0x142;
        
-    std::map<u8, u8> rom_bank_opts = {{0, 2},  {1, 4}, {2, 8}, {3, 16}, {4, 32}, {5, 64}, {6, 128}, 
-        {0x52, 72}, {0x53, 80}, {0x54, 96}};
+    std::map<u8, int> rom_bank_opts = {{0, 2},  {1, 4}, {2, 8}, {3, 16}, {4, 32}, {5, 64}, {6, 128}, 
+        {7, 256}, {8, 512}, {0x52, 72}, {0x53, 80}, {0x54, 96}};
     std::map<u8, u8> ram_bank_opts = {{0, 0}, {1, 1}, {2, 1}, {3, 4}, {4, 16}, {5, 8}};
     
-    num_rom_banks = rom_bank_opts[read_only_mem[ROM_SIZE]];
-    num_ram_banks = ram_bank_opts[read_only_mem[RAM_SIZE]];
-    set_type(read_only_mem[MBC_TYPE]);
+    const u8 *rom = rom_image->data();
+    num_rom_banks = rom_bank_opts[rom[ROM_SIZE]];
+    num_ram_banks = ram_bank_opts[rom[RAM_SIZE]];
+    set_type(rom[MBC_TYPE]);
     random_access_mem.resize(num_ram_banks * ram_bank_size, 0);
-    auto it = read_only_mem.begin();
-    title = std::string(it + TITLE_START, it + TITLE_END + 1);
-
-    // Determine how many bits are needed to store rom bank numbers
-    mask_ignore_bits = 0x0;
-    int i = 0;
-    while (mask_ignore_bits < (num_rom_banks - 1)) {
-        mask_ignore_bits |= (1 << i);
-        i++;
-    }
+    title = std::string(rom + TITLE_START, rom + TITLE_END + 1);
 }
 
 void Cartridge::set_type(u8 data)
@@ -287,6 +134,11 @@ void Cartridge::set_type(u8 data)
         mbc = MBC5;
         break;
     default:
-        assert(false);
+        // Run it as ROM only, which at least gets as far as the first bank switch
+        std::cout << "Unsupported cartridge type 0x" << std::hex << (int)data << std::dec
+                  << ", running without a memory bank controller" << std::endl;
+        type = "UNKNOWN";
+        mbc = NONE;
+        break;
     }
 }
\ No newline at end of file
@@ -67,6 +67,7 @@ int debug::prompt(std::string msg)
 
 void debug::print_registers(Processor *cpu)
 {
+    cpu->sync_flags();
     std::cout << "AF:\t"  << std::setw(4) << std::setfill('0')
               << std::hex << (int)cpu->AF.value << "\n"
               << "BC:\t"  << std::setw(4) << std::setfill('0')
@@ -0,0 +1,77 @@
+#include "frame_ring.h"
+
+FrameRing::FrameRing(int frame_width, int frame_height) :
+    width(frame_width),
+    height(frame_height),
+    frames_dropped(0),
+    drawing(0),
+    latest(-1)
+{
+    for (int i = 0; i <= NUM_SLOTS; i++) {
+        pixels[i].resize(width * height, 0);
+        frames[i] = {0, 0, pixels[i].data()};
+        state[i] = 0;
+    }
+    state[drawing] = DRAWING;
+}
+
+const Frame *FrameRing::publish(u64 number, u64 cycles)
+{
+    const Frame *finished = nullptr;
+    if (drawing == SPARE) {
+        frames_dropped++;
+    }
+    else {
+        frames[drawing].number = number;
+        frames[drawing].cycles = cycles;
+        // Release makes the pixels and numbers visible to whoever borrows it next
+        state[drawing].store(0, std::memory_order_release);
+        latest.store(drawing, std::memory_order_release);
+        finished = &frames[drawing];
+    }
+    drawing = claim_slot();
+    return finished;
+}
+
+int FrameRing::claim_slot()
+{
+    int newest = latest.load(std::memory_order_relaxed);
+    // Oldest first, so the frames left to borrow are the most recent
+    for (int i = 1; i <= NUM_SLOTS; i++) {
+        int n = (newest + i) % NUM_SLOTS;
+        int free = 0;
+        if (n != newest && state[n].compare_exchange_strong(free, DRAWING,
+                std::memory_order_acquire)) {
+            return n;
+        }
+    }
+    return SPARE;
+}
+
+const Frame *FrameRing::borrow_latest()
+{
+    while (true) {
+        int n = latest.load(std::memory_order_acquire);
+        if (n < 0) {
+            return nullptr;
+        }
+        /*  The GPU may have moved on and started drawing into the slot since latest was read, in
+            which case latest has changed too and is read again
+        */
+        int borrows = state[n].load(std::memory_order_relaxed);
+        if (borrows != DRAWING && state[n].compare_exchange_weak(borrows, borrows + 1,
+                std::memory_order_acquire)) {
+            return &frames[n];
+        }
+    }
+}
+
+void FrameRing::borrow(const Frame *frame)
+{
+    state[slot(frame)].fetch_add(1, std::memory_order_acquire);
+}
+
+void FrameRing::release(const Frame *frame)
+{
+    state[slot(frame)].fetch_sub(1, std::memory_order_release);
+}
@@ -0,0 +1,83 @@
+#include "gameboy.h"
+
+const int GameBoy::CYCLES_PER_FRAME = 70224;
+
+GameBoy::GameBoy(std::shared_ptr<const RomImage> rom, VideoSink *video, AudioSink *audio,
+    const std::string &boot_rom_path) :
+    idle_cycles_last_frame(0),
+    timer(&interrupts, &scheduler),
+    cartridge(rom),
+    apu(&scheduler, audio),
+    gpu(&interrupts, &scheduler, video),
+    memory(&interrupts, &cartridge, &joypad, &apu, &gpu, &timer, !boot_rom_path.empty()),
+    block_cache(&memory),
+    cpu(&interrupts, &memory, &scheduler),
+    jit(&cpu, &memory, &scheduler),
+    frame_budget_done(false)
+{
+    cpu.attach_block_cache(&block_cache);
+    if (jit.supported()) {
+        cpu.attach_jit(&jit);
+    }
+    if (!boot_rom_path.empty()) {
+        memory.load_boot(boot_rom_path);
+    }
+    else {
+        cpu.init_state();
+    }
+}
+
+int GameBoy::step(bool print)
+{
+    int step_cycles = cpu.step(print);
+    handle_events();
+    return step_cycles;
+}
+
+int GameBoy::run_frame()
+{
+    frame_budget_done = false;
+    u64 idle_start = cpu.idle_cycles_skipped;
+    u64 frame_end = scheduler.now + CYCLES_PER_FRAME;
+    scheduler.schedule(Scheduler::FRAME_END, frame_end);
+
+    while (!gpu.frame_drawn && !frame_budget_done) {
+        // Nothing outside the CPU can change before the next deadline
+        cpu.run_until(frame_end);
+        if (memory.pause()) {
+            break;
+        }
+        handle_events();
+    }
+    scheduler.cancel(Scheduler::FRAME_END);
+    idle_cycles_last_frame = cpu.idle_cycles_skipped - idle_start;
+    gpu.frame_drawn = false;
+    return apu.flush_buffer();
+}
+
+void GameBoy::handle_events()
+{
+    Scheduler::Event event;
+    while ((event = scheduler.pop_due()) != Scheduler::NUM_EVENTS) {
+        switch (event)
+        {
+        case Scheduler::PPU_MODE:
+            gpu.update_mode();
+            break;
+        case Scheduler::TIMER:
+            timer.overflow();
+            break;
+        case Scheduler::APU_FRAME_SEQUENCER:
+            apu.step_frame_sequencer();
+            break;
+        case Scheduler::DMA_END:
+            gpu.end_dma();
+            break;
+        case Scheduler::FRAME_END:
+            frame_budget_done = true;
+            break;
+        default:
+            break;
+        }
+    }
+}
@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "audio_sink.h"
+#include "gameboy.h"
+#include "gpu.h"
+#include "headless.h"
+#include "input_movie.h"
+#include "rom_image.h"
+#include "work_pool.h"
+
+/*  Headless batch runner. Runs each ROM for a fixed number of frames, unthrottled and with no
+    window or audio device, spread across a pool of worker threads with one emulator per worker.
+    For every run a hash of the final frame, the frame itself as a PGM image, the wall time, the
+    emulated clock speed and the GPU's background cache hit rate are reported, in the order the
+    ROMs were given. With frame skipping the final frame is still drawn, so its hash is the same
+    as without.
+*/
+
+namespace
+{
+    struct Job
+    {
+        std::string rom_path;
+        std::string movie_path;
+        InputMovie movie;
+        std::string image_path;
+    };
+
+    struct Result
+    {
+        bool ok;
+        bool opened;
+        u64 frame_hash;
+        u64 cycles;
+        u64 idle_cycles;
+        double seconds;
+        // Background and window tiles drawn from the GPU's background cache
+        double bg_hit_rate;
+    };
+
+    void print_usage()
+    {
+        std::cout << "Usage: gb_batch [options] rom...\n"
+                  << "  -f, --frames N       frames to run each ROM for (default 600)\n"
+                  << "  -j, --jobs N         worker threads (default: one per hardware thread)\n"
+                  << "  -m, --movie FILE     input movie applied to every ROM given on the command line\n"
+                  << "  -l, --list FILE      read ROMs from FILE, one per line as: rom [movie]\n"
+                  << "  -o, --output-dir DIR directory for last frame images (default .)\n"
+                  << "  -b, --boot-rom FILE  run the boot ROM first\n"
+                  << "      --no-idle-skip   emulate guest idle loops instead of skipping them\n"
+                  << "      --no-jit         interpret every block instead of compiling hot ones\n"
+                  << "      --frameskip N    skip drawing N frames after each one drawn\n"
+                  << "      --no-render      don't draw any frames, not even the last\n"
+                  << "  -h, --help           show this message\n";
+    }
+
+    /*  FNV-1a, taking rows bottom first as frames used to be stored, so hashes can be compared
+        with those from earlier versions
+    */
+    u64 hash_frame(const u8 *pixels)
+    {
+        const int w = GPU::LCD_WIDTH;
+        u64 hash = 0xcbf29ce484222325;
+        for (int y = GPU::LCD_HEIGHT - 1; y >= 0; y--) {
+            for (int x = 0; x < w; x++) {
+                hash = (hash ^ pixels[y * w + x]) * 0x100000001b3;
+            }
+        }
+        return hash;
+    }
+
+    // Binary greyscale PGM, shade 0 is white
+    bool write_pgm(const std::string &path, const u8 *pixels)
+    {
+        const int w = GPU::LCD_WIDTH;
+        const int h = GPU::LCD_HEIGHT;
+        std::ofstream ofs(path, std::ios_base::out | std::ios_base::binary);
+        ofs << "P5\n" << w << " " << h << "\n255\n";
+        std::vector<char> row(w);
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                row[x] = (char)(255 - 85 * (pixels[y * w + x] & 3));
+            }
+            ofs.write(row.data(), w);
+        }
+        return ofs.good();
+    }
+
+    std::string image_name(const std::string &rom_path, int index)
+    {
+        size_t start = rom_path.find_last_of("/\\");
+        std::string name = rom_path.substr(start == std::string::npos ? 0 : start + 1);
+        size_t ext = name.rfind('.');
+        if (ext != std::string::npos && ext > 0) {
+            name = name.substr(0, ext);
+        }
+        // Prefixed with the job number, as ROMs in different directories may share a name
+        std::ostringstream ss;
+        ss << std::setw(4) << std::setfill('0') << index << "_" << name << ".pgm";
+        return ss.str();
+    }
+
+    Result run_rom(const Job &job, int num_frames, const std::string &boot_rom_path,
+        bool idle_skip, bool use_jit, int frameskip, bool render)
+    {
+        Result result = {false, false, 0, 0, 0, 0.0, 0.0};
+        auto rom = RomImage::open(job.rom_path);
+        if (!rom->loaded()) {
+            return result;
+        }
+        result.opened = true;
+
+        NullVideoSink video;
+        NullAudioSink audio;
+        GameBoy gb(rom, &video, &audio, boot_rom_path);
+        gb.cpu.enable_idle_skip = idle_skip;
+        if (!use_jit) {
+            gb.cpu.attach_jit(nullptr);
+        }
+        if (!render) {
+            gb.gpu.set_render_policy(GPU::RENDER_NEVER);
+        }
+        else if (frameskip > 0) {
+            gb.gpu.set_render_policy(GPU::RENDER_EVERY_NTH, frameskip + 1);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (long frame = 0; frame < num_frames; frame++) {
+            job.movie.apply(&gb.joypad, frame);
+            // The last frame is the one hashed
+            gb.gpu.render_requested = frame == num_frames - 1;
+            gb.run_frame();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        result.seconds = std::chrono::duration<double>(end - start).count();
+        result.cycles = gb.cycles();
+        result.idle_cycles = gb.cpu.idle_cycles_skipped;
+        u64 bg_tiles = gb.gpu.bg_cache_hits + gb.gpu.bg_cache_misses;
+        result.bg_hit_rate = bg_tiles > 0 ? (double)gb.gpu.bg_cache_hits / bg_tiles : 0.0;
+
+        // The last frame drawn is read in place from the GPU, or a blank one if none was drawn
+        const Frame *frame = gb.gpu.frames.borrow_latest();
+        std::vector<u8> blank(frame == nullptr ? GPU::LCD_WIDTH * GPU::LCD_HEIGHT : 0, 0);
+        const u8 *pixels = frame != nullptr ? frame->pixels : blank.data();
+        result.frame_hash = hash_frame(pixels);
+        result.ok = !render || write_pgm(job.image_path, pixels);
+        if (frame != nullptr) {
+            gb.gpu.frames.release(frame);
+        }
+        return result;
+    }
+
+    std::string image_column(const Result &r, const Job &job, bool render)
+    {
+        if (!r.opened) {
+            return "(open failed)";
+        }
+        if (!r.ok) {
+            return "(write failed)";
+        }
+        return render ? job.image_path : "(not drawn)";
+    }
+
+    bool read_list(const std::string &list_path, std::vector<Job> &jobs)
+    {
+        std::ifstream ifs(list_path);
+        if (!ifs.good()) {
+            std::cout << "Error reading ROM list " << list_path << std::endl;
+            return false;
+        }
+        std::string line;
+        while (std::getline(ifs, line)) {
+            std::istringstream fields(line.substr(0, line.find('#')));
+            Job job;
+            if (fields >> job.rom_path) {
+                fields >> job.movie_path;
+                jobs.push_back(job);
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_frames = 600;
+    int num_workers = 0;
+    std::string movie_path;
+    std::string output_dir = ".";
+    std::string boot_rom_path;
+    bool idle_skip = true;
+    bool use_jit = true;
+    int frameskip = 0;
+    bool render = true;
+    std::vector<std::string> list_paths;
+    std::vector<std::string> rom_paths;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "-h" || arg == "--help") {
+            print_usage();
+            return 0;
+        }
+        else if ((arg == "-f" || arg == "--frames") && has_value) {
+            num_frames = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-j" || arg == "--jobs") && has_value) {
+            num_workers = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-m" || arg == "--movie") && has_value) {
+            movie_path = argv[++i];
+        }
+        else if ((arg == "-l" || arg == "--list") && has_value) {
+            list_paths.push_back(argv[++i]);
+        }
+        else if ((arg == "-o" || arg == "--output-dir") && has_value) {
+            output_dir = argv[++i];
+        }
+        else if ((arg == "-b" || arg == "--boot-rom") && has_value) {
+            boot_rom_path = argv[++i];
+        }
+        else if (arg == "--no-idle-skip") {
+            idle_skip = false;
+        }
+        else if (arg == "--no-jit") {
+            use_jit = false;
+        }
+        else if (arg == "--frameskip" && has_value) {
+            frameskip = std::max(std::atoi(argv[++i]), 0);
+        }
+        else if (arg == "--no-render") {
+            render = false;
+        }
+        else if (!arg.empty() && arg[0] == '-') {
+            std::cout << "Unknown or incomplete option " << arg << std::endl;
+            print_usage();
+            return 1;
+        }
+        else {
+            rom_paths.push_back(arg);
+        }
+    }
+
+    std::vector<Job> jobs;
+    for (auto &path: rom_paths) {
+        Job job;
+        job.rom_path = path;
+        job.movie_path = movie_path;
+        jobs.push_back(job);
+    }
+    for (auto &path: list_paths) {
+        if (!read_list(path, jobs)) {
+            return 1;
+        }
+    }
+    if (jobs.empty()) {
+        print_usage();
+        return 1;
+    }
+    for (size_t i = 0; i < jobs.size(); i++) {
+        Job &job = jobs[i];
+        if (!job.movie_path.empty() && !job.movie.load(job.movie_path)) {
+            return 1;
+        }
+        job.image_path = output_dir + "/" + image_name(job.rom_path, i);
+    }
+
+    std::vector<Result> results(jobs.size());
+    auto start = std::chrono::steady_clock::now();
+    {
+        WorkPool pool(num_workers);
+        num_workers = pool.size();
+        for (size_t i = 0; i < jobs.size(); i++) {
+            pool.submit([&, i] {
+                results[i] = run_rom(jobs[i], num_frames, boot_rom_path, idle_skip, use_jit,
+                    frameskip, render);
+            });
+        }
+        pool.wait();
+    }
+    double total_seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "rom\tframe_hash\twall_ms\temulated_mhz\tidle_cycles_per_frame\tbg_cache_hit_pct"
+              << "\timage" << std::endl;
+    u64 total_cycles = 0;
+    int num_failed = 0;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        const Result &r = results[i];
+        total_cycles += r.cycles;
+        if (!r.ok) {
+            num_failed++;
+        }
+        std::cout << jobs[i].rom_path << "\t"
+                  << std::hex << std::setw(16) << std::setfill('0') << r.frame_hash << std::dec
+                  << "\t" << std::fixed << std::setprecision(1) << r.seconds * 1000.0
+                  << "\t" << std::setprecision(2) << (r.opened ? r.cycles / r.seconds / 1e6 : 0.0)
+                  << "\t" << std::setprecision(0) << (double)r.idle_cycles / num_frames
+                  << "\t" << std::setprecision(1) << 100 * r.bg_hit_rate
+                  << "\t" << image_column(r, jobs[i], render) << std::endl;
+    }
+    std::cout << "# runs: " << jobs.size() << ", frames: " << num_frames << ", workers: "
+              << num_workers << ", total: " << std::setprecision(3) << total_seconds << " s, "
+              << std::setprecision(2) << total_cycles / total_seconds / 1e6
+              << " emulated MHz aggregate" << std::endl;
+
+    return num_failed > 0 ? 1 : 0;
+}
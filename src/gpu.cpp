@@ -1,4 +1,5 @@
 #include "gpu.h"
+#include "mmu.h"
 #include "registers.h"
 #include "interrupts.h"
 #include "debug.h"
@@ -13,6 +14,11 @@ const int GPU::BACKGROUND_DIM = 256; // background is 256x256 pixels
 const int GPU::TILE_MAP_DIM = 32; // tile map is 32x32
 const int GPU::TILE_DIM = 8; // tile are 8x8 pixels
 const int GPU::BYTES_PER_TILE = 16;
+const int GPU::NUM_TILES = 384;
+const int GPU::NUM_BACKGROUNDS = 4; // 2 tile maps, 2 tile data addressing modes
+const int GPU::FRAME_CYCLES = 70224; // 154 lines of 456 cycles
+const int GPU::NUM_SPRITES = 40;
+const int GPU::MAX_SPRITES_PER_LINE = 10;
 const u16 GPU::TILE_MAP_0_ADDR = 0x9800;
 const u16 GPU::TILE_MAP_1_ADDR = 0x9c00;
 const u16 GPU::TILE_DATA_0_ADDR = 0x9000;
@@ -20,82 +26,181 @@ const u16 GPU::TILE_DATA_1_ADDR = 0x8000;
 const u16 GPU::VRAM_ADDR = 0x8000;
 const u16 GPU::OAM_ADDR = 0xfe00;
 
-GPU::GPU(Interrupts *inter, GameWindow *win): 
-    interrupts{inter},
-    window(win), 
-    clock(0), 
+GPU::GPU(Interrupts *inter, Scheduler *sched, VideoSink *sink): 
+    frame_drawn(false),
+    compositor(scanline::detect()),
+    always_fifo(false),
+    render_requested(false),
+    bg_cache_hits(0),
+    bg_cache_misses(0),
+    frames(LCD_WIDTH, LCD_HEIGHT),
     line(0),
-    mode(OAM), 
-    frame_drawn(false)
+    mode(HBLANK), 
+    next_mode_change(0),
+    mode_3_start(0),
+    fifo(this),
+    fifo_line(false),
+    render_policy(RENDER_ALWAYS),
+    render_interval(1),
+    frame_count(0),
+    dma_active(false),
+    stat_irq_signal(false),
+    display(sink), 
+    interrupts{inter},
+    scheduler(sched),
+    memory(nullptr),
+    vram_mapped(true)
 {
     video_RAM.resize(0x2000, 0); // 8kB
     sprite_attribute_table.resize(0xa0, 0);
-    screen_texture.resize(LCD_WIDTH * LCD_HEIGHT);
-    transparent.resize(LCD_HEIGHT);
-    for (auto &row: transparent) {
-        row.resize(LCD_WIDTH, 0);
-    }
+    // Stored and flipped copies of each tile, 8 x 8 bytes
+    tile_cache.resize(NUM_TILES * 2 * TILE_DIM * TILE_DIM, 0);
+    tile_dirty.resize(NUM_TILES, true);
+    bg_cache.resize(NUM_BACKGROUNDS * BACKGROUND_DIM * BACKGROUND_DIM, 0);
+    bg_dirty.resize(NUM_BACKGROUNDS * TILE_MAP_DIM, 0xffffffff);
+    bg_changed_tiles.resize(NUM_TILES / 64, 0);
+    line_colors.resize(LCD_WIDTH);
+    line_sprites.resize(LCD_HEIGHT, 0);
     for (int i = 0xff40; i <= 0xff4b; i++) {
         registers[i] = 0;
     }
+    update_LCD_control(0);
+    update_all_line_sprites();
+    start_frame();
+
+    // Display starts off
+    next_mode_change = FRAME_CYCLES;
+    scheduler->schedule(Scheduler::PPU_MODE, next_mode_change);
 }
 
-void GPU::step(unsigned int cycles)
+void GPU::update_mode()
 {
-    clock += cycles;
-
+    if (!LCD_control.enable_display) {
+        // Nothing to draw, but frontends pacing themselves by frame_drawn still get a frame
+        frame_drawn = true;
+        next_mode_change += FRAME_CYCLES;
+        scheduler->schedule(Scheduler::PPU_MODE, next_mode_change);
+        return;
+    }
     switch (mode)
     {
     case OAM:
     // First step in drawing scanline, OAM being scanned and not accessible by CPU
-        if (clock >= 80) {
-            clock -= 80;
-            change_mode(VRAM);
+        change_mode(VRAM);
+        mode_3_start = next_mode_change;
+        if (always_fifo) {
+            run_fifo();
         }
         break;
 
     case VRAM:
-    // Second step of drawing a scanline, VRAM and OAM not accessible by CPU
-        if (clock >= 172) {
-            clock -= 172;
-            // At end of scanline, draw and switch to horizontal blank mode
+    // Second step of drawing a scanline, VRAM and OAM not accessible by CPU. At end of scanline,
+    // draw and switch to horizontal blank mode
+        if (fifo_line) {
+            run_fifo();
+            if (!fifo.done()) {
+                // Mode 3 is longer on this line. Check again when the FIFO could next be done
+                next_mode_change = scheduler->now + fifo.min_dots_left();
+                scheduler->schedule(Scheduler::PPU_MODE, next_mode_change);
+                return;
+            }
+            fifo_line = false;
+            // Horizontal blank makes up for it, so the line still takes 456 cycles
+            next_mode_change = mode_3_start + mode_duration(VRAM);
+        }
+        else if (render_frame) {
             draw_scanline();
-            change_mode(HBLANK);
         }
+        change_mode(HBLANK);
         break;
 
     case HBLANK:
-        if (clock >= 204) {
-            clock -= 204;
-            increment_line();
-            
-            if (line == 144) {
-                // After last line, update the screen and switch to vertical blank mode 
-                window->draw_frame(screen_texture.data());
-                interrupts->set(Interrupts::VBLANK_bit);
-                change_mode(VBLANK);
-                frame_drawn = true;
-            } else {
-                change_mode(OAM);
+        increment_line();
+        if (line == 144) {
+            // After last line, update the screen and switch to vertical blank mode 
+            if (render_frame) {
+                finish_frame();
             }
+            interrupts->set(Interrupts::VBLANK_bit);
+            change_mode(VBLANK);
+            frame_drawn = true;
+        } else {
+            change_mode(OAM);
         }
         break;
 
     case VBLANK:
-        if (clock >= 456) {
-            clock -= 456;
-            increment_line();
-
-            if (line == 154) {
-                line = 0;
-                // Clear bit 0 of interrupt request
-                interrupts->clear(Interrupts::VBLANK_bit);
-                change_mode(OAM);
-            }
+        increment_line();
+        if (line == 154) {
+            line = 0;
+            // Clear bit 0 of interrupt request
+            interrupts->clear(Interrupts::VBLANK_bit);
+            start_frame();
+            change_mode(OAM);
         }
         break;    
     }
     update_STAT_register();
+
+    // Each of the 10 vertical blank lines is a separate event
+    next_mode_change += mode_duration(mode);
+    scheduler->schedule(Scheduler::PPU_MODE, next_mode_change);
+}
+
+void GPU::set_render_policy(RenderPolicy policy, int interval)
+{
+    assert(interval > 0);
+    render_policy = policy;
+    render_interval = interval;
+    frame_count--;
+    start_frame();
+}
+
+void GPU::start_frame()
+{
+    switch (render_policy)
+    {
+    case RENDER_ALWAYS:
+        render_frame = true;
+        break;
+    case RENDER_EVERY_NTH:
+        render_frame = render_requested || (frame_count + 1) % render_interval == 0;
+        break;
+    case RENDER_ON_REQUEST:
+        render_frame = render_requested;
+        break;
+    case RENDER_NEVER:
+        render_frame = false;
+        break;
+    }
+    if (render_frame) {
+        render_requested = false;
+    }
+    frame_count++;
+}
+
+void GPU::finish_frame()
+{
+    // frame_count already includes this frame
+    const Frame *frame = frames.publish(frame_count - 1, scheduler->now);
+    if (frame != nullptr) {
+        display->draw_frame(*frame);
+    }
+}
+
+int GPU::mode_duration(Mode m)
+{
+    switch (m)
+    {
+    case OAM:
+        return 80;
+    case VRAM:
+        return 172;
+    case HBLANK:
+        return 204;
+    default:
+        return 456;
+    }
 }
 
 u8 GPU::read(u16 addr) 
@@ -112,8 +217,8 @@ u8 GPU::read(u16 addr)
     }
     else if (addr >= 0xfe00 && addr <= 0xfe9f) {
         // OAM
-        if ((mode == VRAM || mode == OAM) && LCD_control.enable_display) {
-            // OAM inaccessible during both mode 2 and 3
+        if (((mode == VRAM || mode == OAM) && LCD_control.enable_display) || dma_active) {
+            // OAM inaccessible during both mode 2 and 3, and during DMA
             return 0xff;
         }
         else {
@@ -143,18 +248,41 @@ void GPU::write(u16 addr, u8 data)
             // GPU is accessing VRAM during this period, so inaccessible by CPU during mode 3
             return;
         }
-        video_RAM[addr - 0x8000] = data;
+        u8 &byte = video_RAM[addr - 0x8000];
+        if (byte == data) {
+            return;
+        }
+        byte = data;
+        if (addr < TILE_MAP_0_ADDR) {
+            int tile = (addr - VRAM_ADDR) / BYTES_PER_TILE;
+            tile_dirty[tile] = true;
+            bg_changed_tiles[tile / 64] |= (u64)1 << (tile % 64);
+        }
+        else {
+            // Tile map entry, for both tile data addressing modes
+            int map = addr >= TILE_MAP_1_ADDR;
+            int cell = (addr - TILE_MAP_0_ADDR) % (TILE_MAP_DIM * TILE_MAP_DIM);
+            for (int bg = 2 * map; bg < 2 * map + 2; bg++) {
+                bg_dirty[bg * TILE_MAP_DIM + cell / TILE_MAP_DIM] |= 1u << (cell % TILE_MAP_DIM);
+            }
+        }
     }
     else if (addr >= 0xfe00 && addr <= 0xfe9f) {
         // OAM
-        if ((mode == VRAM || mode == OAM) && LCD_control.enable_display) {
-            // OAM inaccessible during both mode 2 and 3
+        if (((mode == VRAM || mode == OAM) && LCD_control.enable_display) || dma_active) {
+            // OAM inaccessible during both mode 2 and 3, and during DMA
             return;
         }
         sprite_attribute_table[addr - 0xfe00] = data;
+        update_line_sprites((addr - OAM_ADDR) / 4);
     }
     else if (addr >= 0xff40 && addr <= 0xff4b) {
         // Control registers
+        bool affects_drawing = addr != reg::STAT && addr != reg::LY && addr != reg::LYC;
+        if (mode == VRAM && LCD_control.enable_display && affects_drawing) {
+            // Pixels already drawn keep the old value
+            run_fifo();
+        }
         switch (addr) 
         {
         case reg::DMA:
@@ -164,11 +292,27 @@ void GPU::write(u16 addr, u8 data)
             // Lowest 3 bits are read-only
             u8 mask = 0x7;
             data = (data & (~mask)) | (registers[addr] & mask);
+            registers[addr] = data;
+            // Newly enabled interrupt sources may raise the STAT interrupt immediately
+            update_STAT_register();
             break;
         }
-        case reg::LCDC:
+        case reg::LCDC: {
+            bool enable_display = LCD_control.enable_display;
+            bool double_sprite_height = LCD_control.double_sprite_height;
             update_LCD_control(data);
+            if (LCD_control.enable_display && !enable_display) {
+                turn_display_on();
+            }
+            else if (!LCD_control.enable_display && enable_display) {
+                turn_display_off();
+            }
+            update_vram_access();
+            if (LCD_control.double_sprite_height != double_sprite_height) {
+                update_all_line_sprites();
+            }
             break;
+        }
         case reg::BGP:
             for (int i = 0; i < 4; i++) {
                 bg_palette[i] = (data >> (2*i)) & 3;
@@ -192,6 +336,17 @@ void GPU::write(u16 addr, u8 data)
     }
 }
 
+void GPU::run_fifo()
+{
+    if (!fifo_line) {
+        fifo_line = true;
+        fifo.start();
+    }
+    while (!fifo.done() && mode_3_start + fifo.dots < scheduler->now) {
+        fifo.step();
+    }
+}
+
 void GPU::update_STAT_register()
 {
     
@@ -216,11 +371,66 @@ void GPU::update_STAT_register()
     }
 }
 
+void GPU::turn_display_off()
+{
+    // Stopped at the start of line 0 in mode 0, with no STAT interrupts
+    fifo_line = false;
+    line = 0;
+    registers[reg::LY] = 0;
+    change_mode(HBLANK);
+    stat_irq_signal = false;
+
+    // Blank screen, shown once
+    if (render_frame) {
+        for (int y = 0; y < LCD_HEIGHT; y++) {
+            std::fill(screen_row(y), screen_row(y) + LCD_WIDTH, 0);
+        }
+        finish_frame();
+    }
+    next_mode_change = scheduler->now + FRAME_CYCLES;
+    scheduler->schedule(Scheduler::PPU_MODE, next_mode_change);
+}
+
+void GPU::turn_display_on()
+{
+    // Timing starts again from the beginning of line 0
+    line = 0;
+    registers[reg::LY] = 0;
+    bool coincidence_flag = registers[reg::LYC] == 0;
+    registers[reg::STAT] = utils::set_cond(registers[reg::STAT], 2, coincidence_flag);
+    change_mode(OAM);
+    update_STAT_register();
+    start_frame();
+    next_mode_change = scheduler->now + mode_duration(OAM);
+    scheduler->schedule(Scheduler::PPU_MODE, next_mode_change);
+}
+
 void GPU::change_mode(Mode m)
 {
     mode = m;
-    // TODO - If LCD is off, set to 0
     registers[reg::STAT] = (registers[reg::STAT] & ~3) | (int)mode;
+    update_vram_access();
+}
+
+void GPU::attach_memory(Memory *mem) 
+{ 
+    memory = mem; 
+    vram_mapped = vram_accessible();
+}
+
+void GPU::attach_video_sink(VideoSink *sink) { display = sink; }
+
+bool GPU::vram_accessible() { return !(mode == VRAM && LCD_control.enable_display); }
+
+u8 *GPU::vram_data() { return video_RAM.data(); }
+
+void GPU::update_vram_access()
+{
+    bool accessible = vram_accessible();
+    if (memory != nullptr && accessible != vram_mapped) {
+        vram_mapped = accessible;
+        memory->map_video_pages();
+    }
 }
 
 void GPU::increment_line()
@@ -245,162 +455,192 @@ void GPU::update_color_palettes()
     }
 }
 
-u8 GPU::read_pixel(std::vector<u8>::iterator &tile_data, int x, int y, bool invert_y, bool invert_x)
+const u8 *GPU::tile_row(int tile, int y, bool flip_x)
 {
-    // 2 bit data for each pixel spread across 2 bytes, one storing the lower bit and one the upper
-    int byte_ind = 2 * (invert_y ? TILE_DIM - 1 - y : y);
-    u8 lsb = (tile_data[byte_ind] >> (invert_x ? x : TILE_DIM - 1 - x)) & 1;
-    u8 msb = (tile_data[byte_ind + 1] >> (invert_x ? x: TILE_DIM - 1 - x)) & 1;
-    return ((msb << 1) | lsb) & 3;
+    if (tile_dirty[tile]) {
+        decode_tile(tile);
+    }
+    return &tile_cache[((2 * tile + flip_x) * TILE_DIM + y) * TILE_DIM];
 }
 
-void GPU::draw_scanline()
+void GPU::decode_tile(int tile)
 {
-    if (LCD_control.enable_display) {
-        draw_background();
-        draw_window();
-        draw_sprites();
-    }
-    else {
-        // Blank screen
-        for (int i = 0; i < LCD_WIDTH; i++) {
-            draw_pixel(i, line, 0);
-        }
+    const u8 *data = &video_RAM[BYTES_PER_TILE * tile];
+    u8 *pixels = &tile_cache[2 * tile * TILE_DIM * TILE_DIM];
+    u8 *flipped = pixels + TILE_DIM * TILE_DIM;
+    for (int y = 0; y < TILE_DIM; y++) {
+        u8 *row = pixels + TILE_DIM * y;
+        scanline::decode_row(data[2 * y], data[2 * y + 1], row);
+        std::reverse_copy(row, row + TILE_DIM, flipped + TILE_DIM * y);
     }
+    tile_dirty[tile] = false;
 }
 
-void GPU::draw_pixel(int x, int y, int color)
+int GPU::bg_tile(u8 index)
 {
-    assert(y >= 0);
-    assert(y < LCD_HEIGHT);
-    assert(x >= 0);
-    assert(x < LCD_WIDTH);
+    // Signed indices are relative to tile 256, at 0x9000
+    if (LCD_control.signed_tile_map) {
+        return 256 + (i8)index;
+    }
+    return index;
+}
 
-    // OpenGL texture coordinates are bottom-up whereas GB is top-down
-    screen_texture[(LCD_WIDTH * (LCD_HEIGHT - 1 - y)) + x] = color;
+void GPU::draw_scanline()
+{
+    draw_background();
+    draw_window();
+    // The 2-bit pixel data read is the index for the color palette
+    scanline::compose(compositor, line_colors.data(), bg_palette, screen_row(line), bg_opaque);
+    draw_sprites();
 }
 
 void GPU::draw_background()
 {
     // Coordinates of upper left corner of screen on 256 x 256 background
     int x = registers[reg::SCROLLX];
-    int y = registers[reg::SCROLLY];
-    auto tile_data_base = video_RAM.begin() + (LCD_control.tile_data_addr - VRAM_ADDR);
-
-    // Screen-space coordinates are (i, line) 
-    for (int i = 0; i < LCD_WIDTH; i++) {
-        // Pixel coordinates on the 256 x 256 background
-        int bg_x = (x + i) % BACKGROUND_DIM;
-        int bg_y = (y + line) % BACKGROUND_DIM;
-
-        // Coordinates of the tile containing current pixel on the 32 x 32 tile map
-        int tile_map_x = bg_x / TILE_DIM;
-        int tile_map_y = bg_y / TILE_DIM;
-        int tile_map_index = (TILE_MAP_DIM * tile_map_y) + tile_map_x; 
-
-        // Lookup the index for the tile in the tile map
-        int tile_index = video_RAM[LCD_control.bg_tile_map_addr + tile_map_index - VRAM_ADDR];
-        if (LCD_control.signed_tile_map) {
-            tile_index = (i8)tile_index;
-        }
-        // Pixel coordinates within the 8 x 8 tile
-        int tile_x = bg_x % TILE_DIM;
-        int tile_y = bg_y % TILE_DIM;
+    int bg_y = (registers[reg::SCROLLY] + line) % BACKGROUND_DIM;
+    const u8 *row = background_row(LCD_control.bg_tile_map_addr, bg_y, x, LCD_WIDTH);
 
-        auto tile_ptr = tile_data_base + (BYTES_PER_TILE * tile_index);
-        // Background tiles are never inverted on x or y 
-        int color = read_pixel(tile_ptr, tile_x, tile_y, false, false);
-        // The 2-bit pixel data read is the index for the color palette
-        draw_pixel(i, line, bg_palette[color]);
-        transparent[line][i] = color == 0;
-    }
+    // Wraps around to the left edge of the background
+    int first = std::min(LCD_WIDTH, BACKGROUND_DIM - x);
+    std::copy(row + x, row + x + first, line_colors.begin());
+    std::copy(row, row + LCD_WIDTH - first, line_colors.begin() + first);
 }
 
-void GPU::draw_sprites()
+const u8 *GPU::background_row(u16 map_addr, int y, int x, int width)
 {
-    if (!LCD_control.enable_sprites) {
-        return;
+    if (std::any_of(bg_changed_tiles.begin(), bg_changed_tiles.end(), 
+            [](u64 tiles) { return tiles != 0; })) {
+        mark_changed_cells();
     }
+    int bg = 2 * (map_addr == TILE_MAP_1_ADDR) + LCD_control.signed_tile_map;
+
+    // Cells covering the pixels on this row of the tile map, wrapping around past cell 31
+    int num_cells = (x % TILE_DIM + width + TILE_DIM - 1) / TILE_DIM;
+    u64 cells = (((u64)1 << num_cells) - 1) << (x / TILE_DIM);
+    u32 needed = (u32)(cells | cells >> TILE_MAP_DIM);
+    u32 &dirty = bg_dirty[bg * TILE_MAP_DIM + y / TILE_DIM];
+    int num_dirty = __builtin_popcount(dirty & needed);
+    bg_cache_hits += num_cells - num_dirty;
+    bg_cache_misses += num_dirty;
+    for (u32 cell = dirty & needed; cell != 0; cell &= cell - 1) {
+        render_cell(bg, TILE_MAP_DIM * (y / TILE_DIM) + __builtin_ctz(cell));
+    }
+    dirty &= ~needed;
+    return &bg_cache[(bg * BACKGROUND_DIM + y) * BACKGROUND_DIM];
+}
 
-    std::vector<u8>::iterator sprite_data = sprite_attribute_table.begin();
-    int sprite_size = (LCD_control.double_sprite_height ? 2 : 1) * TILE_DIM;
-
-    std::vector<std::pair<int, int>> sprites;
-
-    // Construct a list of the sprites on the current scan line
-    for (int i = 0; i < 40; i++) {
-        // The index of the first byte for the sprite in the sprite attribute table
-        int byte_ind = 4 * i;
-        int y_pos = sprite_data[byte_ind] - 16;
-        int x_pos = sprite_data[byte_ind + 1] - 8;
-
-        // Sprites can be disabled by placing them offscreen (x: -8 to 0, 1)
-        bool offscreen = x_pos == -8 || x_pos >= 160;
-        bool on_current_scanline = (line >= y_pos) && (line < y_pos + sprite_size);
+void GPU::render_cell(int bg, int cell)
+{
+    u8 index = video_RAM[(bg / 2 ? TILE_MAP_1_ADDR : TILE_MAP_0_ADDR) - VRAM_ADDR + cell];
+    // Odd backgrounds use signed tile data addressing
+    int tile = bg % 2 ? 256 + (i8)index : index;
+    u8 *out = &bg_cache[(bg * BACKGROUND_DIM + TILE_DIM * (cell / TILE_MAP_DIM)) * BACKGROUND_DIM 
+        + TILE_DIM * (cell % TILE_MAP_DIM)];
+    // Rows of a tile are stored one after another
+    const u8 *pixels = tile_row(tile, 0, false);
+    for (int y = 0; y < TILE_DIM; y++) {
+        std::copy(pixels + TILE_DIM * y, pixels + TILE_DIM * (y + 1), out + BACKGROUND_DIM * y);
+    }
+}
 
-        if (offscreen || !on_current_scanline) {
-            continue;
+void GPU::mark_changed_cells()
+{
+    const u64 *changed = bg_changed_tiles.data();
+    for (int bg = 0; bg < NUM_BACKGROUNDS; bg++) {
+        const u8 *tile_map = &video_RAM[(bg / 2 ? TILE_MAP_1_ADDR : TILE_MAP_0_ADDR) - VRAM_ADDR];
+        for (int cell = 0; cell < TILE_MAP_DIM * TILE_MAP_DIM; cell++) {
+            int tile = bg % 2 ? 256 + (i8)tile_map[cell] : tile_map[cell];
+            if ((changed[tile / 64] >> (tile % 64)) & 1) {
+                bg_dirty[bg * TILE_MAP_DIM + cell / TILE_MAP_DIM] |= 1u << (cell % TILE_MAP_DIM);
+            }
         }
-        sprites.emplace_back(x_pos, i);
     }
-    // Sprite priority is determined by x coordinate
-    sort(sprites.begin(), sprites.end());
+    std::fill(bg_changed_tiles.begin(), bg_changed_tiles.end(), 0);
+}
 
-    /*  Maximum of 10 sprites are drawn for each scanline. By default sorted by descending x value
-        so draw the last 10 in the list
+int GPU::select_sprites(int sprites[])
+{
+    /*  Sprite priority is determined by x coordinate, then by position in OAM, and a maximum of 10
+        sprites are drawn for each scanline. Sprites on the line are visited in OAM order and 
+        inserted into the list of the 10 with highest priority so far
     */
-    int s = std::max((int)(sprites.size() - 10), 0);
-    for (auto it = sprites.rbegin() + s; it < sprites.rend(); it++) {
-        int byte_ind = it->second * 4;
+    const u8 *sprite_data = sprite_attribute_table.data();
+    int num_sprites = 0;
+    for (u64 on_line = line_sprites[line]; on_line != 0; on_line &= on_line - 1) {
+        int sprite = __builtin_ctzll(on_line);
+        u8 x = sprite_data[4 * sprite + 1];
+        int pos = num_sprites;
+        while (pos > 0 && sprite_data[4 * sprites[pos - 1] + 1] > x) {
+            pos--;
+        }
+        if (pos == MAX_SPRITES_PER_LINE) {
+            continue;
+        }
+        num_sprites = std::min(num_sprites + 1, MAX_SPRITES_PER_LINE);
+        std::copy_backward(sprites + pos, sprites + num_sprites - 1, sprites + num_sprites);
+        sprites[pos] = sprite;
+    }
+    return num_sprites;
+}
 
-        // 4 bytes per sprite
-        int y_pos = sprite_data[byte_ind] - 16;
-        int x_pos = sprite_data[byte_ind + 1] - 8;
-        u8 tile_num = sprite_data[byte_ind + 2];
-        int flags = sprite_data[byte_ind + 3];
+const u8 *GPU::sprite_row(int sprite)
+{
+    // 4 bytes per sprite
+    const u8 *sprite_data = &sprite_attribute_table[4 * sprite];
+    int y_pos = sprite_data[0] - 16;
+    u8 tile_num = sprite_data[2];
+    bool flip_y = utils::bit(sprite_data[3], 6);
+    bool flip_x = utils::bit(sprite_data[3], 5);
+
+    int pixel_y = line - y_pos;
+    if (LCD_control.double_sprite_height) {
+        /*  For double-tile sprites, lower tile is found by ignoring the first bit of the
+            tile number and the lower by setting the first bit
+        */
+        u8 upper_tile_index = tile_num & 0xfe;
+        u8 lower_tile_index = tile_num | 1;
+
+        bool upper = pixel_y < 8;
+        if (upper) {
+            // Also have to invert the tile order for double-height sprites
+            tile_num = flip_y ? lower_tile_index : upper_tile_index;
+        }
+        else {
+            tile_num = flip_y ? upper_tile_index : lower_tile_index;
+            pixel_y -= 8;
+        }
+    }
+    return tile_row(tile_num, flip_y ? TILE_DIM - 1 - pixel_y : pixel_y, flip_x);
+}
 
-        bool behind_bg = utils::bit(flags, 7);
-        bool flip_y = utils::bit(flags, 6);
-        bool flip_x = utils::bit(flags, 5);
-        bool palette_num = utils::bit(flags, 4);
+void GPU::draw_sprites()
+{
+    if (!LCD_control.enable_sprites) {
+        return;
+    }
+    int sprites[MAX_SPRITES_PER_LINE];
+    int num_sprites = select_sprites(sprites);
+
+    // Drawn highest priority first, and each pixel only by the first sprite to draw there
+    scanline::Mask drawn;
+    drawn.clear();
+    u8 *out = screen_row(line);
+    for (int n = 0; n < num_sprites; n++) {
+        const u8 *sprite_data = &sprite_attribute_table[4 * sprites[n]];
+        int x_pos = sprite_data[1] - 8;
+        bool behind_bg = utils::bit(sprite_data[3], 7);
+        bool palette_num = utils::bit(sprite_data[3], 4);
+        const u8 *row = sprite_row(sprites[n]);
 
         // Might start or end in the middle of a tile if partially offscreen
         for (int i = std::max(0, x_pos); i < std::min(LCD_WIDTH, x_pos + TILE_DIM); i++) {
-
-            if (behind_bg && !transparent[line][i]) {
-                continue;
-            }
-
-            int pixel_x = i - x_pos;
-            int pixel_y = line - y_pos;
-            int color;
-            if (LCD_control.double_sprite_height) {
-                /*  For double-tile sprites, lower tile is found by ignoring the first bit of the
-                    tile number and the lower by setting the first bit
-                */
-                u8 upper_tile_index = tile_num & 0xfe;
-                u8 lower_tile_index = tile_num | 1;
-
-                bool upper = pixel_y < 8;
-                if (upper) {
-                    // Also have to invert the tile order for double-height sprites
-                    tile_num = flip_y ? lower_tile_index : upper_tile_index;
-                }
-                else {
-                    tile_num = flip_y ? upper_tile_index : lower_tile_index;
-                    pixel_y -= 8;
-                }
-                auto tile_addr = video_RAM.begin() + (BYTES_PER_TILE * tile_num);
-                color = read_pixel(tile_addr, pixel_x, pixel_y, flip_y, flip_x);
-            }
-            else {
-                auto tile_addr = video_RAM.begin() + (BYTES_PER_TILE * tile_num);
-                color = read_pixel(tile_addr, pixel_x, pixel_y, flip_y, flip_x);
-            }
-            if (color == 0) {
+            int color = row[i - x_pos];
+            if (color == 0 || drawn.test(i) || (behind_bg && bg_opaque.test(i))) {
                 continue;
             }
-            draw_pixel(i, line, sprite_palette[palette_num][color]);
+            out[i] = sprite_palette[palette_num][color];
+            drawn.set(i);
         }        
     }
 }
@@ -413,35 +653,16 @@ void GPU::draw_window()
     // Screen-space coordinates of the window's upper left corner
     int x = registers[reg::WX] - 7;
     int y = registers[reg::WY];
-    if (y > line) {
+    if (y > line || x >= LCD_WIDTH) {
         // Window not visible on current scanline
         return;
     }
-    auto tile_data = video_RAM.begin() + (LCD_control.tile_data_addr - VRAM_ADDR);
-    // (i, line) are the screen space pixel coordinates
-    for (int i = std::max(x, 0); i < LCD_WIDTH; i++) {
-        // Window-space coordinates of the current pixel, translated left/up as window moves
-        int window_x = i - x;
-        int window_y = line - y;
-
-        // Coordinates of the tile containing current pixel in 32 x 32 tile map
-        int tile_map_x = window_x / TILE_DIM;
-        int tile_map_y = window_y / TILE_DIM;
-        int tile_map_index = (TILE_MAP_DIM * tile_map_y) + tile_map_x; 
-
-        int tile_index = video_RAM[LCD_control.win_tile_map_addr + tile_map_index - VRAM_ADDR];        
-        if (LCD_control.signed_tile_map) {
-            tile_index = (i8)tile_index;
-        }
-        // Coordinates of the pixel within the 8 x 8 tile
-        int tile_x = window_x % TILE_DIM;
-        int tile_y = window_y % TILE_DIM;
-
-        auto tile_ptr = tile_data + (BYTES_PER_TILE * tile_index);
-        int color = read_pixel(tile_ptr, tile_x, tile_y, false, false);
-        draw_pixel(i, line, bg_palette[color]);
-        transparent[line][i] = color == 0;
-    }
+    // Window-space x of the first pixel on screen, which may be partway into a tile
+    int start = std::max(x, 0);
+    int window_x = start - x;
+    const u8 *row = background_row(LCD_control.win_tile_map_addr, line - y, window_x, 
+        LCD_WIDTH - start);
+    std::copy(row + window_x, row + window_x + LCD_WIDTH - start, line_colors.begin() + start);
 }
 
 /*  From Pan Docs:
@@ -454,6 +675,32 @@ void GPU::draw_window()
         Bit 1 - OBJ (Sprite) Display Enable    (0=Off, 1=On)
         Bit 0 - BG/Window Display/Priority     (0=Off, 1=On) 
 */
+void GPU::update_line_sprites(int sprite)
+{
+    int y_pos = sprite_attribute_table[4 * sprite] - 16;
+    int x_pos = sprite_attribute_table[4 * sprite + 1] - 8;
+    int sprite_size = (LCD_control.double_sprite_height ? 2 : 1) * TILE_DIM;
+
+    // Sprites can be disabled by placing them offscreen (x: -8 to 0, 1)
+    bool offscreen = x_pos == -8 || x_pos >= LCD_WIDTH;
+    u64 bit = (u64)1 << sprite;
+    for (int y = 0; y < LCD_HEIGHT; y++) {
+        if (!offscreen && y >= y_pos && y < y_pos + sprite_size) {
+            line_sprites[y] |= bit;
+        }
+        else {
+            line_sprites[y] &= ~bit;
+        }
+    }
+}
+
+void GPU::update_all_line_sprites()
+{
+    for (int sprite = 0; sprite < NUM_SPRITES; sprite++) {
+        update_line_sprites(sprite);
+    }
+}
+
 void GPU::update_LCD_control(u8 byte)
 {
     LCD_control.enable_display = (byte >> 7) & 1;
@@ -471,4 +718,10 @@ void GPU::dma_transfer(std::vector<u8>::iterator src)
 {
     // 40 tiles - each tiles has 4 bytes
     std::copy(src, src + 0xa0, sprite_attribute_table.begin());
-}
\ No newline at end of file
+    update_all_line_sprites();
+    // Transfer takes 160 machine cycles
+    dma_active = true;
+    scheduler->schedule(Scheduler::DMA_END, scheduler->now + 640);
+}
+
+void GPU::end_dma() { dma_active = false; }
\ No newline at end of file
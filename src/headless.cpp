@@ -0,0 +1,20 @@
+#include "headless.h"
+#include <algorithm>
+
+void NullVideoSink::draw_frame(const Frame &/*frame*/) {}
+
+int NullAudioSink::queue_samples(const i16 */*samples*/, int /*num_frames*/) { return 0; }
+
+BufferVideoSink::BufferVideoSink() : last_frame(160 * 144, 0), num_frames(0) {}
+
+void BufferVideoSink::draw_frame(const Frame &frame)
+{
+    std::copy(frame.pixels, frame.pixels + last_frame.size(), last_frame.begin());
+    num_frames++;
+}
+
+int BufferAudioSink::queue_samples(const i16 *data, int num_frames)
+{
+    samples.insert(samples.end(), data, data + 2 * num_frames);
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include "input_movie.h"
+#include "util.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    // Indexed by Joypad key number
+    const std::string button_names[8] = {
+        "right", "left", "up", "down", "a", "b", "select", "start"
+    };
+}
+
+InputMovie::InputMovie() {}
+
+bool InputMovie::load(const std::string &file_path)
+{
+    std::ifstream ifs(file_path);
+    if (!ifs.good()) {
+        std::cout << "Error reading movie " << file_path << std::endl;
+        return false;
+    }
+    std::stringstream text;
+    text << ifs.rdbuf();
+    return parse(text.str());
+}
+
+bool InputMovie::parse(const std::string &text)
+{
+    entries.clear();
+    std::istringstream lines(text);
+    std::string line;
+    int line_num = 0;
+
+    while (std::getline(lines, line)) {
+        line_num++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        long frame;
+        std::string names;
+        if (!(fields >> frame)) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+            std::cout << "Movie line " << line_num << ": expected frame number" << std::endl;
+            return false;
+        }
+        if (!(fields >> names)) {
+            std::cout << "Movie line " << line_num << ": expected buttons" << std::endl;
+            return false;
+        }
+        if (!entries.empty() && frame <= entries.back().frame) {
+            std::cout << "Movie line " << line_num << ": frames out of order" << std::endl;
+            return false;
+        }
+
+        u8 held = 0;
+        if (names != "-") {
+            utils::to_lower(names);
+            std::istringstream buttons(names);
+            std::string name;
+            while (std::getline(buttons, name, '+')) {
+                int key = std::find(button_names, button_names + 8, name) - button_names;
+                if (key == 8) {
+                    std::cout << "Movie line " << line_num << ": unknown button " << name 
+                              << std::endl;
+                    return false;
+                }
+                held |= 1 << key;
+            }
+        }
+        entries.push_back({frame, held});
+    }
+    return true;
+}
+
+u8 InputMovie::buttons(long frame) const
+{
+    // Entries are in frame order, the one in effect is the last at or before frame
+    auto next = std::upper_bound(entries.begin(), entries.end(), frame,
+        [](long f, const Entry &entry) { return f < entry.frame; });
+    return next == entries.begin() ? 0 : (next - 1)->buttons;
+}
+
+void InputMovie::apply(Joypad *pad, long frame) const
+{
+    u8 held = buttons(frame);
+    for (int key = 0; key < 8; key++) {
+        if (utils::bit(held, key)) {
+            pad->press_key(key);
+        }
+        else {
+            pad->release_key(key);
+        }
+    }
+}
@@ -7,7 +7,7 @@ const u8 Interrupts::TIMER_bit   = 2;
 const u8 Interrupts::SERIAL_bit  = 3;
 const u8 Interrupts::JOYPAD_bit  = 4;
 
-Interrupts::Interrupts() : reg(0) {}
+Interrupts::Interrupts() : reg(0), enable_reg(0), pending_mask(0) {}
 
 u8 Interrupts::read()
 {
@@ -18,14 +18,27 @@ u8 Interrupts::read()
 void Interrupts::write(u8 data)
 {
     reg = data;
+    update_pending();
 }
 
 void Interrupts::set(int bit)
 {
     reg = utils::set(reg, bit);
+    update_pending();
 }
 
 void Interrupts::clear(int bit)
 {
     reg = utils::reset(reg, bit);
+    update_pending();
 }
+
+u8 Interrupts::read_enable() { return enable_reg; }
+
+void Interrupts::write_enable(u8 data)
+{
+    enable_reg = data;
+    update_pending();
+}
+
+void Interrupts::update_pending() { pending_mask = reg & enable_reg & 0x1f; }
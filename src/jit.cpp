@@ -0,0 +1,979 @@
+#include "jit.h"
+#include "instructions.h"
+#include "mmu.h"
+#include "processor.h"
+#include "scheduler.h"
+#include <array>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#include <sys/mman.h>
+#define JIT_X64
+#endif
+
+#ifdef JIT_X64
+
+namespace
+{
+    enum Reg { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+    enum Cond : u8 { JB = 0x2, JAE = 0x3 };
+
+    /*  Just enough of an x86-64 assembler for the translator. 32-bit operations zero the upper
+        half of a register, so guest registers are kept zero-extended in 32-bit host registers and
+        8-bit operations are only done on AL, CL and DL
+    */
+    class Assembler
+    {
+    public:
+        std::vector<u8> bytes;
+
+        void emit(u8 b) { bytes.push_back(b); }
+
+        void emit16(u16 v)
+        {
+            emit(v & 0xff);
+            emit(v >> 8);
+        }
+
+        void emit32(u32 v)
+        {
+            for (int i = 0; i < 4; i++) {
+                emit((v >> (8 * i)) & 0xff);
+            }
+        }
+
+        void emit64(u64 v)
+        {
+            for (int i = 0; i < 8; i++) {
+                emit((v >> (8 * i)) & 0xff);
+            }
+        }
+
+        // REX prefix, if any extended register is used. byte_reg forces one so 4 - 7 address
+        // SPL - DIL rather than AH - BH
+        void rex(bool w, int reg, int rm, bool byte_reg = false)
+        {
+            u8 prefix = 0x40 | (w << 3) | ((reg >> 3) << 2) | (rm >> 3);
+            if (prefix != 0x40 || byte_reg) {
+                emit(prefix);
+            }
+        }
+
+        void modrm(int mod, int reg, int rm) { emit((mod << 6) | ((reg & 7) << 3) | (rm & 7)); }
+
+        // [base + disp32]
+        void mem(int reg, Reg base, i32 disp)
+        {
+            modrm(2, reg, base);
+            if ((base & 7) == RSP) {
+                emit(0x24);
+            }
+            emit32(disp);
+        }
+
+        // 32-bit reg, reg operation - 0x89 mov, 0x01 add, 0x29 sub, 0x21 and, 0x09 or, 0x31 xor
+        void op_rr(u8 op, Reg dst, Reg src)
+        {
+            rex(false, src, dst);
+            emit(op);
+            modrm(3, src, dst);
+        }
+
+        void mov64_rr(Reg dst, Reg src)
+        {
+            rex(true, src, dst);
+            emit(0x89);
+            modrm(3, src, dst);
+        }
+
+        // 32-bit reg, imm operation - 0 add, 1 or, 4 and, 5 sub, 6 xor, 7 cmp
+        void op_ri(int ext, Reg dst, u32 imm)
+        {
+            rex(false, 0, dst);
+            emit(0x81);
+            modrm(3, ext, dst);
+            emit32(imm);
+        }
+
+        // 8-bit operation between two of AL, CL and DL - 0x00 add, 0x10 adc, 0x28 sub, 0x18 sbb,
+        // 0x20 and, 0x08 or, 0x30 xor, 0x38 cmp
+        void op8_rr(u8 op, Reg dst, Reg src)
+        {
+            emit(op);
+            modrm(3, src, dst);
+        }
+
+        void mov_ri(Reg dst, u32 imm)
+        {
+            rex(false, 0, dst);
+            emit(0xb8 + (dst & 7));
+            emit32(imm);
+        }
+
+        void mov_ri64(Reg dst, const void *ptr)
+        {
+            emit(0x48 | (dst >> 3));
+            emit(0xb8 + (dst & 7));
+            emit64((u64)ptr);
+        }
+
+        // movzx dst, src8 - src is AL, CL or DL, or AH (4) with dst below R8
+        void movzx8(Reg dst, int src)
+        {
+            rex(false, dst, 0);
+            emit(0x0f);
+            emit(0xb6);
+            modrm(3, dst, src);
+        }
+
+        void movzx16(Reg dst, Reg src)
+        {
+            rex(false, dst, src);
+            emit(0x0f);
+            emit(0xb7);
+            modrm(3, dst, src);
+        }
+
+        void load8(Reg dst, Reg base, i32 disp)
+        {
+            rex(false, dst, base);
+            emit(0x0f);
+            emit(0xb6);
+            mem(dst, base, disp);
+        }
+
+        // movzx dst, byte [base + index], base not RBP or R13
+        void load8_indexed(Reg dst, Reg base, Reg index)
+        {
+            u8 prefix = 0x40 | ((dst >> 3) << 2) | ((index >> 3) << 1) | (base >> 3);
+            if (prefix != 0x40) {
+                emit(prefix);
+            }
+            emit(0x0f);
+            emit(0xb6);
+            modrm(0, dst, RSP);
+            emit(((index & 7) << 3) | (base & 7));
+        }
+
+        void store8(Reg base, i32 disp, Reg src)
+        {
+            rex(false, src, base, src >= RSP && src <= RDI);
+            emit(0x88);
+            mem(src, base, disp);
+        }
+
+        void load16(Reg dst, Reg base, i32 disp)
+        {
+            rex(false, dst, base);
+            emit(0x0f);
+            emit(0xb7);
+            mem(dst, base, disp);
+        }
+
+        void store16(Reg base, i32 disp, Reg src)
+        {
+            emit(0x66);
+            rex(false, src, base);
+            emit(0x89);
+            mem(src, base, disp);
+        }
+
+        void store16_imm(Reg base, i32 disp, u16 imm)
+        {
+            emit(0x66);
+            rex(false, 0, base);
+            emit(0xc7);
+            mem(0, base, disp);
+            emit16(imm);
+        }
+
+        // inc (ext 0) or dec (ext 1) word [base + disp]
+        void incdec16_mem(int ext, Reg base, i32 disp)
+        {
+            emit(0x66);
+            rex(false, 0, base);
+            emit(0xff);
+            mem(ext, base, disp);
+        }
+
+        // add (ext 0) or sub (ext 5) imm to qword [RAX]
+        void op64_mem_imm(int ext, i32 imm)
+        {
+            emit(0x48);
+            emit(0x81);
+            modrm(0, ext, RAX);
+            emit32(imm);
+        }
+
+        // shl (ext 4) or shr (ext 5)
+        void shift(int ext, Reg r, u8 n)
+        {
+            rex(false, 0, r);
+            emit(0xc1);
+            modrm(3, ext, r);
+            emit(n);
+        }
+
+        // inc (ext 0) or dec (ext 1) a 32-bit register
+        void incdec(int ext, Reg r)
+        {
+            rex(false, 0, r);
+            emit(0xff);
+            modrm(3, ext, r);
+        }
+
+        void bt(Reg r, u8 bit)
+        {
+            rex(false, 0, r);
+            emit(0x0f);
+            emit(0xba);
+            modrm(3, 4, r);
+            emit(bit);
+        }
+
+        void test_ri(Reg r, u32 imm)
+        {
+            rex(false, 0, r);
+            emit(0xf7);
+            modrm(3, 0, r);
+            emit32(imm);
+        }
+
+        // setz of AL, CL or DL
+        void setz(Reg r)
+        {
+            emit(0x0f);
+            emit(0x94);
+            modrm(3, 0, r);
+        }
+
+        void push(Reg r)
+        {
+            if (r >= R8) {
+                emit(0x41);
+            }
+            emit(0x50 + (r & 7));
+        }
+
+        void pop(Reg r)
+        {
+            if (r >= R8) {
+                emit(0x41);
+            }
+            emit(0x58 + (r & 7));
+        }
+
+        void call(const void *fn)
+        {
+            mov_ri64(RAX, fn);
+            emit(0xff);
+            emit(0xd0);
+        }
+
+        // Forward jumps, returning the offset to patch once the target is bound
+        size_t jcc(Cond cond)
+        {
+            emit(0x0f);
+            emit(0x80 + cond);
+            emit32(0);
+            return bytes.size() - 4;
+        }
+
+        size_t jmp()
+        {
+            emit(0xe9);
+            emit32(0);
+            return bytes.size() - 4;
+        }
+
+        void bind(size_t patch)
+        {
+            u32 rel = bytes.size() - (patch + 4);
+            std::memcpy(&bytes[patch], &rel, 4);
+        }
+    };
+
+    // Host registers the guest registers are pinned to, by instr::Operand. C, D and E are
+    // caller-saved so are spilled around calls out
+    const Reg NO_REG = RSP;
+    const Reg host_reg[] = {NO_REG, R12, RBP, R9, R10, R11, R14, R15};
+    const Reg FLAGS = R13;
+    const Reg CPU = RBX;
+    const instr::Operand PINNED[] = {instr::A, instr::B, instr::C, instr::D, instr::E, instr::H,
+        instr::L};
+    const instr::Operand CALLER_SAVED[] = {instr::C, instr::D, instr::E};
+
+    // Z, H and C from LAHF (ZF bit 6, AF bit 4, CF bit 0) in the guest's flag positions
+    const std::array<u8, 256> flag_table = []() {
+        std::array<u8, 256> t{};
+        for (int ah = 0; ah < 256; ah++) {
+            t[ah] = ((ah & 0x40) ? Processor::ZERO : 0) | ((ah & 0x10) ? Processor::HALF_CARRY : 0)
+                | ((ah & 0x01) ? Processor::CARRY : 0);
+        }
+        return t;
+    }();
+
+    u8 read_memory(Memory *memory, u16 addr) { return memory->read(addr); }
+    void write_memory(Memory *memory, u16 addr, u8 data) { memory->write(addr, data); }
+
+    bool is_reg(instr::Operand op) { return op >= instr::A && op <= instr::L; }
+
+    // Whether the instruction can be translated, and for those that can, what they do to flags
+    bool translatable(const instr::Instruction &ins)
+    {
+        using namespace instr;
+        switch (ins.kind)
+        {
+        case NOP:
+        case CPL:
+        case SCF:
+        case CCF:
+        case PUSH:
+        case POP:
+        case LD_MEM:
+        case LD_HIGH:
+        case LD_ABS:
+            return true;
+        case LD:
+            return is_reg(ins.dst) || (ins.dst == SP && ins.src == HL);
+        case LD_IMM:
+            return ins.dst != MEM;
+        case ADD:
+            return ins.dst == A;
+        case ADC:
+        case SUB:
+        case SBC:
+        case AND:
+        case XOR:
+        case OR:
+        case CP:
+            return true;
+        case INC:
+        case DEC:
+        case SWAP:
+        case BIT:
+        case RES:
+        case SET:
+            return ins.dst != MEM;
+        default:
+            return false;
+        }
+    }
+
+    // Sets Z, N, H and C without reading them
+    bool writes_all_flags(const instr::Instruction &ins)
+    {
+        using namespace instr;
+        switch (ins.kind)
+        {
+        case ADD:
+        case SUB:
+        case AND:
+        case XOR:
+        case OR:
+        case CP:
+        case SWAP:
+            return true;
+        case POP:
+            return ins.dst == AF;
+        default:
+            return false;
+        }
+    }
+
+    bool reads_flags(const instr::Instruction &ins)
+    {
+        using namespace instr;
+        switch (ins.kind)
+        {
+        case ADC:
+        case SBC:
+        case INC:
+        case DEC:
+        case CPL:
+        case SCF:
+        case CCF:
+        case BIT:
+            return !is_pair(ins.dst);
+        case PUSH:
+            return ins.dst == AF;
+        default:
+            return false;
+        }
+    }
+
+    // Changes any of Z, N, H or C
+    bool writes_flags(const instr::Instruction &ins)
+    {
+        return writes_all_flags(ins) || (reads_flags(ins) && ins.kind != instr::PUSH);
+    }
+
+    class Translator
+    {
+    public:
+        Translator(Processor *proc, Memory *mem, Scheduler *sched) :
+            cpu(proc), memory(mem), now(&sched->now), pending(0)
+        {
+            for (instr::Operand op: PINNED) {
+                offset[op] = slot(&reg8(op));
+            }
+            offset_f = slot(&cpu->F);
+            offset_sp = slot(&cpu->SP);
+            offset_pc = slot(&cpu->PC);
+        }
+
+        /*  Translate instrs[first, first + count) to a function, with flags_live[i] saying
+            whether instrs[first + i] needs to produce its flags
+        */
+        std::vector<u8> translate(const std::vector<DecodedInstruction> &instrs, int first,
+            int count, const std::vector<bool> &flags_live)
+        {
+            a.bytes.clear();
+            pending = 0;
+
+            // Prologue - save callee-saved registers, keeping the stack aligned for calls
+            for (Reg r: {RBX, RBP, R12, R13, R14, R15}) {
+                a.push(r);
+            }
+            a.emit(0x48); a.emit(0x83); a.emit(0xec); a.emit(0x08); // sub rsp, 8
+            a.mov64_rr(CPU, RDI);
+            for (instr::Operand op: PINNED) {
+                a.load8(host_reg[op], CPU, offset[op]);
+            }
+            a.load8(FLAGS, CPU, offset_f);
+
+            for (int i = 0; i < count; i++) {
+                const DecodedInstruction &d = instrs[first + i];
+                translate(instr::table[d.opcode], d.imm, flags_live[i]);
+                pending += 4 * instr::table[d.opcode].cycles;
+            }
+
+            // Epilogue - write back registers, then PC and the clock
+            for (instr::Operand op: PINNED) {
+                a.store8(CPU, offset[op], host_reg[op]);
+            }
+            a.store8(CPU, offset_f, FLAGS);
+            a.store16_imm(CPU, offset_pc, instrs[first + count - 1].next_pc);
+            a.mov_ri64(RAX, now);
+            a.op64_mem_imm(0, pending);
+
+            a.emit(0x48); a.emit(0x83); a.emit(0xc4); a.emit(0x08); // add rsp, 8
+            for (Reg r: {R15, R14, R13, R12, RBP, RBX}) {
+                a.pop(r);
+            }
+            a.emit(0xc3);
+            return a.bytes;
+        }
+
+    private:
+        u8 &reg8(instr::Operand op)
+        {
+            switch (op)
+            {
+            case instr::A: return cpu->A;
+            case instr::B: return cpu->B;
+            case instr::C: return cpu->C;
+            case instr::D: return cpu->D;
+            case instr::E: return cpu->E;
+            case instr::H: return cpu->H;
+            default: return cpu->L;
+            }
+        }
+
+        i32 slot(const void *field) { return (const u8*)field - (const u8*)cpu; }
+
+        Reg reg(instr::Operand op) { return host_reg[op]; }
+
+        // High and low registers of BC, DE or HL
+        instr::Operand high(instr::Operand pair)
+        {
+            return pair == instr::BC ? instr::B : pair == instr::DE ? instr::D : instr::H;
+        }
+
+        instr::Operand low(instr::Operand pair)
+        {
+            return pair == instr::BC ? instr::C : pair == instr::DE ? instr::E : instr::L;
+        }
+
+        // Pair into dst, zero-extended
+        void load_pair(Reg dst, instr::Operand pair)
+        {
+            if (pair == instr::SP) {
+                a.load16(dst, CPU, offset_sp);
+                return;
+            }
+            a.op_rr(0x89, dst, reg(high(pair)));
+            a.shift(4, dst, 8);
+            a.op_rr(0x09, dst, reg(low(pair)));
+        }
+
+        // Pair from EAX, which holds a 16-bit value
+        void store_pair(instr::Operand pair)
+        {
+            if (pair == instr::SP) {
+                a.store16(CPU, offset_sp, RAX);
+                return;
+            }
+            a.movzx8(reg(low(pair)), RAX);
+            a.op_rr(0x89, reg(high(pair)), RAX);
+            a.shift(5, reg(high(pair)), 8);
+        }
+
+        /*  Call out to Memory, bringing the clock up to the start of the current instruction for
+            the call and back again after, so the cycles still owed don't depend on the path taken
+        */
+        void call_out(const void *fn)
+        {
+            if (pending > 0) {
+                a.mov_ri64(RAX, now);
+                a.op64_mem_imm(0, pending);
+            }
+            for (instr::Operand op: CALLER_SAVED) {
+                a.store8(CPU, offset[op], reg(op));
+            }
+            a.mov_ri64(RDI, memory);
+            a.call(fn);
+            a.movzx8(RAX, RAX);
+            for (instr::Operand op: CALLER_SAVED) {
+                a.load8(reg(op), CPU, offset[op]);
+            }
+            if (pending > 0) {
+                a.mov_ri64(RCX, now);
+                a.emit(0x48); a.emit(0x81); a.modrm(0, 5, RCX); a.emit32(pending); // sub [rcx]
+            }
+        }
+
+        // Read the byte at the address in EAX into EAX. WRAM and HRAM are read directly
+        void read()
+        {
+            a.op_rr(0x89, RCX, RAX);
+            a.op_ri(5, RCX, 0xc000);
+            a.op_ri(7, RCX, 0x2000);
+            size_t not_wram = a.jcc(JAE);
+            a.mov_ri64(RDX, memory->internal_RAM.data());
+            a.load8_indexed(RAX, RDX, RCX);
+            size_t wram_done = a.jmp();
+
+            a.bind(not_wram);
+            a.op_rr(0x89, RCX, RAX);
+            a.op_ri(5, RCX, 0xff80);
+            a.op_ri(7, RCX, 0x7f);
+            size_t not_hram = a.jcc(JAE);
+            a.mov_ri64(RDX, memory->high_RAM.data());
+            a.load8_indexed(RAX, RDX, RCX);
+            size_t hram_done = a.jmp();
+
+            a.bind(not_hram);
+            a.op_rr(0x89, RSI, RAX);
+            call_out((const void*)&read_memory);
+
+            a.bind(wram_done);
+            a.bind(hram_done);
+        }
+
+        // Write ECX to the address in EAX. Writes always go through Memory, which tracks code
+        // protection, breakpoints and the write count
+        void write()
+        {
+            a.op_rr(0x89, RSI, RAX);
+            a.op_rr(0x89, RDX, RCX);
+            call_out((const void*)&write_memory);
+        }
+
+        // Guest flags from the host flags, after an 8-bit operation on AL
+        void host_flags(u8 keep, u8 set)
+        {
+            a.emit(0x9f); // lahf
+            a.movzx8(RAX, 4);
+            a.mov_ri64(RDX, flag_table.data());
+            a.load8_indexed(RAX, RDX, RAX);
+            if (keep & 0xf0) {
+                a.op_ri(4, RAX, ~keep & 0xf0);
+            }
+            a.op_ri(4, FLAGS, keep);
+            a.op_rr(0x09, FLAGS, RAX);
+            if (set) {
+                a.op_ri(1, FLAGS, set);
+            }
+        }
+
+        // Z from the host zero flag, the rest of the high nibble set to set
+        void zero_flag(u8 set)
+        {
+            a.setz(RDX);
+            a.movzx8(RDX, RDX);
+            a.shift(4, RDX, 7);
+            a.op_ri(4, FLAGS, 0x0f);
+            a.op_rr(0x09, FLAGS, RDX);
+            if (set) {
+                a.op_ri(1, FLAGS, set);
+            }
+        }
+
+        // Source operand of an ALU instruction into ECX
+        void alu_operand(const instr::Instruction &ins, u16 imm)
+        {
+            if (ins.src == instr::IMM) {
+                a.mov_ri(RCX, imm & 0xff);
+            }
+            else if (ins.src == instr::MEM) {
+                load_pair(RAX, instr::HL);
+                read();
+                a.op_rr(0x89, RCX, RAX);
+            }
+            else {
+                a.op_rr(0x89, RCX, reg(ins.src));
+            }
+        }
+
+        void translate(const instr::Instruction &ins, u16 imm, bool flags_live)
+        {
+            using namespace instr;
+            Reg A_reg = reg(A);
+
+            switch (ins.kind)
+            {
+            case NOP:
+                break;
+            case LD:
+                if (ins.dst == SP) {
+                    load_pair(RAX, HL);
+                    store_pair(SP);
+                }
+                else {
+                    a.op_rr(0x89, reg(ins.dst), reg(ins.src));
+                }
+                break;
+            case LD_IMM:
+                if (is_pair(ins.dst)) {
+                    a.mov_ri(RAX, imm);
+                    store_pair(ins.dst);
+                }
+                else {
+                    a.mov_ri(reg(ins.dst), imm & 0xff);
+                }
+                break;
+            case LD_MEM:
+                if (is_pair(ins.dst)) {
+                    load_pair(RAX, ins.dst);
+                    if (ins.src == IMM) {
+                        a.mov_ri(RCX, imm & 0xff);
+                    }
+                    else {
+                        a.op_rr(0x89, RCX, reg(ins.src));
+                    }
+                    write();
+                }
+                else {
+                    load_pair(RAX, ins.src);
+                    read();
+                    a.op_rr(0x89, reg(ins.dst), RAX);
+                }
+                if (ins.arg != 0) {
+                    load_pair(RAX, HL);
+                    a.incdec(ins.arg > 0 ? 0 : 1, RAX);
+                    a.movzx16(RAX, RAX);
+                    store_pair(HL);
+                }
+                break;
+            case LD_HIGH:
+            {
+                Operand offset_op = ins.src == A ? ins.dst : ins.src;
+                if (offset_op == IMM) {
+                    a.mov_ri(RAX, 0xff00 + (imm & 0xff));
+                }
+                else {
+                    a.op_rr(0x89, RAX, reg(C));
+                    a.op_ri(1, RAX, 0xff00);
+                }
+                if (ins.src == A) {
+                    a.op_rr(0x89, RCX, A_reg);
+                    write();
+                }
+                else {
+                    read();
+                    a.op_rr(0x89, A_reg, RAX);
+                }
+                break;
+            }
+            case LD_ABS:
+                a.mov_ri(RAX, imm);
+                if (ins.src == A) {
+                    a.op_rr(0x89, RCX, A_reg);
+                    write();
+                }
+                else {
+                    read();
+                    a.op_rr(0x89, A_reg, RAX);
+                }
+                break;
+            case PUSH:
+                for (int half = 0; half < 2; half++) {
+                    a.load16(RAX, CPU, offset_sp);
+                    a.incdec(1, RAX);
+                    a.movzx16(RAX, RAX);
+                    a.store16(CPU, offset_sp, RAX);
+                    if (ins.dst == AF) {
+                        a.op_rr(0x89, RCX, half == 0 ? A_reg : FLAGS);
+                    }
+                    else {
+                        a.op_rr(0x89, RCX, reg(half == 0 ? high(ins.dst) : low(ins.dst)));
+                    }
+                    write();
+                }
+                break;
+            case POP:
+                for (int half = 0; half < 2; half++) {
+                    a.load16(RAX, CPU, offset_sp);
+                    read();
+                    if (ins.dst == AF) {
+                        a.op_rr(0x89, half == 0 ? FLAGS : A_reg, RAX);
+                    }
+                    else {
+                        a.op_rr(0x89, reg(half == 0 ? low(ins.dst) : high(ins.dst)), RAX);
+                    }
+                    a.incdec16_mem(0, CPU, offset_sp);
+                }
+                if (ins.dst == AF) {
+                    a.op_ri(4, FLAGS, 0xf0);
+                }
+                break;
+            case ADD:
+            case ADC:
+            case SUB:
+            case SBC:
+            case CP:
+            {
+                // Host add and subtract set the same half carry and carry as the guest's
+                alu_operand(ins, imm);
+                a.op_rr(0x89, RAX, A_reg);
+                if (ins.kind == ADC || ins.kind == SBC) {
+                    a.bt(FLAGS, 4);
+                }
+                u8 op = ins.kind == ADD ? 0x00 : ins.kind == ADC ? 0x10 : ins.kind == SBC ? 0x18
+                    : ins.kind == SUB ? 0x28 : 0x38;
+                a.op8_rr(op, RAX, RCX);
+                // movzx leaves the host flags alone
+                if (ins.kind != CP) {
+                    a.movzx8(A_reg, RAX);
+                }
+                if (flags_live) {
+                    bool subtract = ins.kind != ADD && ins.kind != ADC;
+                    host_flags(0x0f, subtract ? Processor::SUBTRACT : 0);
+                }
+                break;
+            }
+            case AND:
+            case XOR:
+            case OR:
+            {
+                alu_operand(ins, imm);
+                a.op_rr(0x89, RAX, A_reg);
+                a.op8_rr(ins.kind == AND ? 0x20 : ins.kind == XOR ? 0x30 : 0x08, RAX, RCX);
+                a.movzx8(A_reg, RAX);
+                if (flags_live) {
+                    zero_flag(ins.kind == AND ? Processor::HALF_CARRY : 0);
+                }
+                break;
+            }
+            case INC:
+            case DEC:
+                if (is_pair(ins.dst)) {
+                    if (ins.dst == SP) {
+                        a.incdec16_mem(ins.kind == INC ? 0 : 1, CPU, offset_sp);
+                    }
+                    else {
+                        load_pair(RAX, ins.dst);
+                        a.incdec(ins.kind == INC ? 0 : 1, RAX);
+                        a.movzx16(RAX, RAX);
+                        store_pair(ins.dst);
+                    }
+                }
+                else {
+                    // inc al / dec al leave the host carry alone, as the guest does
+                    a.op_rr(0x89, RAX, reg(ins.dst));
+                    a.emit(0xfe);
+                    a.modrm(3, ins.kind == INC ? 0 : 1, RAX);
+                    a.movzx8(reg(ins.dst), RAX);
+                    host_flags(0x1f, ins.kind == DEC ? Processor::SUBTRACT : 0);
+                }
+                break;
+            case CPL:
+                a.op_ri(6, A_reg, 0xff);
+                a.op_ri(1, FLAGS, Processor::SUBTRACT | Processor::HALF_CARRY);
+                break;
+            case SCF:
+                a.op_ri(4, FLAGS, 0x8f);
+                a.op_ri(1, FLAGS, Processor::CARRY);
+                break;
+            case CCF:
+                a.op_ri(4, FLAGS, 0x9f);
+                a.op_ri(6, FLAGS, Processor::CARRY);
+                break;
+            case SWAP:
+                a.op_rr(0x89, RAX, reg(ins.dst));
+                a.emit(0xc0); a.emit(0xc0); a.emit(0x04); // rol al, 4
+                a.movzx8(reg(ins.dst), RAX);
+                if (flags_live) {
+                    a.op_rr(0x85, RAX, RAX);
+                    zero_flag(0);
+                }
+                break;
+            case BIT:
+                a.test_ri(reg(ins.dst), 1 << ins.arg);
+                a.setz(RDX);
+                a.movzx8(RDX, RDX);
+                a.shift(4, RDX, 7);
+                a.op_ri(4, FLAGS, 0x1f);
+                a.op_rr(0x09, FLAGS, RDX);
+                a.op_ri(1, FLAGS, Processor::HALF_CARRY);
+                break;
+            case RES:
+                a.op_ri(4, reg(ins.dst), ~(1 << ins.arg) & 0xff);
+                break;
+            case SET:
+                a.op_ri(1, reg(ins.dst), 1 << ins.arg);
+                break;
+            default:
+                break;
+            }
+        }
+
+        Processor *cpu;
+        Memory *memory;
+        u64 *now;
+        // Cycles taken by the instructions before the current one
+        int pending;
+
+        Assembler a;
+        i32 offset[instr::L + 1];
+        i32 offset_f;
+        i32 offset_sp;
+        i32 offset_pc;
+    };
+}
+
+Jit::Jit(Processor *proc, Memory *mem, Scheduler *sched) :
+    blocks_compiled(0), instructions_compiled(0), code_used(0), cpu(proc), memory(mem),
+    scheduler(sched), code(nullptr)
+{
+    void *region = mmap(nullptr, CODE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+        -1, 0);
+    if (region == MAP_FAILED) {
+        return;
+    }
+    // Code is never writable and executable at once, so check executable mappings are allowed
+    if (mprotect(region, CODE_SIZE, PROT_READ | PROT_EXEC) != 0) {
+        munmap(region, CODE_SIZE);
+        return;
+    }
+    code = static_cast<u8*>(region);
+}
+
+Jit::~Jit()
+{
+    if (code != nullptr) {
+        munmap(code, CODE_SIZE);
+    }
+}
+
+void Jit::compile(Block *block)
+{
+    if (code == nullptr) {
+        return;
+    }
+    const std::vector<DecodedInstruction> &instrs = block->instrs;
+    Translator translator(cpu, memory, scheduler);
+    std::vector<std::vector<u8>> functions;
+    std::vector<NativeRun> runs;
+
+    size_t i = 0;
+    while (i < instrs.size()) {
+        if (!translatable(instr::table[instrs[i].opcode])) {
+            i++;
+            continue;
+        }
+        // Runs end after their first write, so run_block can recheck events after it
+        size_t first = i;
+        int cycles = 0;
+        int cycles_before_last = 0;
+        while (i < instrs.size() && translatable(instr::table[instrs[i].opcode])) {
+            cycles_before_last = cycles;
+            cycles += instr::table[instrs[i].opcode].cycles;
+            i++;
+            if (instrs[i - 1].writes_memory) {
+                break;
+            }
+        }
+        int count = i - first;
+        if (count < MIN_RUN) {
+            continue;
+        }
+
+        // Flags need producing only if read before being overwritten, or still set at the end
+        std::vector<bool> flags_live(count);
+        bool live = true;
+        bool reads = false;
+        bool writes = false;
+        for (int j = count - 1; j >= 0; j--) {
+            const instr::Instruction &ins = instr::table[instrs[first + j].opcode];
+            flags_live[j] = live;
+            if (writes_all_flags(ins)) {
+                live = false;
+            }
+            if (reads_flags(ins)) {
+                live = true;
+                reads = true;
+            }
+            writes |= writes_flags(ins);
+        }
+        // A run that changes flags needs F on entry unless it overwrites them all first
+        if (writes) {
+            reads = live;
+        }
+
+        functions.push_back(translator.translate(instrs, first, count, flags_live));
+        runs.push_back({nullptr, (u16)first, (u16)count, cycles_before_last,
+            instrs[i - 1].writes_memory, reads, writes});
+    }
+
+    size_t total = 0;
+    for (const std::vector<u8> &f: functions) {
+        total += f.size();
+    }
+    if (runs.empty() || code_used + total > CODE_SIZE) {
+        return;
+    }
+
+    if (mprotect(code, CODE_SIZE, PROT_READ | PROT_WRITE) != 0) {
+        return;
+    }
+    for (size_t r = 0; r < runs.size(); r++) {
+        std::memcpy(code + code_used, functions[r].data(), functions[r].size());
+        runs[r].code = reinterpret_cast<NativeCode>(code + code_used);
+        code_used += functions[r].size();
+        instructions_compiled += runs[r].count;
+    }
+    if (mprotect(code, CODE_SIZE, PROT_READ | PROT_EXEC) != 0) {
+        // Leave the code unused rather than run it from a writable mapping
+        return;
+    }
+    block->native_runs = runs;
+    blocks_compiled++;
+}
+
+#else
+
+Jit::Jit(Processor *proc, Memory *mem, Scheduler *sched) :
+    blocks_compiled(0), instructions_compiled(0), code_used(0), cpu(proc), memory(mem),
+    scheduler(sched), code(nullptr)
+{
+}
+
+Jit::~Jit() {}
+
+void Jit::compile(Block *block) {}
+
+#endif
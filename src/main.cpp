@@ -15,18 +15,16 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_audio.h>
 
-#include "apu.h"
-#include "cartridge.h"
 #include "debug.h"
 #include "definitions.h"
+#include "gameboy.h"
+#include "headless.h"
+#include "pacer.h"
 #include "registers.h"
-#include "processor.h"
-#include "gpu.h"
+#include "rom_image.h"
 #include "window.h"
-#include "joypad.h"
+#include "sdl_audio.h"
 #include "string"
-#include "mmu.h"
-#include "assembly.h"
 
 #define PRINT(x) std::cout << #x": " << std::hex << std::setw(4) << std::setfill('0') << (int)x << std::endl;
 
@@ -42,7 +40,11 @@ int main(int argc, char *argv[])
         ("boot-rom,b", po::value<std::string>(), "provide boot rom")
         ("debug,d", "enable debug mode")
         ("unlock,u", "unlock framerate")
+        ("vsync", "lock the framerate to the display's refresh")
+        ("audio-sync", "lock the framerate to audio playback")
         ("scale,s", po::value<int>(), "resolution scale")
+        ("frameskip", po::value<int>(), "skip drawing N frames after each one drawn")
+        ("no-render", "don't draw any frames")
         ("input-file", po::value<std::string>(), "rom file to load");
     po::positional_options_description p_desc;
     p_desc.add("input-file", -1);
@@ -64,6 +66,8 @@ int main(int argc, char *argv[])
     bool step_instr = false;
     bool unlock_framerate = false;
     int scale = 5;
+    int frameskip = 0;
+    bool render = true;
 
     if (var_map.count("boot-rom")) {
         enable_boot_rom = true;
@@ -79,73 +83,109 @@ int main(int argc, char *argv[])
     if(var_map.count("scale")) {
         scale = var_map["scale"].as<int>();
     }
+    if (var_map.count("frameskip")) {
+        frameskip = std::max(var_map["frameskip"].as<int>(), 0);
+    }
+    if (var_map.count("no-render")) {
+        render = false;
+    }
     
-    Joypad gb_pad;
-    Interrupts interrupt;
-    Cartridge game_cart(cartridge_filename);
-    GameWindow window(&gb_pad, scale, game_cart.title);
-    APU gb_apu;
-    GPU gb_gpu(&interrupt, &window);
-    Memory gb_mem(&interrupt, &game_cart, &gb_pad, &gb_apu, &gb_gpu, enable_boot_rom);
-    Processor gb_cpu(&interrupt, &gb_mem);
-    gb_apu.start();
-
-    std::cout << game_cart.title << std::endl << game_cart.type << std::endl
-              << game_cart.num_ram_banks << " RAM banks" << std::endl
-              << game_cart.num_rom_banks << " ROM banks" << std::endl;
-
-    if (enable_boot_rom) {
-        gb_mem.load_boot(boot_rom_filename.c_str());
-    } 
-    else {
-        gb_cpu.init_state();
+    // The window needs the joypad, frame ring and title, so it is attached once the emulator exists
+    NullVideoSink no_video;
+    SDLAudio audio;
+    GameBoy gb(RomImage::open(cartridge_filename), &no_video, &audio, 
+        enable_boot_rom ? boot_rom_filename : "");
+    GameWindow window(&gb.joypad, &gb.gpu.frames, scale, gb.cartridge.title,
+        var_map.count("vsync") > 0);
+    gb.gpu.attach_video_sink(&window);
+    if (!render) {
+        gb.gpu.set_render_policy(GPU::RENDER_NEVER);
     }
+    else if (frameskip > 0) {
+        gb.gpu.set_render_policy(GPU::RENDER_EVERY_NTH, frameskip + 1);
+    }
+    gb.apu.start();
+
+    std::cout << gb.cartridge.title << std::endl << gb.cartridge.type << std::endl
+              << gb.cartridge.num_ram_banks << " RAM banks" << std::endl
+              << gb.cartridge.num_rom_banks << " ROM banks" << std::endl;
 
     int break_pt = -1;
     int access_break_pt = -1;
 
-    using namespace std::chrono;
-
-    double framerate = 57;
-    duration<double> T(1.0 / framerate);
-    duration<double> dt;
-    steady_clock::time_point t = steady_clock::now();
+    // Swaps happen on the window's render thread, so emulation is still timed by the CPU clock
+    Pacer::Sync sync = Pacer::CYCLES;
+    if (var_map.count("vsync") && !window.vsync()) {
+        std::cout << "Vsync not supported" << std::endl;
+    }
+    if (var_map.count("audio-sync")) {
+        sync = Pacer::AUDIO;
+    }
+    Pacer pacer(sync);
+    // Paced at least once per frame's worth of cycles, even if the PPU isn't producing frames
+    u64 last_paced = 0;
+
+    /*  Input is only looked at between frames, and no more often than POLL_RATE however fast
+        emulation runs, so polling costs the same with the framerate unlocked
+    */
+    const double POLL_RATE = 120;
+    const auto poll_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1 / POLL_RATE));
+    auto last_poll = std::chrono::steady_clock::now() - poll_interval;
 
     while (!window.closed()) {
-        window.process_input();
-
-        if (enable_debug_mode) {
-            if (gb_cpu.PC.value == break_pt || step_instr || gb_mem.pause() || window.paused()) {
-                debug::print_registers(&gb_cpu);
-                if (!debug::menu(&gb_cpu, break_pt, access_break_pt, step_instr)) {
+        bool frame_done = true;
+        if (!enable_debug_mode) {
+            int queued = gb.run_frame();
+            if (!unlock_framerate) {
+                pacer.wait(gb.cycles(), queued);
+            }
+        }
+        else {
+            if (gb.cpu.PC.value == break_pt || step_instr || gb.memory.pause() || window.paused()) {
+                pacer.reset();
+                debug::print_registers(&gb.cpu);
+                if (!debug::menu(&gb.cpu, break_pt, access_break_pt, step_instr)) {
                     break;
                 }
                 if (access_break_pt >= 0) {
-                    gb_mem.set_access_break_pt(access_break_pt);
+                    gb.memory.set_access_break_pt(access_break_pt);
                 }
             }
+            gb.step(step_instr);
+
+            frame_done = gb.gpu.frame_drawn
+                || gb.cycles() - last_paced >= GameBoy::CYCLES_PER_FRAME;
+            if (frame_done) {
+                int queued = gb.apu.flush_buffer();
+                if (!unlock_framerate) {
+                    pacer.wait(gb.cycles(), queued);
+                }
+                last_paced = gb.cycles();
+                gb.gpu.frame_drawn = false;
+            }
         }
 
-        int cycles = gb_cpu.step(step_instr);
-        gb_gpu.step(cycles);
-        gb_apu.step(cycles);
-
-        if (gb_gpu.frame_drawn) {
-            int queued = gb_apu.flush_buffer();
-            auto t_draw = steady_clock::now();
-            dt = duration_cast<duration<double>>(t_draw - t);
-            if ((dt < T) && !unlock_framerate) {
-                milliseconds pause = duration_cast<milliseconds>(T - dt);
-                std::this_thread::sleep_for(pause);
-            } 
-            t = steady_clock::now();
-            gb_gpu.frame_drawn = false;
+        if (frame_done) {
+            auto now = std::chrono::steady_clock::now();
+            if (now - last_poll >= poll_interval) {
+                window.process_input();
+                last_poll = now;
+            }
         }
     }
 
     if (enable_debug_mode) {
-        debug::print_registers(&gb_cpu);
+        debug::print_registers(&gb.cpu);
+    }
+    Pacer::Jitter jitter = pacer.jitter();
+    if (jitter.frames > 0) {
+        std::cout << std::dec << std::fixed << std::setprecision(3) << jitter.frames 
+                  << " frames, mean " << jitter.mean_frame_ms << " ms, frame time error p50 "
+                  << jitter.p50 << " ms, p90 " << jitter.p90 << " ms, p99 " << jitter.p99 
+                  << " ms, max " << jitter.max << " ms" << std::endl;
     }
+    std::cout << window.frames_dropped() << " frames replaced before they were drawn" << std::endl;
 
     return 0;
 }
@@ -0,0 +1,209 @@
+#include "mbc.h"
+
+const int MemoryBankController::ROM_BANK_SIZE = 0x4000; // 16kB
+const int MemoryBankController::RAM_BANK_SIZE = 0x2000; // 8kB
+
+MemoryBankController::MemoryBankController(const u8 *rom, size_t rom_size, std::vector<u8> &ram) :
+    rom0_base(nullptr),
+    romx_base(nullptr),
+    sram_base(nullptr),
+    read_only_mem(rom),
+    random_access_mem(ram),
+    num_rom_banks(rom_size / ROM_BANK_SIZE),
+    num_ram_banks(ram.size() / RAM_BANK_SIZE)
+{
+    select_rom_banks(0, 1);
+}
+
+u8 MemoryBankController::read_ram(u16 /*addr*/)
+{
+    // Disabled or missing RAM reads as open bus
+    return 0xff;
+}
+
+void MemoryBankController::write_ram(u16 /*addr*/, u8 /*data*/) {}
+
+void MemoryBankController::select_rom_banks(int bank0, int bankx)
+{
+    rom0_base = read_only_mem + (bank0 % num_rom_banks) * ROM_BANK_SIZE;
+    romx_base = read_only_mem + (bankx % num_rom_banks) * ROM_BANK_SIZE;
+}
+
+void MemoryBankController::select_ram_bank(bool enable, int bank)
+{
+    if (enable && num_ram_banks > 0) {
+        sram_base = random_access_mem.data() + (bank % num_ram_banks) * RAM_BANK_SIZE;
+    }
+    else {
+        sram_base = nullptr;
+    }
+}
+
+NoController::NoController(const u8 *rom, size_t rom_size, std::vector<u8> &ram) :
+    MemoryBankController(rom, rom_size, ram)
+{
+    // Small amount of RAM may be present without an MBC, and is always enabled
+    select_ram_bank(true, 0);
+}
+
+void NoController::write_control(u16 /*addr*/, u8 /*data*/) {}
+
+MBC1Controller::MBC1Controller(const u8 *rom, size_t rom_size, std::vector<u8> &ram) :
+    MemoryBankController(rom, rom_size, ram),
+    enable_ram(false),
+    mode(0),
+    bank_low(1),
+    bank_high(0)
+{
+    update_banks();
+}
+
+void MBC1Controller::write_control(u16 addr, u8 data)
+{
+    if (addr <= 0x1fff) {
+        enable_ram = (data & 0xf) == 0xa;
+    }
+    else if (addr <= 0x3fff) {
+        // Bank 0 can't be selected here, so banks 0x20, 0x40 and 0x60 are unreachable
+        bank_low = data & 0x1f;
+        if (bank_low == 0) {
+            bank_low = 1;
+        }
+    }
+    else if (addr <= 0x5fff) {
+        bank_high = data & 3;
+    }
+    else {
+        mode = data & 1;
+    }
+    update_banks();
+}
+
+void MBC1Controller::update_banks()
+{
+    int upper = bank_high << 5;
+    select_rom_banks(mode ? upper : 0, upper | bank_low);
+    select_ram_bank(enable_ram, mode ? bank_high : 0);
+}
+
+MBC2Controller::MBC2Controller(const u8 *rom, size_t rom_size, std::vector<u8> &ram) :
+    MemoryBankController(rom, rom_size, ram),
+    enable_ram(false)
+{
+    internal_ram.resize(0x200, 0xff);
+}
+
+void MBC2Controller::write_control(u16 addr, u8 data)
+{
+    if (addr > 0x3fff) {
+        return;
+    }
+    // Bit 8 of the address selects between RAM enable and ROM bank registers
+    if (addr & 0x100) {
+        int bank = data & 0xf;
+        select_rom_banks(0, bank == 0 ? 1 : bank);
+    }
+    else {
+        enable_ram = (data & 0xf) == 0xa;
+    }
+}
+
+u8 MBC2Controller::read_ram(u16 addr)
+{
+    if (!enable_ram) {
+        return 0xff;
+    }
+    // Only lower 4 bits are stored, upper bits read as 1
+    return internal_ram[addr & 0x1ff] | 0xf0;
+}
+
+void MBC2Controller::write_ram(u16 addr, u8 data)
+{
+    if (enable_ram) {
+        internal_ram[addr & 0x1ff] = data & 0xf;
+    }
+}
+
+MBC3Controller::MBC3Controller(const u8 *rom, size_t rom_size, std::vector<u8> &ram) :
+    MemoryBankController(rom, rom_size, ram),
+    enable_ram(false),
+    ram_bank(0)
+{
+    clock_registers.resize(5, 0);
+    update_banks();
+}
+
+void MBC3Controller::write_control(u16 addr, u8 data)
+{
+    if (addr <= 0x1fff) {
+        // enables both RAM and RTC
+        enable_ram = (data & 0xf) == 0xa;
+    }
+    else if (addr <= 0x3fff) {
+        data &= 0x7f;
+        select_rom_banks(0, data == 0 ? 1 : data);
+    }
+    else if (addr <= 0x5fff) {
+        ram_bank = data;
+    }
+    else {
+        // Latch clock
+    }
+    update_banks();
+}
+
+void MBC3Controller::update_banks()
+{
+    // RTC registers are not plain memory, and are accessed through read_ram/write_ram
+    select_ram_bank(enable_ram && ram_bank <= 3, ram_bank);
+}
+
+u8 MBC3Controller::read_ram(u16 /*addr*/)
+{
+    if (enable_ram && ram_bank >= 8 && ram_bank <= 0xc) {
+        return clock_registers[ram_bank - 8];
+    }
+    return 0xff;
+}
+
+void MBC3Controller::write_ram(u16 /*addr*/, u8 data)
+{
+    if (enable_ram && ram_bank >= 8 && ram_bank <= 0xc) {
+        clock_registers[ram_bank - 8] = data;
+    }
+}
+
+MBC5Controller::MBC5Controller(const u8 *rom, size_t rom_size, std::vector<u8> &ram) :
+    MemoryBankController(rom, rom_size, ram),
+    enable_ram(false),
+    rom_bank(1),
+    ram_bank(0)
+{
+    update_banks();
+}
+
+void MBC5Controller::write_control(u16 addr, u8 data)
+{
+    if (addr <= 0x1fff) {
+        enable_ram = data == 0xa;
+    }
+    else if (addr <= 0x2fff) {
+        // Lower 8 bits of ROM bank
+        rom_bank = (rom_bank & 0x100) | data;
+    }
+    else if (addr <= 0x3fff) {
+        // 9th bit of ROM bank
+        rom_bank = ((data & 1) << 8) | (rom_bank & 0xff);
+    }
+    else if (addr <= 0x5fff) {
+        // Bit 3 drives the rumble motor on carts that have one
+        ram_bank = data & 0xf;
+    }
+    update_banks();
+}
+
+void MBC5Controller::update_banks()
+{
+    select_rom_banks(0, rom_bank);
+    select_ram_bank(enable_ram, ram_bank);
+}
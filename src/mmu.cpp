@@ -1,146 +1,234 @@
 #include "mmu.h"
+#include "block_cache.h"
 #include "util.h"
 #include "registers.h"
 #include <map>
 #include <cassert>
 
 Memory::Memory(
-    Interrupts *inter, Cartridge *cart, Joypad *pad, APU *audio, GPU *video,bool enable_boot) : 
+    Interrupts *inter, Cartridge *cart, Joypad *pad, APU *audio, GPU *video, Timer *time,
+    bool enable_boot) : 
     joypad(pad), 
     cartridge(cart), 
     apu(audio),
     gpu(video),
+    timer(time),
     interrupts(inter),
     enable_boot_rom(enable_boot),
     enable_break_pt(false), 
     paused(false), 
     vram_updated(false),
-    reset_clock(false),
+    write_count(0),
+    volatile_read_count(0),
     audio_trigger{0, 0, 0, 0},
-    reload_audio_counter{0, 0, 0, 0}
+    reload_audio_counter{0, 0, 0, 0},
+    block_cache(nullptr),
+    wram_code{},
+    hram_code(false)
 {
     internal_RAM.resize(0x2000, 0); 
     high_RAM.resize(0x7f, 0);
     init_registers();
+    gpu->attach_memory(this);
+    map_pages();
 }
 
-u8 Memory::read(u16 addr) 
+u8 Memory::read_mmio(PageHandler handler, u16 addr) 
 {
-    if (enable_boot_rom && addr <= 0xff) { 
-        return boot_ROM[addr];
-    }
-    else if (addr <= 0x7fff) {
-        // Cartridge ROM banks
+    switch (handler)
+    {
+    case CARTRIDGE:
+        // Cartridge ROM banks and RAM
         return cartridge->read(addr);
-    }
-    else if (addr >= 0x8000 && addr <= 0x9fff) {
+    case VIDEO:
         // VRAM
         return gpu->read(addr);
-        // return video_RAM[addr - 0x8000];
-    }
-    else if (addr >= 0xa000 && addr <= 0xbfff) {
-        // Cartridge RAM
-        return cartridge->read(addr);
-    }
-    else if (addr >= 0xc000 && addr <= 0xdfff) {
-        // Main RAM
-        return internal_RAM[addr - 0xc000];
-    }
-    else if (addr >= 0xe000 && addr <= 0xfdff) {
-        // Echo RAM
-        return read(addr - 0x2000);
-    }
-    else if (addr >= 0xfe00 && addr <= 0xfe9f) {
-        // Sprite attribute table (OAM)
-        return gpu->read(addr);
-        // return sprite_attribute_table[addr - 0xfe00];
-    }
-    else if (addr >= 0xfea0 && addr <= 0xfeff) {
+    case OAM:
+        if (addr <= 0xfe9f) {
+            // Sprite attribute table (OAM)
+            return gpu->read(addr);
+        }
         // Unused
         return 0xff;
-    }
-    else if (addr >= 0xff00 && addr <= 0xff7f) {
-        // IO registers
+    case CODE:
+        return internal_RAM[(addr - 0xc000) & 0x1fff];
+    case IO:
         if (addr >= 0xff10 && addr <= 0xff3f) {
             // APU registers
+            volatile_read_count++;
             return apu->read(addr);
         }
+        else if (addr >= reg::DIV && addr <= reg::TAC) {
+            if (addr == reg::DIV || addr == reg::TIMA) {
+                volatile_read_count++;
+            }
+            return timer->read(addr);
+        }
         else if (addr >= 0xff40 && addr <= 0xff4b && addr != reg::DMA) {
             // GPU registers, excluding DMA which is still handled by MMU
             return gpu->read(addr);
         }
+        else if (addr >= 0xff80 && addr <= 0xfffe) {
+            return high_RAM[addr - 0xff80];
+        }
+        else if (addr == 0xffff) {
+            return interrupts->read_enable();
+        }
         else {
             return read_reg(addr);
         }
     }
-    else if (addr >= 0xff80 && addr <= 0xfffe) {
-        return high_RAM[addr - 0xff80];
-    }
-    else if (addr == 0xffff) {
-        return ie_reg;
-    }
+    assert(false);
+    return 0xff;
 }
 
-void Memory::write(u16 addr, u8 data)
+void Memory::write_mmio(PageHandler handler, u16 addr, u8 data)
 {   
-    if (enable_break_pt && addr == break_pt) 
-        paused = true; 
-
-    if (addr <= 0x7fff) {
-        // Cartridge ROM banks
-        cartridge->write(addr, data);
-    }
-    else if (addr >= 0x8000 && addr <= 0x9fff) {
+    switch (handler)
+    {
+    case CARTRIDGE:
+        // Cartridge ROM banks and RAM. Writes to ROM go to the MBC and may switch banks
+        if (cartridge->write(addr, data)) {
+            map_cartridge_pages();
+        }
+        break;
+    case CODE:
+        // Main RAM holding cached code
+        internal_RAM[(addr - 0xc000) & 0x1fff] = data;
+        write_code(addr);
+        break;
+    case VIDEO:
         // VRAM
         gpu->write(addr, data);
-        // video_RAM[addr - 0x8000] = data;
-    }
-    else if (addr >= 0xa000 && addr <= 0xbfff) {
-        // Cartridge RAM
-        cartridge->write(addr, data);
-    }
-    else if (addr >= 0xc000 && addr <= 0xdfff) {
-        // Main RAM
-        internal_RAM[addr - 0xc000] = data;
-    }
-    else if (addr >= 0xe000 && addr <= 0xfdff) {
-        // Echo RAM
-        write(addr - 0x2000, data);
-    }
-    else if (addr >= 0xfe00 && addr <= 0xfe9f) {
-        // Sprite attribute table (OAM)
-        gpu->write(addr, data);
-        // sprite_attribute_table[addr - 0xfe00] = data;
-    }
-    else if (addr >= 0xfea0 && addr <= 0xfeff) {
-        // Unused
-        return;
-    }
-    else if (addr >= 0xff00 && addr <= 0xff7f) {
-        // IO registers
+        break;
+    case OAM:
+        if (addr <= 0xfe9f) {
+            // Sprite attribute table (OAM)
+            gpu->write(addr, data);
+        }
+        break;
+    case IO:
         if (addr >= 0xff10 && addr <= 0xff3f) {
             // APU registers
             apu->write(addr, data);
         }
+        else if (addr >= reg::DIV && addr <= reg::TAC) {
+            timer->write(addr, data);
+        }
         else if (addr >= 0xff40 && addr <= 0xff4b && addr != reg::DMA) {
             // GPU registers, excluding DMA which is still handled by MMU
             gpu->write(addr, data);
         }
+        else if (addr >= 0xff80 && addr <= 0xfffe) {
+            high_RAM[addr - 0xff80] = data;
+            if (hram_code) {
+                write_code(addr);
+            }
+        }
+        else if (addr == 0xffff) {
+            interrupts->write_enable(data);
+        }
         else {
             write_reg(addr, data);
         }
+        break;
     }
-    else if (addr >= 0xff80 && addr <= 0xfffe) {
-        high_RAM[addr - 0xff80] = data;
+}
+
+void Memory::map_page(int page, const u8 *read_mem, u8 *write_mem, PageHandler handler)
+{
+    read_pages[page] = {read_mem, handler};
+    write_pages[page] = {write_mem, handler};
+}
+
+void Memory::map_pages()
+{
+    map_cartridge_pages();
+    map_video_pages();
+    for (int page = 0xc0; page <= 0xfd; page++) {
+        map_wram_page(page);
     }
-    else if (addr == 0xffff) {
-        ie_reg = data;
+    map_page(0xfe, nullptr, nullptr, OAM);
+    map_page(0xff, nullptr, nullptr, IO);
+}
+
+void Memory::map_wram_page(int page)
+{
+    // Main RAM, and echo RAM mirroring it from 0xe000
+    int offset = (page - 0xc0) & 0x1f;
+    u8 *mem = &internal_RAM[offset << 8];
+    if (wram_code[offset]) {
+        map_page(page, mem, nullptr, CODE);
+    }
+    else {
+        map_page(page, mem, mem, IO);
+    }
+}
+
+void Memory::attach_block_cache(BlockCache *cache) { block_cache = cache; }
+
+void Memory::protect_code(u16 addr) { set_code_protection(addr, true); }
+
+void Memory::write_code(u16 addr)
+{
+    // Every block in the page is dropped, so the page no longer needs protecting
+    set_code_protection(addr, false);
+    block_cache->invalidate(addr);
+}
+
+void Memory::set_code_protection(u16 addr, bool protect)
+{
+    if (addr >= 0xff80) {
+        hram_code = protect;
+        return;
+    }
+    int offset = ((addr >> 8) - 0xc0) & 0x1f;
+    wram_code[offset] = protect;
+    map_wram_page(0xc0 + offset);
+    if (0xe0 + offset <= 0xfd) {
+        map_wram_page(0xe0 + offset);
+    }
+}
+
+void Memory::map_cartridge_pages()
+{
+    // ROM is read-only, writes go to the MBC
+    const u8 *rom0 = cartridge->rom0_base();
+    const u8 *romx = cartridge->romx_base();
+    for (int page = 0; page < 0x40; page++) {
+        map_page(page, rom0 + (page << 8), nullptr, CARTRIDGE);
+        map_page(0x40 + page, romx + (page << 8), nullptr, CARTRIDGE);
+    }
+    if (enable_boot_rom && boot_ROM.size() >= 0x100) {
+        read_pages[0x00].mem = boot_ROM.data();
+    }
+    u8 *sram = cartridge->sram_base();
+    for (int page = 0; page < 0x20; page++) {
+        u8 *mem = sram ? sram + (page << 8) : nullptr;
+        map_page(0xa0 + page, mem, mem, CARTRIDGE);
+    }
+    if (block_cache != nullptr) {
+        block_cache->remap();
+    }
+}
+
+void Memory::map_video_pages()
+{
+    u8 *vram = gpu->vram_accessible() ? gpu->vram_data() : nullptr;
+    for (int page = 0x80; page <= 0x9f; page++) {
+        u8 *mem = vram ? vram + ((page - 0x80) << 8) : nullptr;
+        // Written through the GPU, to keep its tile and background caches up to date
+        map_page(page, mem, nullptr, VIDEO);
     }
 }
 
 u8 Memory::read_reg(u16 addr) 
 {
     u8 reg_val = io_registers[addr - 0xff00] | io_read_masks[addr - 0xff00];
+    if (addr <= reg::SC) {
+        // Joypad and serial
+        volatile_read_count++;
+    }
     switch(addr) 
     {
     case reg::IF:
@@ -163,9 +251,6 @@ void Memory::write_reg(u16 addr, u8 data)
     case reg::IF:
         interrupts->write(data);
         break;
-    case reg::DIV:
-        reset_clock = true;
-        break;
     case 0xff03:
         break;
     case reg::DMA: {
@@ -174,27 +259,17 @@ void Memory::write_reg(u16 addr, u8 data)
     }
     case 0xff50:
         enable_boot_rom = false;
+        map_cartridge_pages();
         break;
     default:
         io_registers[addr - 0xff00] = (data & (~mask)) | (io_registers[addr - 0xff00] & mask);
     }
 }
 
-u8& Memory::get_mem_reference(u16 addr)
-{
-    // plan to remove this function
-    // assert(false);
-    if (addr >= 0xff00 && addr <= 0xff7f) {
-        return io_registers[addr - 0xff00];
-    }
-    else {
-        assert(false);
-    }
-}
-
 void Memory::load_boot(std::string file_path)
 {
     utils::load_file(boot_ROM, file_path);
+    map_cartridge_pages();
 }
 
 void Memory::set_access_break_pt(u16 addr) 
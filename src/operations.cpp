@@ -8,11 +8,37 @@ void set_nhc_flags_add(Processor *proc, int a, int b)
     proc->set_flags(Processor::CARRY, utils::full_carry_add(a, b));
 }
 
-void set_nhc_flags_sub(Processor *proc, int a, int b)
+// Record the operation for lazy flag evaluation - see Processor::sync_flags
+inline void lazy_flags(Processor *proc, u8 op, u8 x, u8 y, u8 result, bool carry)
 {
-    proc->set_flags(Processor::SUBTRACT, 1);
-    proc->set_flags(Processor::HALF_CARRY, utils::half_carry_sub(a, b));
-    proc->set_flags(Processor::CARRY, b > a);
+    proc->flag_op = op;
+    proc->flag_x = x;
+    proc->flag_y = y;
+    proc->flag_result = result;
+    proc->flag_carry = carry;
+}
+
+// Flags of an operation setting all four at once, written straight to F
+inline void write_flags(Processor *proc, bool z, bool n, bool h, bool c)
+{
+    proc->F = (z ? Processor::ZERO : 0) | (n ? Processor::SUBTRACT : 0) 
+        | (h ? Processor::HALF_CARRY : 0) | (c ? Processor::CARRY : 0);
+    proc->load_flags();
+}
+
+// 8-bit add and subtract, with carry or borrow in
+inline void add8(Processor *proc, u8 &dest, u8 src, bool carry)
+{
+    int result = dest + src + carry;
+    lazy_flags(proc, Processor::FLAGS_ADD, dest, src, result, result > 0xff);
+    dest = result;
+}
+
+inline void sub8(Processor *proc, u8 &dest, u8 src, bool carry)
+{
+    int result = dest - src - carry;
+    lazy_flags(proc, Processor::FLAGS_SUB, dest, src, result, result < 0);
+    dest = result;
 }
 
 void op::NOP() {}
@@ -80,29 +106,23 @@ void op::POP(Processor *proc, reg16 &reg)
 
 void op::ADD(Processor *proc, u8 &dest, u8 &src)
 {  
-    set_nhc_flags_add(proc, dest, src);
-    dest += src;
-    proc->set_flags(Processor::ZERO, dest == 0);
+    add8(proc, dest, src, false);
 }
 
 void op::ADD(Processor *proc, reg16 &dest, reg16 &src)
 {
     // zero flag not affected, carry checks for overflow
     bool c = dest.value + src.value > 0xffff;
-    proc->set_flags(Processor::CARRY, c);
     // half carry checks for carry from bit 11
     bool hc = (((dest.value & 0xfff) + (src.value & 0xfff)) & 0x1000) == 0x1000;
-    proc->set_flags(Processor::HALF_CARRY, hc);
-    proc->set_flags(Processor::SUBTRACT, 0);
+    proc->sync_flags();
+    write_flags(proc, proc->F & Processor::ZERO, 0, hc, c);
     dest.value += src.value;
 }
 
 void op::ADD_imm(Processor *proc, u8 &reg)
 {
-    u8 add = proc->fetch_byte();
-    set_nhc_flags_add(proc, reg, add);
-    reg += (add);
-    proc->set_flags(Processor::ZERO, reg == 0);
+    add8(proc, reg, proc->fetch_byte(), false);
 }
 
 void op::ADD_imm(Processor *proc, reg16 &reg)
@@ -117,133 +137,59 @@ void op::ADD_imm(Processor *proc, reg16 &reg)
 
 void op::ADD_mem(Processor *proc, u8 &dest, reg16 &src)
 {
-    u8 add = proc->memory->read(src.value);
-    set_nhc_flags_add(proc, dest, add);
-    dest += (add);
-    proc->set_flags(Processor::ZERO, dest == 0);
+    add8(proc, dest, proc->memory->read(src.value), false);
 }
 
 void op::ADC(Processor *proc, u8 &dest, u8 &src)
 {
-    // carry flag checks for overflow
-    bool c = (u16)dest + src + proc->carry_flag() > 0xff;
-    // check for half carry in either addition
-    bool hc = utils::half_carry_add(src, dest);
-    dest += (src);
-    hc |= utils::half_carry_add(dest, proc->carry_flag());
-    dest += (proc->carry_flag());
-
-    proc->set_flags(Processor::SUBTRACT, 0);
-    proc->set_flags(Processor::HALF_CARRY, hc);
-    proc->set_flags(Processor::CARRY, c);
-    proc->set_flags(Processor::ZERO, dest == 0);
+    add8(proc, dest, src, proc->carry_flag());
 }
 
 void op::ADC_imm(Processor *proc, u8 &reg)
 {
-    u8 add = proc->fetch_byte();
-    bool c = (u16)reg + add + proc->carry_flag() > 0xff;
-    bool hc = utils::half_carry_add(reg, add);
-    reg += (add);
-    hc |= utils::half_carry_add(reg, proc->carry_flag());
-    reg += (proc->carry_flag());
-
-    proc->set_flags(Processor::SUBTRACT, 0);
-    proc->set_flags(Processor::HALF_CARRY, hc);
-    proc->set_flags(Processor::CARRY, c);
-    proc->set_flags(Processor::ZERO, reg == 0);   
+    add8(proc, reg, proc->fetch_byte(), proc->carry_flag());
 }
 
 void op::ADC_mem(Processor *proc, u8 &dest, reg16 &src)
 {
-    u8 add = proc->memory->read(src.value);
-    bool c = (u16)dest + add + proc->carry_flag() > 0xff;
-    bool hc = utils::half_carry_add(dest, add);
-    dest += (add);
-    hc |= utils::half_carry_add(dest, proc->carry_flag());
-    dest += (proc->carry_flag());
-
-    proc->set_flags(Processor::SUBTRACT, 0);
-    proc->set_flags(Processor::HALF_CARRY, hc);
-    proc->set_flags(Processor::CARRY, c);
-    proc->set_flags(Processor::ZERO, dest == 0);
-
+    add8(proc, dest, proc->memory->read(src.value), proc->carry_flag());
 }
 
 void op::SUB(Processor *proc, u8 &dest, u8 &src)
 {
-    set_nhc_flags_sub(proc, dest, src);
-    dest -= src;
-    proc->set_flags(Processor::ZERO, dest == 0);
+    sub8(proc, dest, src, false);
 }
 
 void op::SUB_imm(Processor *proc, u8 &reg)
 {
-    u8 sub = proc->fetch_byte();
-    set_nhc_flags_sub(proc, reg, sub);
-    reg -= sub;
-    proc->set_flags(Processor::ZERO, reg == 0);
+    sub8(proc, reg, proc->fetch_byte(), false);
 }
 
 void op::SUB_mem(Processor *proc, u8 &dest, reg16 &src)
 {
-    u8 sub = proc->memory->read(src.value);
-    set_nhc_flags_sub(proc, dest, sub);
-    dest -= sub;
-    proc->set_flags(Processor::ZERO, dest == 0);
+    sub8(proc, dest, proc->memory->read(src.value), false);
 }
 
 void op::SBC(Processor *proc, u8 &dest, u8 &src)
 {
-    bool c = dest < src + proc->carry_flag();
-    bool hc = utils::half_carry_sub(dest, src);
-    dest -= (src);
-    hc |= utils::half_carry_sub(dest, proc->carry_flag());
-    dest -= (proc->carry_flag());
-
-    proc->set_flags(Processor::ZERO, dest == 0);
-    proc->set_flags(Processor::HALF_CARRY, hc);
-    proc->set_flags(Processor::CARRY, c);
-    proc->set_flags(Processor::SUBTRACT, 1);
+    sub8(proc, dest, src, proc->carry_flag());
 }
 
 void op::SBC_imm(Processor *proc, u8 &reg)
 {
-    u8 sub = proc->fetch_byte();
-    bool c = reg < sub + proc->carry_flag();
-    bool hc = utils::half_carry_sub(reg, sub);
-    reg -= (sub);
-    hc |= utils::half_carry_sub(reg, proc->carry_flag());
-    reg -= (proc->carry_flag());
-
-    proc->set_flags(Processor::ZERO, reg == 0);
-    proc->set_flags(Processor::HALF_CARRY, hc);
-    proc->set_flags(Processor::CARRY, c);
-    proc->set_flags(Processor::SUBTRACT, 1);
+    sub8(proc, reg, proc->fetch_byte(), proc->carry_flag());
 }
 
 void op::SBC_mem(Processor *proc, u8 &dest, reg16 &src)
 {
-    u8 sub = proc->memory->read(src.value);
-    bool c = dest < sub + proc->carry_flag();
-    bool hc = utils::half_carry_sub(dest, sub);
-    dest -= (sub);
-    hc |= utils::half_carry_sub(dest, proc->carry_flag());
-    dest -= (proc->carry_flag());
-
-    proc->set_flags(Processor::ZERO, dest == 0);
-    proc->set_flags(Processor::HALF_CARRY, hc);
-    proc->set_flags(Processor::CARRY, c);
-    proc->set_flags(Processor::SUBTRACT, 1);
+    sub8(proc, dest, proc->memory->read(src.value), proc->carry_flag());
 }
 
 void op::INC(Processor *proc, u8 &reg)
 {
     // carry flag unaffected    
-    proc->set_flags(Processor::HALF_CARRY, utils::half_carry_add(reg, 1));
-    proc->set_flags(Processor::SUBTRACT, 0);
+    lazy_flags(proc, Processor::FLAGS_ADD, reg, 1, reg + 1, proc->carry_flag());
     reg++;
-    proc->set_flags(Processor::ZERO, reg == 0);
 }
 
 void op::INC(reg16 &reg)
@@ -256,21 +202,17 @@ void op::INC_mem(Processor *proc, reg16 &reg)
 {
     u8 val = proc->memory->read(reg.value);
     // carry flag unaffected
-    proc->set_flags(Processor::HALF_CARRY, utils::half_carry_add(val, 1));
-    proc->set_flags(Processor::SUBTRACT, 0);
+    bool hc = utils::half_carry_add(val, 1);
     proc->memory->write(reg.value, val + 1);
     val = proc->memory->read(reg.value);
-    proc->set_flags(Processor::ZERO, val == 0);
+    write_flags(proc, val == 0, 0, hc, proc->carry_flag());
 }
 
 void op::DEC(Processor *proc, u8 &reg)
 {
     // carry flag unaffected
-    proc->set_flags(Processor::HALF_CARRY, utils::half_carry_sub(reg, 1));
-    //proc->set_flags(Processor::HALF_CARRY, 1 > reg);
-    proc->set_flags(Processor::SUBTRACT, 1);
+    lazy_flags(proc, Processor::FLAGS_SUB, reg, 1, reg - 1, proc->carry_flag());
     reg--;
-    proc->set_flags(Processor::ZERO, reg == 0);
 }
 
 void op::DEC(Processor *proc, reg16 &reg)
@@ -282,114 +224,97 @@ void op::DEC(Processor *proc, reg16 &reg)
 void op::DEC_mem(Processor *proc, reg16 &reg)
 {
     u8 val = proc->memory->read(reg.value);
-    proc->set_flags(Processor::HALF_CARRY, utils::half_carry_sub(val, 1));
-    proc->set_flags(Processor::SUBTRACT, 1);
+    bool hc = utils::half_carry_sub(val, 1);
     proc->memory->write(reg.value, val - 1);
     val = proc->memory->read(reg.value);
-    proc->set_flags(Processor::ZERO, val == 0);
+    write_flags(proc, val == 0, 1, hc, proc->carry_flag());
 }
 
 void op::AND(Processor *proc, u8 &dest, u8 &src)
 {
     dest = (dest & src);
-    proc->set_flags(Processor::SUBTRACT | Processor::CARRY, 0);
-    proc->set_flags(Processor::HALF_CARRY, 1);
-    proc->set_flags(Processor::ZERO, dest == 0);
+    lazy_flags(proc, Processor::FLAGS_AND, 0, 0, dest, 0);
 }
 
 void op::AND_imm(Processor *proc, u8 &reg)
 {
-    u8 val = proc->fetch_byte();
-    reg = (reg & val);
-    proc->set_flags(Processor::SUBTRACT | Processor::CARRY, 0);
-    proc->set_flags(Processor::HALF_CARRY, 1);
-    proc->set_flags(Processor::ZERO, reg == 0);
+    reg = (reg & proc->fetch_byte());
+    lazy_flags(proc, Processor::FLAGS_AND, 0, 0, reg, 0);
 }
 
 void op::AND_mem(Processor *proc, u8 &dest, reg16 &src)
 {
     dest = (dest & proc->memory->read(src.value));
-    proc->set_flags(Processor::SUBTRACT | Processor::CARRY, 0);
-    proc->set_flags(Processor::HALF_CARRY, 1);
-    proc->set_flags(Processor::ZERO, dest == 0);
+    lazy_flags(proc, Processor::FLAGS_AND, 0, 0, dest, 0);
 }
 
 void op::OR(Processor *proc, u8 &dest, u8 &src)
 {
     dest = (dest | src);
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY | Processor::CARRY, 0);
-    proc->set_flags(Processor::ZERO, dest == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, dest, 0);
 }
 
 void op::OR_imm(Processor *proc, u8 &reg)
 {
     reg = (reg | proc->fetch_byte());
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY | Processor::CARRY, 0);
-    proc->set_flags(Processor::ZERO, reg == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, reg, 0);
 }
 
 void op::OR_mem(Processor *proc, u8 &dest, reg16 &src)
 {
     dest = (dest | proc->memory->read(src.value));
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY | Processor::CARRY, 0);
-    proc->set_flags(Processor::ZERO, dest == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, dest, 0);
 }
 
 void op::XOR(Processor *proc, u8 &dest, u8 &src)
 {
     dest = (dest ^ src);
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY | Processor::CARRY, 0);
-    proc->set_flags(Processor::ZERO, dest == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, dest, 0);
 }
 
 void op::XOR_imm(Processor *proc, u8 &reg)
 {
     reg = (reg ^ proc->fetch_byte());
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY | Processor::CARRY, 0);
-    proc->set_flags(Processor::ZERO, reg == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, reg, 0);
 }
 
 void op::XOR_mem(Processor *proc, u8 &dest, reg16 &src)
 {
     dest = (dest ^ proc->memory->read(src.value));
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY | Processor::CARRY, 0);
-    proc->set_flags(Processor::ZERO, dest == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, dest, 0);
 }
 
+// Compare is subtraction with the result thrown away
 void op::CP(Processor *proc, u8 &dest, u8 &src)
 {
-    proc->set_flags(Processor::ZERO, dest == src);
-     set_nhc_flags_sub(proc, dest, src);
+    u8 a = dest;
+    sub8(proc, a, src, false);
 }
 
 void op::CP_imm(Processor *proc, u8 &reg)
 {
-    u8 val = proc->fetch_byte();
-    proc->set_flags(Processor::ZERO, reg - val == 0);
-    set_nhc_flags_sub(proc, reg, val);  
+    u8 a = reg;
+    sub8(proc, a, proc->fetch_byte(), false);
 }
 
 void op::CP_mem(Processor *proc, u8 &dest, reg16 &src)
 {
-    u8 val = proc->memory->read(src.value);
-    proc->set_flags(Processor::ZERO, dest == val);
-    set_nhc_flags_sub(proc, dest, val);  
+    u8 a = dest;
+    sub8(proc, a, proc->memory->read(src.value), false);
 }
 
 void op::SWAP(Processor *proc, u8 &reg)
 {
     reg = (utils::swap(reg));
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY | Processor::CARRY, 0);
-    proc->set_flags(Processor::ZERO, reg == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, reg, 0);
 }
 
 void op::SWAP_mem(Processor *proc, reg16 &reg)
 {
     u8 val = proc->memory->read(reg.value);
     proc->memory->write(reg.value, utils::swap(val));
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY | Processor::CARRY, 0);
     val = proc->memory->read(reg.value);
-    proc->set_flags(Processor::ZERO, val == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, val, 0);
 }
 
 void op::RL(Processor *proc, u8 &reg)
@@ -397,9 +322,7 @@ void op::RL(Processor *proc, u8 &reg)
     u8 bit7 = reg >> 7;
     // rotate through carry
     reg = ((reg << 1) | (u8)proc->carry_flag());
-    proc->set_flags(Processor::CARRY, bit7);
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY, 0);
-    proc->set_flags(Processor::ZERO, reg == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, reg, bit7);
 }
 
 void op::RL(Processor *proc, reg16 &reg)
@@ -408,11 +331,9 @@ void op::RL(Processor *proc, reg16 &reg)
     // rotate through carry
     proc->memory->write(reg.value, (val << 1) | (u8)proc->carry_flag());
     // old bit 7 to carry
-    proc->set_flags(Processor::CARRY, (val >> 7) & 1);
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY, 0);
+    bool bit7 = (val >> 7) & 1;
     val = proc->memory->read(reg.value);
-    proc->set_flags(Processor::ZERO, val == 0);
-    
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, val, bit7);
 }
 
 void op::RLC(Processor *proc, u8 &reg)
@@ -420,9 +341,7 @@ void op::RLC(Processor *proc, u8 &reg)
     bool bit7 = (reg >> 7) & 1;
     // simple rotate
     reg = ((reg << 1) | (u8)bit7);
-    proc->set_flags(Processor::CARRY, bit7);
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY, 0);
-    proc->set_flags(Processor::ZERO, reg == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, reg, bit7);
 }
 
 void op::RLC(Processor *proc, reg16 &reg)
@@ -432,10 +351,8 @@ void op::RLC(Processor *proc, reg16 &reg)
     // simple rotate
     proc->memory->write(reg.value, (val << 1) | (u8)bit7);
     // old bit 7 to carry
-    proc->set_flags(Processor::CARRY, bit7);
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY, 0);
     val = proc->memory->read(reg.value);
-    proc->set_flags(Processor::ZERO, val == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, val, bit7);
 }
 
 void op::RR(Processor *proc, u8 &reg)
@@ -443,9 +360,7 @@ void op::RR(Processor *proc, u8 &reg)
     u8 bit0 = reg & 1;
     // rotate through carry
     reg = ((reg >> 1) | (proc->carry_flag() << 7));
-    proc->set_flags(Processor::CARRY, bit0);
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY, 0);
-    proc->set_flags(Processor::ZERO, reg == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, reg, bit0);
 }
 
 void op::RR(Processor *proc, reg16 &reg)
@@ -454,10 +369,9 @@ void op::RR(Processor *proc, reg16 &reg)
     u8 val = proc->memory->read(reg.value);
     proc->memory->write(reg.value, (val >> 1) | (proc->carry_flag() << 7));
     // old bit 0 to carry
-    proc->set_flags(Processor::CARRY, val & 1);
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY, 0);
+    bool bit0 = val & 1;
     val = proc->memory->read(reg.value);
-    proc->set_flags(Processor::ZERO, val == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, val, bit0);
 }
 
 void op::RRC(Processor *proc, u8 &reg)
@@ -465,9 +379,7 @@ void op::RRC(Processor *proc, u8 &reg)
     u8 bit0 = reg & 1;
     // simple rotate
     reg = ((reg >> 1) | (bit0 << 7));
-    proc->set_flags(Processor::CARRY, bit0);
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY, 0);
-    proc->set_flags(Processor::ZERO, reg == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, reg, bit0);
 }
 
 void op::RRC(Processor *proc, reg16 &reg)
@@ -476,19 +388,17 @@ void op::RRC(Processor *proc, reg16 &reg)
     // simple rotate
     proc->memory->write(reg.value, (val >> 1) | (val << 7));
     // old bit 0 to carry
-    proc->set_flags(Processor::CARRY, val & 1);
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY, 0);
+    bool bit0 = val & 1;
     val = proc->memory->read(reg.value);
-    proc->set_flags(Processor::ZERO, val == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, val, bit0);
 }
 
 void op::SLA(Processor *proc, u8 &reg)
 {
     // old bit 7 to carry
-    proc->set_flags(Processor::CARRY, reg >> 7);
+    bool bit7 = reg >> 7;
     reg = (reg << 1);
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY, 0);
-    proc->set_flags(Processor::ZERO, reg == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, reg, bit7);
 }
 
 void op::SLA(Processor *proc, reg16 &reg)
@@ -496,69 +406,60 @@ void op::SLA(Processor *proc, reg16 &reg)
     u8 val = proc->memory->read(reg.value);
     proc->memory->write(reg.value, val << 1);
     // old bit 7 to carry
-    proc->set_flags(Processor::CARRY, val >> 7);
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY, 0);
+    bool bit7 = val >> 7;
     val = proc->memory->read(reg.value);
-    proc->set_flags(Processor::ZERO, val == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, val, bit7);
 }
 
 void op::SRA(Processor *proc, u8 &reg)
 {
     // old bit 0 to carry
-    proc->set_flags(Processor::CARRY, reg & 1);
+    bool bit0 = reg & 1;
     // shift bit 7 in from right
     reg = ((reg >> 1) | (reg & (1 << 7)));
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY, 0);
-    proc->set_flags(Processor::ZERO, reg == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, reg, bit0);
 }
 
 void op::SRA(Processor *proc, reg16 &reg)
 {
     u8 val = proc->memory->read(reg.value);
     // old bit 0 to carry
-    proc->set_flags(Processor::CARRY, val & 1);
+    bool bit0 = val & 1;
     // shift bit 7 in from right
     proc->memory->write(reg.value, (val >> 1) | (val & (1 << 7)));
-    // carry always set to 0
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY, 0);
     val = proc->memory->read(reg.value);
-    proc->set_flags(Processor::ZERO, val == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, val, bit0);
 }
 
 void op::SRL(Processor *proc, u8 &reg)
 {
     // old bit 0 to carry
-    proc->set_flags(Processor::CARRY, reg & 1);
+    bool bit0 = reg & 1;
     // shift 0 in from right
     reg = (reg >> 1);
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY, 0);
-    proc->set_flags(Processor::ZERO, reg == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, reg, bit0);
 }
 
 void op::SRL(Processor *proc, reg16 &reg)
 {
     u8 val = proc->memory->read(reg.value);
     // old bit 0 to carry
-    proc->set_flags(Processor::CARRY, val & 1);
+    bool bit0 = val & 1;
     proc->memory->write(reg.value, val >> 1);
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY, 0);
     val = proc->memory->read(reg.value);
-    proc->set_flags(Processor::ZERO, val == 0);
+    lazy_flags(proc, Processor::FLAGS_LOGIC, 0, 0, val, bit0);
 }
 
+// Carry flag unaffected by BIT
 void op::BIT(Processor *proc, u8 &reg, u8 bit)
 {
-    proc->set_flags(Processor::ZERO, ((reg >> bit) & 1) == 0);
-    proc->set_flags(Processor::SUBTRACT, 0);
-    proc->set_flags(Processor::HALF_CARRY, 1);
+    lazy_flags(proc, Processor::FLAGS_AND, 0, 0, (reg >> bit) & 1, proc->carry_flag());
 }
 
 void op::BIT(Processor *proc, reg16 &reg, u8 bit)
 {
     u8 val = proc->memory->read(reg.value);
-    proc->set_flags(Processor::ZERO, ((val >> bit) & 1) == 0);
-    proc->set_flags(Processor::SUBTRACT, 0);
-    proc->set_flags(Processor::HALF_CARRY, 1);
+    lazy_flags(proc, Processor::FLAGS_AND, 0, 0, (val >> bit) & 1, proc->carry_flag());
 }
 
 void op::SET(u8 &reg, u8 bit)
@@ -651,20 +552,21 @@ void op::DAA(Processor *proc)
     proc->set_flags(Processor::HALF_CARRY, 0);
 }
 
+// Zero flag is unaffected by CPL, SCF and CCF, so flag_result is left as it is
 void op::CPL(Processor *proc)
 {
     proc->A = (~proc->A);
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY, 1);
+    proc->flag_op = Processor::FLAGS_CPL;
 }
 
 void op::SCF(Processor *proc)
 {
-    proc->set_flags(Processor::CARRY, 1);
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY, 0);
+    proc->flag_op = Processor::FLAGS_LOGIC;
+    proc->flag_carry = true;
 }
 
 void op::CCF(Processor *proc)
 {
-    proc->set_flags(Processor::CARRY, !proc->carry_flag());
-    proc->set_flags(Processor::SUBTRACT | Processor::HALF_CARRY, 0);
+    proc->flag_op = Processor::FLAGS_LOGIC;
+    proc->flag_carry = !proc->flag_carry;
 }
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "pacer.h"
+#include "audio_sink.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+using namespace std::chrono;
+
+const double Pacer::CLOCK_RATE = 4194304;
+const double Pacer::FRAME_RATE = CLOCK_RATE / 70224; // 59.7275 Hz
+const int Pacer::TARGET_AUDIO_FRAMES = AudioSink::SAMPLE_RATE / 20; // 50ms
+const Pacer::Clock::duration Pacer::MAX_LAG = milliseconds(100);
+const Pacer::Clock::duration Pacer::MAX_SPIN = milliseconds(4);
+const Pacer::Clock::duration Pacer::MAX_AUDIO_CORRECTION = microseconds(500);
+
+Pacer::Pacer(Sync sync_to) :
+    sync(sync_to),
+    started(false),
+    start_cycles(0),
+    last_cycles(0),
+    oversleep(microseconds(100))
+{
+}
+
+void Pacer::wait(u64 cycles, int queued_audio)
+{
+    Clock::time_point now = Clock::now();
+    if (!started) {
+        start(now, cycles);
+        return;
+    }
+    if (sync == AUDIO) {
+        // A fraction of the time the queue is off by, so the correction is spread over frames
+        duration<double> error((double)(queued_audio - TARGET_AUDIO_FRAMES)
+            / AudioSink::SAMPLE_RATE / 16);
+        Clock::duration correction = duration_cast<Clock::duration>(error);
+        start_time += std::min(std::max(correction, -MAX_AUDIO_CORRECTION), MAX_AUDIO_CORRECTION);
+    }
+
+    Clock::time_point target = deadline(cycles);
+    if (now > target + MAX_LAG) {
+        // Too far behind to catch up, carry on from here
+        start(now, cycles);
+        return;
+    }
+    sleep_until(target);
+
+    now = Clock::now();
+    frame_ms.push_back(duration<double, std::milli>(now - last_time).count());
+    ideal_ms.push_back((cycles - last_cycles) * 1000 / CLOCK_RATE);
+    last_time = now;
+    last_cycles = cycles;
+}
+
+void Pacer::reset() { started = false; }
+
+void Pacer::start(Clock::time_point now, u64 cycles)
+{
+    started = true;
+    start_time = now;
+    start_cycles = cycles;
+    last_time = now;
+    last_cycles = cycles;
+}
+
+Pacer::Clock::time_point Pacer::deadline(u64 cycles) const
+{
+    duration<double> elapsed((cycles - start_cycles) / CLOCK_RATE);
+    return start_time + duration_cast<Clock::duration>(elapsed);
+}
+
+void Pacer::sleep_until(Clock::time_point time)
+{
+    Clock::duration spin = std::min(oversleep + microseconds(100), MAX_SPIN);
+    Clock::time_point wake = time - spin;
+    if (Clock::now() < wake) {
+        std::this_thread::sleep_until(wake);
+        // Overshoots are tracked as they happen, and forgotten slowly
+        Clock::duration late = Clock::now() - wake;
+        oversleep = std::max(late, oversleep - oversleep / 64);
+    }
+    while (Clock::now() < time) {
+        std::this_thread::yield();
+    }
+}
+
+Pacer::Jitter Pacer::jitter() const { return summarize(frame_ms, ideal_ms); }
+
+Pacer::Jitter Pacer::summarize(const std::vector<double> &frame_ms,
+    const std::vector<double> &ideal_ms)
+{
+    Jitter jitter = {(int)frame_ms.size(), 0, 0, 0, 0, 0};
+    if (frame_ms.empty()) {
+        return jitter;
+    }
+    std::vector<double> error(frame_ms.size());
+    double total_ms = 0;
+    for (size_t i = 0; i < frame_ms.size(); i++) {
+        error[i] = std::abs(frame_ms[i] - ideal_ms[i]);
+        total_ms += frame_ms[i];
+    }
+    std::sort(error.begin(), error.end());
+    auto percentile = [&error](double p) {
+        return error[std::min(error.size() - 1, (size_t)(p * error.size()))];
+    };
+    jitter.mean_frame_ms = total_ms / frame_ms.size();
+    jitter.p50 = percentile(0.5);
+    jitter.p90 = percentile(0.9);
+    jitter.p99 = percentile(0.99);
+    jitter.max = error.back();
+    return jitter;
+}
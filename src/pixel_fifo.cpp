@@ -0,0 +1,171 @@
+#include "pixel_fifo.h"
+#include "gpu.h"
+#include "registers.h"
+#include "util.h"
+#include <algorithm>
+
+PixelFifo::PixelFifo(GPU *video):
+    dots(0),
+    gpu(video),
+    x(WIDTH),
+    pixels_pos(8),
+    num_sprites(0),
+    sprite_dots(0)
+{
+}
+
+void PixelFifo::start()
+{
+    dots = 0;
+    x = 0;
+    pixels_pos = 8;
+    // Fine scroll is only read at the start of the line
+    discard = gpu->registers[reg::SCROLLX] % 8;
+    fetch_dot = -FETCH_DOTS;
+    fetch_x = 0;
+    window = false;
+
+    // OAM search has already happened by mode 3
+    num_sprites = gpu->select_sprites(sprites);
+    std::fill(sprite_fetched, sprite_fetched + num_sprites, false);
+    sprite_dots = 0;
+}
+
+void PixelFifo::step()
+{
+    if (done()) {
+        return;
+    }
+    dots++;
+
+    // Everything else waits while a sprite is fetched
+    if (sprite_dots > 0) {
+        if (--sprite_dots == 0) {
+            fetch_sprite(sprite_fetch);
+        }
+        return;
+    }
+
+    // Background fetcher pushes a tile row once the FIFO has emptied
+    if (fetch_dot == FETCH_DOTS && pixels_pos == 8) {
+        std::copy(fetched, fetched + 8, pixels);
+        pixels_pos = 0;
+        fetch_x++;
+        fetch_dot = 0;
+    }
+    else if (fetch_dot < FETCH_DOTS && ++fetch_dot == FETCH_DOTS) {
+        fetch_tile();
+    }
+
+    if (pixels_pos == 8) {
+        return;
+    }
+    if (discard > 0) {
+        pixels_pos++;
+        discard--;
+        return;
+    }
+    if (!window && window_starts()) {
+        // Fetcher restarts from the left of the window, counting this dot
+        window = true;
+        window_y = gpu->line - gpu->registers[reg::WY];
+        pixels_pos = 8;
+        fetch_x = 0;
+        fetch_dot = 1;
+        // Window may start left of the screen
+        discard = std::max(7 - gpu->registers[reg::WX], 0);
+        return;
+    }
+    int n = sprite_at_x();
+    if (n >= 0) {
+        // Sprite fetch has to wait for the background fetcher to reach the last dot of its tile
+        if (fetch_dot >= FETCH_DOTS - 1) {
+            sprite_fetch = n;
+            sprite_dots = SPRITE_FETCH_DOTS - 1;
+        }
+        return;
+    }
+    shift_out();
+}
+
+void PixelFifo::fetch_tile()
+{
+    int tile_x, y;
+    u16 map_addr;
+    if (window) {
+        tile_x = fetch_x;
+        y = window_y;
+        map_addr = gpu->LCD_control.win_tile_map_addr;
+    }
+    else {
+        tile_x = (gpu->registers[reg::SCROLLX] / 8 + fetch_x) % 32;
+        y = (gpu->registers[reg::SCROLLY] + gpu->line) % 256;
+        map_addr = gpu->LCD_control.bg_tile_map_addr;
+    }
+    u8 index = gpu->video_RAM[map_addr - GPU::VRAM_ADDR + 32 * (y / 8) + tile_x];
+    const u8 *row = gpu->tile_row(gpu->bg_tile(index), y % 8, false);
+    std::copy(row, row + 8, fetched);
+}
+
+void PixelFifo::fetch_sprite(int n)
+{
+    const u8 *sprite_data = &gpu->sprite_attribute_table[4 * sprites[n]];
+    sprite_fetched[n] = true;
+    sprite_x[n] = sprite_data[1] - 8;
+    sprite_behind_bg[n] = utils::bit(sprite_data[3], 7);
+    sprite_palette[n] = utils::bit(sprite_data[3], 4);
+
+    // Sprite height may have changed since OAM search, leaving the line past the bottom
+    int height = gpu->LCD_control.double_sprite_height ? 16 : 8;
+    if (gpu->line - (sprite_data[0] - 16) >= height) {
+        std::fill(sprite_row[n], sprite_row[n] + 8, 0);
+        return;
+    }
+    const u8 *row = gpu->sprite_row(sprites[n]);
+    std::copy(row, row + 8, sprite_row[n]);
+}
+
+int PixelFifo::sprite_at_x()
+{
+    if (!gpu->LCD_control.enable_sprites) {
+        return -1;
+    }
+    for (int n = 0; n < num_sprites; n++) {
+        // Sprites partly off the left edge are fetched at the first pixel
+        int x_pos = gpu->sprite_attribute_table[4 * sprites[n] + 1] - 8;
+        if (!sprite_fetched[n] && std::max(x_pos, 0) == x) {
+            return n;
+        }
+    }
+    return -1;
+}
+
+bool PixelFifo::window_starts()
+{
+    int window_x = gpu->registers[reg::WX] - 7;
+    return gpu->LCD_control.enable_window && gpu->registers[reg::WY] <= gpu->line
+        && window_x < WIDTH && std::max(window_x, 0) == x;
+}
+
+void PixelFifo::shift_out()
+{
+    u8 color = pixels[pixels_pos++];
+    u8 pixel = gpu->bg_palette[color];
+
+    // Same priority as GPU::draw_sprites, the first sprite with a pixel that isn't hidden
+    if (gpu->LCD_control.enable_sprites) {
+        for (int n = 0; n < num_sprites; n++) {
+            if (!sprite_fetched[n] || x < sprite_x[n] || x >= sprite_x[n] + 8) {
+                continue;
+            }
+            u8 sprite_color = sprite_row[n][x - sprite_x[n]];
+            if (sprite_color == 0 || (sprite_behind_bg[n] && color != 0)) {
+                continue;
+            }
+            pixel = gpu->sprite_palette[sprite_palette[n]][sprite_color];
+            break;
+        }
+    }
+    gpu->screen_row(gpu->line)[x] = pixel;
+    x++;
+}
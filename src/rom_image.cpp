@@ -0,0 +1,99 @@
+#include "rom_image.h"
+#include "util.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const size_t RomImage::BANK_SIZE = 0x4000; // 16kB
+
+RomImage::RomImage() : bytes(nullptr), length(0), file_loaded(true), mapped_length(0) {}
+
+RomImage::~RomImage()
+{
+#ifndef _WIN32
+    if (mapped_length > 0) {
+        munmap(const_cast<u8*>(bytes), mapped_length);
+    }
+#endif
+}
+
+size_t RomImage::padded_size(size_t file_size)
+{
+    size_t num_banks = std::max((size_t)2, (file_size + BANK_SIZE - 1) / BANK_SIZE);
+    return num_banks * BANK_SIZE;
+}
+
+std::shared_ptr<const RomImage> RomImage::from_data(const std::vector<u8> &rom)
+{
+    return make(rom);
+}
+
+std::shared_ptr<RomImage> RomImage::make(const std::vector<u8> &rom)
+{
+    std::shared_ptr<RomImage> image(new RomImage());
+    image->buffer = rom;
+    image->buffer.resize(padded_size(rom.size()), 0);
+    image->bytes = image->buffer.data();
+    image->length = image->buffer.size();
+    return image;
+}
+
+std::shared_ptr<const RomImage> RomImage::load(const std::string &file_path)
+{
+    std::vector<u8> rom;
+    utils::load_file(rom, file_path);
+    std::shared_ptr<RomImage> image = make(rom);
+    image->file_loaded = !rom.empty();
+    return image;
+}
+
+std::shared_ptr<const RomImage> RomImage::open(const std::string &file_path)
+{
+#ifdef _WIN32
+    return load(file_path);
+#else
+    int fd = ::open(file_path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+        std::cout << "Error reading file " << file_path << ": " << std::strerror(errno)
+                  << std::endl;
+        if (fd >= 0) {
+            close(fd);
+        }
+        std::shared_ptr<RomImage> image = make(std::vector<u8>());
+        image->file_loaded = false;
+        return image;
+    }
+    size_t file_size = st.st_size;
+    size_t size = padded_size(file_size);
+
+    /*  Reserve the padded length as zero pages first, then map the file over the start of it, so
+        bank pointers can never run past the end of the mapping even for truncated ROMs
+    */
+    void *region = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        close(fd);
+        return load(file_path);
+    }
+    void *file_map = mmap(region, file_size, PROT_READ, MAP_SHARED | MAP_FIXED, fd, 0);
+    close(fd);
+    if (file_map == MAP_FAILED) {
+        munmap(region, size);
+        return load(file_path);
+    }
+
+    std::shared_ptr<RomImage> image(new RomImage());
+    image->bytes = static_cast<const u8*>(region);
+    image->length = size;
+    image->mapped_length = size;
+    return image;
+#endif
+}
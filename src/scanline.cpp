@@ -0,0 +1,121 @@
+#include "scanline.h"
+#include <array>
+#include <cassert>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define SCANLINE_X64
+#endif
+
+namespace
+{
+    /*  Each bit of a byte moved to the lowest bit of its own byte, highest bit first. Bytes only
+        ever hold 0 or 1, so two spread rows can be combined with a shift and an or across all 8
+        bytes at once
+    */
+    std::array<u64, 256> make_spread_table()
+    {
+        std::array<u64, 256> table;
+        for (int value = 0; value < 256; value++) {
+            u8 bytes[8];
+            for (int x = 0; x < 8; x++) {
+                bytes[x] = (value >> (7 - x)) & 1;
+            }
+            std::memcpy(&table[value], bytes, 8);
+        }
+        return table;
+    }
+
+    const std::array<u64, 256> SPREAD = make_spread_table();
+
+    void compose_scalar(const u8 *colors, const u8 *palette, u8 *out, scanline::Mask &opaque)
+    {
+        opaque.clear();
+        for (int i = 0; i < scanline::WIDTH; i++) {
+            out[i] = palette[colors[i]];
+            if (colors[i] != 0) {
+                opaque.set(i);
+            }
+        }
+    }
+
+#ifdef SCANLINE_X64
+    // Part of x86-64, so always available
+    void compose_sse2(const u8 *colors, const u8 *palette, u8 *out, scanline::Mask &opaque)
+    {
+        const __m128i index[4] = {
+            _mm_set1_epi8(0), _mm_set1_epi8(1), _mm_set1_epi8(2), _mm_set1_epi8(3)
+        };
+        const __m128i entry[4] = {
+            _mm_set1_epi8(palette[0]), _mm_set1_epi8(palette[1]),
+            _mm_set1_epi8(palette[2]), _mm_set1_epi8(palette[3])
+        };
+        opaque.clear();
+        // 16 pixels at a time, never straddling a word of the mask
+        for (int i = 0; i < scanline::WIDTH; i += 16) {
+            __m128i c = _mm_loadu_si128((const __m128i *)(colors + i));
+            __m128i transparent = _mm_cmpeq_epi8(c, index[0]);
+            __m128i result = _mm_and_si128(transparent, entry[0]);
+            for (int k = 1; k < 4; k++) {
+                result = _mm_or_si128(result, _mm_and_si128(_mm_cmpeq_epi8(c, index[k]), entry[k]));
+            }
+            _mm_storeu_si128((__m128i *)(out + i), result);
+            u64 bits = ~_mm_movemask_epi8(transparent) & 0xffff;
+            opaque.bits[i / 64] |= bits << (i % 64);
+        }
+    }
+
+    // The palette is small enough to be the table for a byte shuffle
+    __attribute__((target("avx2")))
+    void compose_avx2(const u8 *colors, const u8 *palette, u8 *out, scanline::Mask &opaque)
+    {
+        const __m256i lut = _mm256_setr_epi8(
+            palette[0], palette[1], palette[2], palette[3], 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            palette[0], palette[1], palette[2], palette[3], 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m256i zero = _mm256_setzero_si256();
+        opaque.clear();
+        for (int i = 0; i < scanline::WIDTH; i += 32) {
+            __m256i c = _mm256_loadu_si256((const __m256i *)(colors + i));
+            _mm256_storeu_si256((__m256i *)(out + i), _mm256_shuffle_epi8(lut, c));
+            u64 bits = ~(u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(c, zero)) & 0xffffffff;
+            opaque.bits[i / 64] |= bits << (i % 64);
+        }
+    }
+#endif
+}
+
+scanline::Isa scanline::detect()
+{
+#ifdef SCANLINE_X64
+    static const Isa best = __builtin_cpu_supports("avx2") ? AVX2 : SSE2;
+    return best;
+#else
+    return SCALAR;
+#endif
+}
+
+void scanline::decode_row(u8 lsb, u8 msb, u8 *out)
+{
+    u64 row = SPREAD[lsb] | (SPREAD[msb] << 1);
+    std::memcpy(out, &row, 8);
+}
+
+void scanline::compose(Isa isa, const u8 *colors, const u8 *palette, u8 *out, Mask &opaque)
+{
+    assert(isa <= detect());
+    switch (isa)
+    {
+#ifdef SCANLINE_X64
+    case AVX2:
+        compose_avx2(colors, palette, out, opaque);
+        break;
+    case SSE2:
+        compose_sse2(colors, palette, out, opaque);
+        break;
+#endif
+    default:
+        compose_scalar(colors, palette, out, opaque);
+        break;
+    }
+}
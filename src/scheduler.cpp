@@ -0,0 +1,106 @@
+#include "scheduler.h"
+
+const u64 Scheduler::NEVER = ~(u64)0;
+
+Scheduler::Scheduler() : now(0), heap_size(0)
+{
+    for (int i = 0; i < NUM_EVENTS; i++) {
+        position[i] = -1;
+    }
+}
+
+void Scheduler::schedule(Event event, u64 time)
+{
+    int index = position[event];
+    if (index < 0) {
+        index = heap_size++;
+        heap[index] = {time, event};
+        position[event] = index;
+        sift_up(index);
+    }
+    else {
+        u64 prev_time = heap[index].time;
+        heap[index].time = time;
+        if (time < prev_time) {
+            sift_up(index);
+        }
+        else {
+            sift_down(index);
+        }
+    }
+}
+
+void Scheduler::cancel(Event event)
+{
+    if (position[event] >= 0) {
+        remove(position[event]);
+    }
+}
+
+bool Scheduler::scheduled(Event event) const { return position[event] >= 0; }
+
+Scheduler::Event Scheduler::pop_due()
+{
+    if (heap_size == 0 || heap[0].time > now) {
+        return NUM_EVENTS;
+    }
+    Event event = heap[0].event;
+    remove(0);
+    return event;
+}
+
+void Scheduler::remove(int index)
+{
+    position[heap[index].event] = -1;
+    heap_size--;
+    if (index == heap_size) {
+        return;
+    }
+    // Fill the gap with the last entry, which may need to move either way
+    Event moved = heap[heap_size].event;
+    heap[index] = heap[heap_size];
+    position[moved] = index;
+    sift_up(index);
+    sift_down(position[moved]);
+}
+
+void Scheduler::swap_entries(int a, int b)
+{
+    Entry temp = heap[a];
+    heap[a] = heap[b];
+    heap[b] = temp;
+    position[heap[a].event] = a;
+    position[heap[b].event] = b;
+}
+
+void Scheduler::sift_up(int index)
+{
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (heap[parent].time <= heap[index].time) {
+            break;
+        }
+        swap_entries(parent, index);
+        index = parent;
+    }
+}
+
+void Scheduler::sift_down(int index)
+{
+    while (true) {
+        int smallest = index;
+        int left = 2 * index + 1;
+        int right = left + 1;
+        if (left < heap_size && heap[left].time < heap[smallest].time) {
+            smallest = left;
+        }
+        if (right < heap_size && heap[right].time < heap[smallest].time) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            break;
+        }
+        swap_entries(index, smallest);
+        index = smallest;
+    }
+}
@@ -0,0 +1,49 @@
+#include "sdl_audio.h"
+
+SDLAudio::SDLAudio()
+{
+    for (int i = 0; i < SDL_GetNumAudioDevices(0); i++)
+    {
+        SDL_Log("%s", SDL_GetAudioDeviceName(i, 0));
+    }
+
+    SDL_AudioSpec obtained;
+    SDL_zero(spec);
+
+    spec.freq = SAMPLE_RATE;
+    spec.format = AUDIO_S16SYS;
+    spec.channels = 2;
+    spec.samples = SAMPLE_RATE / 60;
+    spec.callback = NULL;
+    spec.userdata = NULL;
+
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0)
+    {
+        SDL_Log("Unable to initialize SDL: %s", SDL_GetError());
+    }
+    
+    device_id = SDL_OpenAudioDevice(NULL, 0, &spec, &obtained, 0);
+    spec = obtained;
+    SDL_Log("Audio rate: %d", spec.freq);
+    if (device_id == 0)
+    {
+        SDL_Log("Failed to open audio: %s", SDL_GetError());
+    }
+}
+
+SDLAudio::~SDLAudio()
+{
+    SDL_CloseAudioDevice(device_id);
+    SDL_Quit();
+}
+
+void SDLAudio::start()
+{
+    SDL_PauseAudioDevice(device_id, 0);
+}
+
+int SDLAudio::queue_samples(const i16 *samples, int num_frames)
+{
+    SDL_QueueAudio(device_id, samples, 2 * num_frames * sizeof(i16));
+    return SDL_GetQueuedAudioSize(device_id) / (2 * sizeof(i16));
+}
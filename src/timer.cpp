@@ -0,0 +1,126 @@
+#include "timer.h"
+#include "registers.h"
+#include "util.h"
+#include <algorithm>
+
+namespace
+{
+    // Counter bit whose falling edge increments TIMA, for each TAC clock select
+    const int counter_bit[] = {9, 3, 5, 7};
+}
+
+Timer::Timer(Interrupts *inter, Scheduler *sched) : 
+    interrupts(inter), 
+    scheduler(sched),
+    div_start(0),
+    tima_time(0),
+    tima(0),
+    tma(0),
+    tac(0)
+{}
+
+u8 Timer::read(u16 addr)
+{
+    switch (addr)
+    {
+    case reg::DIV:
+        // Upper byte of a 16 bit counter incremented every cycle
+        return ((scheduler->now - div_start) >> 8) & 0xff;
+    case reg::TIMA:
+        update();
+        return tima;
+    case reg::TMA:
+        return tma;
+    default:
+        // Upper 5 bits of TAC unused
+        return tac | 0xf8;
+    }
+}
+
+void Timer::write(u16 addr, u8 data)
+{
+    update();
+    switch (addr)
+    {
+    case reg::DIV: {
+        // Any write resets the counter, which is a falling edge if the selected bit was set
+        bool was_set = signal();
+        div_start = scheduler->now;
+        if (was_set) {
+            increment();
+        }
+        break;
+    }
+    case reg::TIMA:
+        tima = data;
+        break;
+    case reg::TMA:
+        tma = data;
+        break;
+    default: {
+        // Disabling the timer or selecting another bit can also be a falling edge
+        bool was_set = signal();
+        tac = data & 7;
+        if (was_set && !signal()) {
+            increment();
+        }
+        break;
+    }
+    }
+    schedule_overflow();
+}
+
+void Timer::overflow()
+{
+    update();
+    schedule_overflow();
+}
+
+void Timer::update()
+{
+    u64 now = scheduler->now;
+    if (utils::bit(tac, 2) && now > tima_time) {
+        // Falling edges of the selected bit are at multiples of twice its value
+        int shift = counter_bit[tac & 3] + 1;
+        u64 edges = ((now - div_start) >> shift) - ((tima_time - div_start) >> shift);
+        while (edges > 0) {
+            // Counting up to the next overflow, if it's within reach
+            u64 n = std::min<u64>(edges, 0x100 - tima);
+            edges -= n;
+            if (n == 0x100u - tima) {
+                tima = tma;
+                interrupts->set(Interrupts::TIMER_bit);
+            }
+            else {
+                tima += n;
+            }
+        }
+    }
+    tima_time = now;
+}
+
+void Timer::increment()
+{
+    tima++;
+    if (tima == 0) {
+        tima = tma;
+        interrupts->set(Interrupts::TIMER_bit);
+    }
+}
+
+bool Timer::signal()
+{
+    return utils::bit(tac, 2) && (((scheduler->now - div_start) >> counter_bit[tac & 3]) & 1);
+}
+
+void Timer::schedule_overflow()
+{
+    if (!utils::bit(tac, 2)) {
+        scheduler->cancel(Scheduler::TIMER);
+        return;
+    }
+    // Overflow is on the (0x100 - tima)th falling edge from now
+    int shift = counter_bit[tac & 3] + 1;
+    u64 edge = ((scheduler->now - div_start) >> shift) + (0x100 - tima);
+    scheduler->schedule(Scheduler::TIMER, div_start + (edge << shift));
+}
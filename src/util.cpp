@@ -88,8 +88,7 @@ void utils::load_file(std::vector<u8> &dest, const std::string &file_path)
 		return;
     }
     
-    dest.reserve(file_size);
-    dest.insert(dest.begin(), 
-        std::istream_iterator<u8>(ifs), std::istream_iterator<u8>());
+    dest.resize(file_size);
+    ifs.read(reinterpret_cast<char*>(dest.data()), file_size);
     ifs.close();
 }
\ No newline at end of file
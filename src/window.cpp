@@ -1,6 +1,7 @@
 #include "window.h"
 #include "config.h"
 #include "keymap.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <streambuf>
@@ -28,22 +29,31 @@ void check_glError(std::string msg)
 const int SCREEN_W = 160;
 const int SCREEN_H = 144;
 
+// Frames are uploaded top row first, which puts the top of the screen at texture coordinate 0
 const float SCREEN_QUAD[] = {  
 //  position       texture coords      
-    -1,  1,  0,    0,        SCREEN_H,
-    -1, -1,  0,    0,        0,
-     1, -1,  0,    SCREEN_W, 0,
-    -1,  1,  0,    0,        SCREEN_H,
-     1, -1,  0,    SCREEN_W, 0,
-     1,  1,  0,    SCREEN_W, SCREEN_H
+    -1,  1,  0,    0,        0,
+    -1, -1,  0,    0,        SCREEN_H,
+     1, -1,  0,    SCREEN_W, SCREEN_H,
+    -1,  1,  0,    0,        0,
+     1, -1,  0,    SCREEN_W, SCREEN_H,
+     1,  1,  0,    SCREEN_W, 0
 };
 
-GameWindow::GameWindow(Joypad *pad, int scale, std::string title) :
+GameWindow::GameWindow(Joypad *pad, FrameRing *ring, int scale, std::string title, bool vsync) :
+    draw(0), 
     joypad(pad), 
+    frames(ring),
     window_scale(scale), 
-    draw(0), 
+    vsync_enabled(vsync),
     quit(false), 
-    current_palette(0)
+    current_palette(0),
+    invert_colors(false),
+    pending(nullptr),
+    dropped(0),
+    rendering(true),
+    wakeup(SDL_CreateSemaphore(0)),
+    wake_posted(false)
 {
     init_window(title);
     init_glcontext();
@@ -52,43 +62,95 @@ GameWindow::GameWindow(Joypad *pad, int scale, std::string title) :
     for (auto k: key_map) {
         key_pressed[k.first] = false;
     }
+    // The context can only be current on one thread at a time
+    SDL_GL_MakeCurrent(sdl_window, nullptr);
+    render_thread = std::thread(&GameWindow::render_loop, this);
 }
 
 GameWindow::~GameWindow()
 {
+    rendering = false;
+    wake_renderer();
+    render_thread.join();
+    SDL_DestroySemaphore(wakeup);
+    const Frame *frame = pending.exchange(nullptr);
+    if (frame != nullptr) {
+        frames->release(frame);
+    }
     SDL_GL_DeleteContext(gl_context);
     SDL_Quit();
 }
 
 bool GameWindow::frame_drawn() { return draw; }
 
-bool GameWindow::closed() 
+bool GameWindow::closed() { return quit; }
+
+bool GameWindow::paused() 
 {
-    SDL_PollEvent(&event);
-    if (event.type == SDL_QUIT || quit) {
+    if (pause) {
+        pause = false;
         return true;
     }
     else {
         return false;
     }
-    draw = false;
 }
 
-bool GameWindow::paused() 
+void GameWindow::draw_frame(const Frame &frame)
 {
-    if (pause) {
-        pause = false;
-        return true;
+    // Kept until the render thread has uploaded it, or it's replaced by a newer frame first
+    frames->borrow(&frame);
+    const Frame *replaced = pending.exchange(&frame);
+    if (replaced != nullptr) {
+        frames->release(replaced);
+        dropped++;
     }
-    else {
-        return false;
+    wake_renderer();
+    draw = true;
+}
+
+void GameWindow::wake_renderer()
+{
+    /*  Called after the work is published. If wake_posted is already set, the render thread has
+        yet to clear it, and only reads pending and the colours after clearing it, so it will see
+        the work. Posting an SDL semaphore is an atomic increment, plus a futex wake on Linux if the
+        render thread is waiting
+    */
+    if (!wake_posted.exchange(true)) {
+        SDL_SemPost(wakeup);
     }
 }
 
-void GameWindow::draw_frame(u8 pixel_buffer[])
+void GameWindow::render_loop()
+{
+    SDL_GL_MakeCurrent(sdl_window, gl_context);
+    int palette = -1;
+    bool invert = false;
+    while (true) {
+        SDL_SemWait(wakeup);
+        wake_posted = false;
+        if (!rendering) {
+            break;
+        }
+        // Drawn again for a new frame, or for a change of colours with the last one
+        const Frame *frame = pending.exchange(nullptr);
+        if (frame == nullptr && palette == current_palette && invert == invert_colors) {
+            // Woken for work already done on the last wakeup
+            continue;
+        }
+        if (frame != nullptr) {
+            upload(*frame);
+            frames->release(frame);
+        }
+        palette = current_palette;
+        invert = invert_colors;
+        present(palette, invert);
+    }
+    SDL_GL_MakeCurrent(sdl_window, nullptr);
+}
+
+void GameWindow::upload(const Frame &frame)
 {
-    glUniform1i(get_uniform("invert_colors"), invert_colors);
-    glUniform1uiv(get_uniform("palette"), 4, color_palettes[current_palette]);
     glActiveTexture(GL_TEXTURE0);
     glTexSubImage2D(
         GL_TEXTURE_2D, 
@@ -99,11 +161,16 @@ void GameWindow::draw_frame(u8 pixel_buffer[])
         144,
         GL_RED_INTEGER,
         GL_UNSIGNED_BYTE, 
-        pixel_buffer
+        frame.pixels
     );
+}
+
+void GameWindow::present(int palette, bool invert)
+{
+    glUniform1i(invert_colors_loc, invert);
+    glUniform1uiv(palette_loc, 4, color_palettes[palette]);
     glDrawArrays(GL_TRIANGLES, 0, 6); 
     SDL_GL_SwapWindow(sdl_window);
-    draw = true;
 }
 
 void GameWindow::init_window(std::string title) 
@@ -133,7 +200,11 @@ void GameWindow::init_glcontext()
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
     gl_context = SDL_GL_CreateContext(sdl_window);
-    SDL_GL_SetSwapInterval(0); // 0 = immediate updates
+    // 0 = immediate updates
+    if (!vsync_enabled || SDL_GL_SetSwapInterval(1) != 0) {
+        vsync_enabled = false;
+        SDL_GL_SetSwapInterval(0);
+    }
     if (gl_context == nullptr) {
         std::cout << "Creating OpenGL context failed. SDL Error: " << SDL_GetError() << std::endl;
     }
@@ -196,8 +267,8 @@ void GameWindow::init_screen_texture()
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
 
     glUseProgram(shader_id);
-    glUniform1i(get_uniform("screen_texture"), 0);
-    glUniform4uiv(get_uniform("palette"), 1, color_palettes[current_palette]);
+    glUniform1i(screen_texture_loc, 0);
+    glUniform1uiv(palette_loc, 4, color_palettes[current_palette]);
 
     GLenum err;
     while((err = glGetError()) != GL_NO_ERROR) {
@@ -256,11 +327,26 @@ void GameWindow::compile_shader()
         glGetProgramInfoLog(shader_id, 512, NULL, err_log);
         std::cout << "Shader program compilation failed: " << err_log << std::endl;
     }
+    screen_texture_loc = get_uniform("screen_texture");
+    palette_loc = get_uniform("palette");
+    invert_colors_loc = get_uniform("invert_colors");
 }
 
 void GameWindow::process_input()
 {
-    if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
+    SDL_Event event;
+    while (SDL_PollEvent(&event)) {
+        handle_event(event);
+    }
+    draw = false;
+}
+
+void GameWindow::handle_event(const SDL_Event &event)
+{
+    if (event.type == SDL_QUIT) {
+        quit = true;
+    }
+    else if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
         auto key_code = event.key.keysym.sym;
         if (key_code == SDLK_ESCAPE) {
             quit = true;
@@ -288,9 +374,11 @@ void GameWindow::process_input()
                 case SDLK_8:
                 case SDLK_9:
                     current_palette = key_code - SDLK_1;
+                    wake_renderer();
                     break;
                 case SDLK_BACKQUOTE:
                     invert_colors = !invert_colors;
+                    wake_renderer();
                 };
                 key_pressed[key_code] = !key_pressed[key_code];
                 joypad->press_key(joy_key);
@@ -303,5 +391,4 @@ void GameWindow::process_input()
             }
         }
     }
-    draw = false;
 }
@@ -0,0 +1,102 @@
+#include "work_pool.h"
+#include <algorithm>
+
+WorkPool::WorkPool(int num_workers) : num_queued(0), num_pending(0), next_worker(0), stopping(false)
+{
+    if (num_workers <= 0) {
+        num_workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (int i = 0; i < num_workers; i++) {
+        workers.emplace_back(new Worker());
+    }
+    for (int i = 0; i < num_workers; i++) {
+        threads.emplace_back(&WorkPool::run, this, i);
+    }
+}
+
+WorkPool::~WorkPool()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> guard(state_lock);
+        stopping = true;
+    }
+    task_available.notify_all();
+    for (auto &t: threads) {
+        t.join();
+    }
+}
+
+void WorkPool::submit(std::function<void()> task)
+{
+    Worker *worker;
+    {
+        std::lock_guard<std::mutex> guard(state_lock);
+        worker = workers[next_worker++ % workers.size()].get();
+        num_pending++;
+    }
+    {
+        std::lock_guard<std::mutex> guard(worker->lock);
+        worker->tasks.push_back(std::move(task));
+    }
+    // Only counted as queued once it can actually be taken
+    {
+        std::lock_guard<std::mutex> guard(state_lock);
+        num_queued++;
+    }
+    task_available.notify_one();
+}
+
+void WorkPool::wait()
+{
+    std::unique_lock<std::mutex> guard(state_lock);
+    tasks_done.wait(guard, [this] { return num_pending == 0; });
+}
+
+bool WorkPool::take_task(int index, std::function<void()> &task)
+{
+    int n = workers.size();
+    for (int i = 0; i < n; i++) {
+        Worker *worker = workers[(index + i) % n].get();
+        std::lock_guard<std::mutex> guard(worker->lock);
+        if (worker->tasks.empty()) {
+            continue;
+        }
+        if (i == 0) {
+            task = std::move(worker->tasks.back());
+            worker->tasks.pop_back();
+        }
+        else {
+            task = std::move(worker->tasks.front());
+            worker->tasks.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void WorkPool::run(int index)
+{
+    std::function<void()> task;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(state_lock);
+            task_available.wait(guard, [this] { return stopping || num_queued > 0; });
+            if (num_queued == 0) {
+                return;
+            }
+            // Claim a task before looking for it, so each claim is matched by exactly one queued task
+            num_queued--;
+        }
+        while (!take_task(index, task)) {
+            std::this_thread::yield();
+        }
+        task();
+        task = nullptr;
+
+        std::lock_guard<std::mutex> guard(state_lock);
+        if (--num_pending == 0) {
+            tasks_done.notify_all();
+        }
+    }
+}
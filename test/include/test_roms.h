@@ -73,9 +73,9 @@ namespace test {
     // AF: 14f0
     // DE: 0e34
     // BC: aabb
-    // SP: ff00
+    // SP: df00
     std::vector<u8> push_pop = {
-        0x31, 0x00, 0xff,   // LD SP, ff00
+        0x31, 0x00, 0xdf,   // LD SP, df00
         0x21, 0xbb, 0xaa,   // LD HL, aabb
         0xe5,               // PUSH HL
         0x21, 0x34, 0x0e,   // LD HL, 0e34
@@ -87,36 +87,88 @@ namespace test {
         0xc1                // POP BC
     };
 
+    /*  Expected output:
+        AF: d520
+        BC: c6--
+    */
     std::vector<u8> add = {
-
+        0x3e, 0x3a,     // LD A, 0x3a
+        0x06, 0xc6,     // LD B, 0xc6
+        0x80,           // ADD A, B, A <- 00, Z, HCF, CF <- 1
+        0xc6, 0x0f,     // ADD A, 0x0f, A <- 0f
+        0x88            // ADC A, B, A <- d5, HCF <- 1
     };
 
+    /*  Expected output:
+        AF: ef60
+        DE: --3e
+    */
     std::vector<u8> sub = {
-
+        0x3e, 0x3e,     // LD A, 0x3e
+        0x1e, 0x3e,     // LD E, 0x3e
+        0x93,           // SUB E, A <- 00, Z <- 1
+        0xd6, 0x0f,     // SUB 0x0f, A <- f1, HCF, CF <- 1
+        0xde, 0x01      // SBC A, 0x01, A <- ef, CF <- 0
     };
 
+    /*  Expected output:
+        AF: 1820
+        HL: --3f
+    */
     std::vector<u8> and_op = {
-
+        0x37,           // SCF
+        0x3e, 0x5a,     // LD A, 01011010
+        0x2e, 0x3f,     // LD L, 00111111
+        0xa5,           // AND L, A <- 00011010, HCF <- 1, CF <- 0
+        0xe6, 0x38      // AND 00111000, A <- 00011000
     };
 
+    /*  Expected output:
+        AF: 5b00
+    */
     std::vector<u8> or_op = {
-
+        0x37,           // SCF
+        0x3e, 0x5a,     // LD A, 01011010
+        0xb7,           // OR A, CF <- 0
+        0xf6, 0x03      // OR 00000011, A <- 01011011
     };
 
+    /*  Expected output:
+        AF: 0080
+    */
     std::vector<u8> xor_op = {
-
+        0x3e, 0xff,     // LD A, ff
+        0xee, 0x0f,     // XOR 0f, A <- f0
+        0xaf            // XOR A, A <- 00, Z <- 1
     };
 
+    /*  Expected output:
+        AF: 3c50
+        BC: 2f--
+    */
     std::vector<u8> cp = {
-
+        0x3e, 0x3c,     // LD A, 0x3c
+        0x06, 0x2f,     // LD B, 0x2f
+        0xb8,           // CP B, HCF <- 1
+        0xfe, 0x3c,     // CP 0x3c, Z <- 1
+        0xfe, 0x40      // CP 0x40, CF <- 1
     };
 
+    /*  Expected output:
+        AF: ca60
+    */
     std::vector<u8> cpl = {
-
+        0x3e, 0x35,     // LD A, 00110101
+        0x2f            // CPL, A <- 11001010
     };
 
+    /*  Expected output:
+        AF: 0f00
+    */
     std::vector<u8> swap = {
-
+        0x37,           // SCF
+        0x3e, 0xf0,     // LD A, f0
+        0xcb, 0x37      // SWAP A, A <- 0f, CF <- 0
     };
 
     /*  Expected output:
@@ -234,7 +286,7 @@ namespace test {
         0xcb, 0x2f, // SRA A, A <- 11011111, CF <- 0
     };
 
-    // AF: 0a00
+    // AF: 0a10
     std::vector<u8> shift_right_arithmetic_mem = {
         0x37,               // SCF
         0x3f,               // CCF, CF <- 0
@@ -0,0 +1,53 @@
+#include "catch.hpp"
+#include "gameboy.h"
+#include "headless.h"
+
+namespace
+{
+    // Jumps to a loop in WRAM which rewrites its own first instruction from inc b to dec b
+    std::vector<u8> self_modifying_rom()
+    {
+        std::vector<u8> rom(0x8000, 0);
+        const std::vector<u8> program = {
+            0x21, 0x00, 0xc0,   // ld hl, 0xc000
+            0x36, 0x04,         // ld (hl), 0x04 - inc b
+            0x23,               // inc hl
+            0x36, 0x3e,         // ld (hl), 0x3e - ld a, 0x05
+            0x23,               // inc hl
+            0x36, 0x05,         // ld (hl), 0x05
+            0x23,               // inc hl
+            0x36, 0xea,         // ld (hl), 0xea - ld (0xc000), a
+            0x23,               // inc hl
+            0x36, 0x00,         // ld (hl), 0x00
+            0x23,               // inc hl
+            0x36, 0xc0,         // ld (hl), 0xc0
+            0x23,               // inc hl
+            0x36, 0x18,         // ld (hl), 0x18 - jr -8
+            0x23,               // inc hl
+            0x36, 0xf8,         // ld (hl), 0xf8
+            0x06, 0x80,         // ld b, 0x80
+            0xc3, 0x00, 0xc0    // jp 0xc000
+        };
+        std::copy(program.begin(), program.end(), rom.begin() + 0x100);
+        return rom;
+    }
+}
+
+TEST_CASE("Block cache runs exactly as the interpreter", "[block_cache]")
+{
+    NullVideoSink video;
+    NullAudioSink audio;
+    GameBoy cached(RomImage::from_data(self_modifying_rom()), &video, &audio);
+    GameBoy interpreted(RomImage::from_data(self_modifying_rom()), &video, &audio);
+    interpreted.cpu.attach_block_cache(nullptr);
+
+    for (int i = 0; i < 3; i++) {
+        cached.run_frame();
+        interpreted.run_frame();
+        REQUIRE(cached.cycles() == interpreted.cycles());
+        REQUIRE(cached.cpu.PC.value == interpreted.cpu.PC.value);
+        REQUIRE(cached.cpu.BC.value == interpreted.cpu.BC.value);
+    }
+    REQUIRE(cached.block_cache.blocks_built > 0);
+    REQUIRE(cached.block_cache.invalidations > 0);
+}
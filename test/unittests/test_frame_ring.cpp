@@ -0,0 +1,95 @@
+#include "catch.hpp"
+#include "frame_ring.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    void fill_frame(FrameRing &ring, u8 shade)
+    {
+        for (int y = 0; y < ring.height; y++) {
+            std::fill(ring.draw_row(y), ring.draw_row(y) + ring.width, shade);
+        }
+    }
+}
+
+TEST_CASE("Borrowed frames aren't drawn over until released", "[frame_ring]")
+{
+    FrameRing ring(4, 2);
+    REQUIRE(ring.borrow_latest() == nullptr);
+
+    fill_frame(ring, 1);
+    const Frame *published = ring.publish(0, 100);
+    const Frame *first = ring.borrow_latest();
+    REQUIRE(first == published);
+    REQUIRE(first->number == 0);
+    REQUIRE(first->cycles == 100);
+
+    // Each slot but the one drawing into is borrowed
+    const Frame *borrowed[FrameRing::NUM_SLOTS - 1] = {first};
+    for (int n = 1; n < FrameRing::NUM_SLOTS - 1; n++) {
+        fill_frame(ring, 2);
+        ring.publish(n, 100 * (n + 1));
+        borrowed[n] = ring.borrow_latest();
+        REQUIRE(borrowed[n]->number == n);
+    }
+    fill_frame(ring, 3);
+    REQUIRE(ring.publish(3, 400) != nullptr);
+
+    // Every other slot is held, so the next frame has nowhere to go and is dropped
+    const Frame *latest = ring.borrow_latest();
+    fill_frame(ring, 0);
+    REQUIRE(ring.publish(4, 500) == nullptr);
+    REQUIRE(ring.frames_dropped == 1);
+    REQUIRE(std::all_of(first->pixels, first->pixels + 8, [](u8 x) { return x == 1; }));
+    REQUIRE(latest->number == 3);
+
+    for (const Frame *frame: borrowed) {
+        ring.release(frame);
+    }
+    ring.release(latest);
+    // The frame already started in the spare is still dropped, the one after isn't
+    REQUIRE(ring.publish(5, 600) == nullptr);
+    REQUIRE(ring.publish(6, 700) != nullptr);
+}
+
+TEST_CASE("Frames borrowed on another thread are never torn", "[frame_ring]")
+{
+    const int NUM_FRAMES = 2000;
+    FrameRing ring(160, 144);
+    std::atomic<bool> done(false);
+
+    // Each frame starts with its number and is filled with its low byte
+    std::thread producer([&]() {
+        for (int n = 1; n <= NUM_FRAMES; n++) {
+            fill_frame(ring, (u8)n);
+            std::memcpy(ring.draw_row(0), &n, sizeof(n));
+            ring.publish(n, 0);
+        }
+        done = true;
+    });
+
+    const int size = ring.width * ring.height;
+    int last = 0;
+    bool torn = false;
+    bool in_order = true;
+    while (!done || last < NUM_FRAMES) {
+        const Frame *frame = ring.borrow_latest();
+        if (frame == nullptr) {
+            continue;
+        }
+        int n;
+        std::memcpy(&n, frame->pixels, sizeof(n));
+        torn |= n != (int)frame->number;
+        torn |= std::any_of(frame->pixels + sizeof(n), frame->pixels + size,
+            [n](u8 x) { return x != (u8)n; });
+        in_order &= n >= last;
+        last = n;
+        ring.release(frame);
+    }
+    producer.join();
+    REQUIRE_FALSE(torn);
+    REQUIRE(in_order);
+}
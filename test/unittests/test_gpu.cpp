@@ -0,0 +1,372 @@
+#include "catch.hpp"
+#include "gameboy.h"
+#include "headless.h"
+#include "registers.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    // Color of the top left pixel of the last frame
+    u8 top_left(const BufferVideoSink &video)
+    {
+        return video.frame()[0];
+    }
+
+    void fill_tile_0(GameBoy &gb, u8 data)
+    {
+        gb.memory.write(reg::LCDC, 0);
+        for (u16 addr = 0x8000; addr < 0x8010; addr++) {
+            gb.memory.write(addr, data);
+        }
+        // Display and background on, unsigned tile data
+        gb.memory.write(reg::LCDC, 0x91);
+    }
+}
+
+TEST_CASE("Writing tile data through memory redraws the tile", "[gpu]")
+{
+    // jr -2
+    std::vector<u8> rom(0x8000, 0);
+    rom[0x100] = 0x18;
+    rom[0x101] = 0xfe;
+    BufferVideoSink video;
+    NullAudioSink audio;
+    GameBoy gb(RomImage::from_data(rom), &video, &audio);
+    gb.memory.write(reg::BGP, 0xe4);
+    for (u16 addr = 0x9800; addr < 0x9c00; addr++) {
+        gb.memory.write(addr, 0);
+    }
+
+    fill_tile_0(gb, 0xff);
+    gb.run_frame();
+    gb.run_frame();
+    REQUIRE(top_left(video) == 3);
+
+    // The decoded copy of tile 0 is stale until the write reaches the GPU
+    fill_tile_0(gb, 0);
+    gb.run_frame();
+    gb.run_frame();
+    REQUIRE(top_left(video) == 0);
+
+    // Only the low bit plane of the first pixel
+    gb.memory.write(reg::LCDC, 0);
+    gb.memory.write(0x8000, 0x80);
+    gb.memory.write(reg::LCDC, 0x91);
+    gb.run_frame();
+    gb.run_frame();
+    REQUIRE(top_left(video) == 1);
+}
+
+namespace
+{
+    /*  Random VRAM, OAM and registers with the display on, then 4 frames with VRAM, OAM, scroll, 
+        window position and LCDC poked outside mode 3. Returns a hash of the 4 frames, 
+        which covers background, window and sprites with every combination of LCDC settings.
+        From scene 16 on, sprites are crowded onto a few lines, well over 10 to a line, and OAM is
+        replaced by DMA after every frame
+    */
+    u64 draw_scene(int seed, scanline::Isa compositor, bool always_fifo)
+    {
+        std::mt19937 rng(seed);
+        auto random = [&rng](int n) { return (int)(rng() % n); };
+        Interrupts interrupts;
+        Scheduler scheduler;
+        BufferVideoSink video;
+        GPU gpu(&interrupts, &scheduler, &video);
+        gpu.compositor = compositor;
+        gpu.always_fifo = always_fifo;
+
+        for (u16 addr = 0x8000; addr < 0xa000; addr++) {
+            gpu.write(addr, random(256));
+        }
+        bool crowded = seed >= 16;
+        std::vector<u8> oam(0xa0);
+        auto random_oam = [&]() {
+            for (int i = 0; i < 40; i++) {
+                // On screen, give or take a few lines and columns
+                oam[4*i] = crowded ? 56 + random(24) : 8 + random(160);
+                oam[4*i + 1] = random(176);
+                oam[4*i + 2] = random(256);
+                oam[4*i + 3] = random(256);
+            }
+        };
+        random_oam();
+        for (int i = 0; i < 0xa0; i++) {
+            gpu.write(0xfe00 + i, oam[i]);
+        }
+        gpu.write(reg::SCROLLX, random(256));
+        gpu.write(reg::SCROLLY, random(256));
+        gpu.write(reg::WX, random(180));
+        gpu.write(reg::WY, random(150));
+        gpu.write(reg::BGP, random(256));
+        gpu.write(reg::OBP0, random(256));
+        gpu.write(reg::OBP1, random(256));
+        gpu.write(reg::LCDC, 0x80 | random(128));
+
+        u64 hash = 0xcbf29ce484222325;
+        for (int frame = 0; frame < 4; frame++) {
+            gpu.frame_drawn = false;
+            while (!gpu.frame_drawn) {
+                scheduler.now = scheduler.next_deadline();
+                if (scheduler.pop_due() == Scheduler::DMA_END) {
+                    gpu.end_dma();
+                }
+                else {
+                    gpu.update_mode();
+                }
+                // Registers written during mode 3 would only apply to part of the line
+                if ((gpu.read(reg::STAT) & 3) == 3) {
+                    continue;
+                }
+                if (random(8) == 0) {
+                    gpu.write(0x8000 + random(0x2000), random(256));
+                }
+                if (random(16) == 0) {
+                    gpu.write(0xfe00 + random(0xa0), random(256));
+                }
+                if (random(64) == 0) {
+                    gpu.write(reg::SCROLLX, random(256));
+                }
+                if (random(64) == 0) {
+                    gpu.write(reg::WX, random(180));
+                }
+                if (random(128) == 0) {
+                    gpu.write(reg::LCDC, 0x80 | random(128));
+                }
+            }
+            // Rows bottom first, as frames were laid out when the golden hashes were taken
+            for (int y = GPU::LCD_HEIGHT - 1; y >= 0; y--) {
+                for (int x = 0; x < GPU::LCD_WIDTH; x++) {
+                    hash = (hash ^ video.frame()[y * GPU::LCD_WIDTH + x]) * 0x100000001b3;
+                }
+            }
+            if (crowded) {
+                random_oam();
+                gpu.dma_transfer(oam.begin());
+            }
+        }
+        return hash;
+    }
+
+    // Hashes of scenes 0-23 drawn by the original one pixel at a time renderer
+    const u64 golden[] = {
+        0xd7495ba8b0143d19, 0xbc2a52029fd6f0c6, 0x2164bf188b88a687, 0x06c498dae3fbf16e,
+        0x77f92a351ed2e1fa, 0xbc77853e7cc2f336, 0x9bbc199a40b627c4, 0x9d15821f981f5d8f,
+        0x57773db8c323f48f, 0xc3942f53787d1cd8, 0x1fcee9738a27b9b9, 0xb943154b5863795c,
+        0x462ff53d074ab4ca, 0xeda23741084e24e3, 0xb357972a7820f9bc, 0x58f1a2e45aeb1c25,
+        0x1d8484c446d302cc, 0x210b3532991e577b, 0x6578eaa290828caa, 0x59920e8d0da2312f,
+        0xd8b73803c84230f1, 0xd7be99ab3683fd9a, 0x72468eb1a1323eca, 0x8bcd360de10457a4
+    };
+}
+
+TEST_CASE("Frames match golden frames with every compositor", "[gpu]")
+{
+    for (int isa = scanline::SCALAR; isa <= scanline::detect(); isa++) {
+        for (int seed = 0; seed < 24; seed++) {
+            INFO("compositor " << isa << ", scene " << seed);
+            REQUIRE(draw_scene(seed, (scanline::Isa)isa, false) == golden[seed]);
+        }
+    }
+}
+
+TEST_CASE("Pixel FIFO draws golden frames", "[gpu]")
+{
+    for (int seed = 0; seed < 24; seed++) {
+        INFO("scene " << seed);
+        REQUIRE(draw_scene(seed, scanline::detect(), true) == golden[seed]);
+    }
+}
+
+namespace
+{
+    // Handle events until the GPU enters a mode, returning the time it did
+    u64 run_until_mode(GPU &gpu, Scheduler &scheduler, int mode)
+    {
+        do {
+            scheduler.now = scheduler.next_deadline();
+            scheduler.pop_due();
+            gpu.update_mode();
+        } while ((gpu.read(reg::STAT) & 3) != mode);
+        return scheduler.now;
+    }
+}
+
+TEST_CASE("Registers written during mode 3 only change the rest of the line", "[gpu]")
+{
+    Interrupts interrupts;
+    Scheduler scheduler;
+    BufferVideoSink video;
+    GPU gpu(&interrupts, &scheduler, &video);
+
+    // Tile 0 is all color 1, and fills the background and window
+    for (u16 addr = 0x8000; addr < 0x8010; addr += 2) {
+        gpu.write(addr, 0xff);
+    }
+    gpu.write(reg::BGP, 0xe4);
+    gpu.write(reg::LCDC, 0x91);
+
+    // Pixel 80 of line 0 is shifted out in dot 92 of mode 3, when color 1 becomes 2
+    u64 start = run_until_mode(gpu, scheduler, 3);
+    scheduler.now = start + 12 + 80;
+    gpu.write(reg::BGP, 0xe8);
+    REQUIRE(run_until_mode(gpu, scheduler, 0) == start + 172);
+
+    // Line 1 has 3 pixels of fine scroll, a sprite at the left edge and the window from pixel 80
+    gpu.write(reg::SCROLLX, 3);
+    gpu.write(reg::WX, 87);
+    gpu.write(reg::WY, 1);
+    gpu.write(0xfe00, 17);
+    gpu.write(0xfe01, 8);
+    gpu.write(reg::LCDC, 0xb3);
+    start = run_until_mode(gpu, scheduler, 3);
+    gpu.write(reg::BGP, 0xe8);
+    // Discarded pixels, waiting for the tile fetch before fetching the sprite and restarting
+    // the fetcher for the window
+    REQUIRE(run_until_mode(gpu, scheduler, 0) == start + 172 + 3 + 8 + 6);
+    // Horizontal blank is shorter, so the line still takes 456 cycles
+    REQUIRE(run_until_mode(gpu, scheduler, 2) == start - 80 + 456);
+
+    while (!gpu.frame_drawn) {
+        run_until_mode(gpu, scheduler, 1);
+    }
+    const u8 *line_0 = video.frame().data();
+    for (int x = 0; x < GPU::LCD_WIDTH; x++) {
+        INFO("pixel " << x);
+        REQUIRE(line_0[x] == (x < 80 ? 1 : 2));
+    }
+}
+
+TEST_CASE("Display off stops the GPU at line 0 until it's turned back on", "[gpu]")
+{
+    Interrupts interrupts;
+    Scheduler scheduler;
+    BufferVideoSink video;
+    GPU gpu(&interrupts, &scheduler, &video);
+    gpu.write(0x8000, 0x5a);
+    gpu.write(reg::BGP, 0xe4);
+    gpu.write(reg::LCDC, 0x91);
+    while (gpu.read(reg::LY) != 10) {
+        run_until_mode(gpu, scheduler, 3);
+    }
+    REQUIRE(gpu.read(0x8000) == 0xff);
+
+    gpu.write(reg::LCDC, 0x11);
+    REQUIRE(gpu.read(reg::LY) == 0);
+    REQUIRE((gpu.read(reg::STAT) & 3) == 0);
+    REQUIRE(gpu.read(0x8000) == 0x5a);
+    // One blank frame, and nothing else for a frame
+    REQUIRE(video.frame_count() == 1);
+    REQUIRE(std::count(video.frame().begin(), video.frame().end(), 0) == 160 * 144);
+    u64 off = scheduler.now;
+    REQUIRE(scheduler.next_deadline() == off + 70224);
+    scheduler.now = scheduler.next_deadline();
+    scheduler.pop_due();
+    gpu.update_mode();
+    REQUIRE(gpu.frame_drawn);
+    REQUIRE(gpu.read(reg::LY) == 0);
+    REQUIRE(video.frame_count() == 1);
+
+    // Line 0 starts over from when it's turned on
+    scheduler.now += 1000;
+    u64 on = scheduler.now;
+    gpu.write(reg::LCDC, 0x91);
+    REQUIRE((gpu.read(reg::STAT) & 3) == 2);
+    REQUIRE(run_until_mode(gpu, scheduler, 3) == on + 80);
+    REQUIRE(run_until_mode(gpu, scheduler, 0) == on + 80 + 172);
+    REQUIRE(run_until_mode(gpu, scheduler, 2) == on + 456);
+    REQUIRE(gpu.read(reg::LY) == 1);
+}
+
+TEST_CASE("Background cache renders cells again only once they change", "[gpu]")
+{
+    Interrupts interrupts;
+    Scheduler scheduler;
+    BufferVideoSink video;
+    GPU gpu(&interrupts, &scheduler, &video);
+    gpu.write(reg::BGP, 0xe4);
+    gpu.write(reg::LCDC, 0x91);
+    // Misses in a frame, which ends in vertical blank with VRAM accessible
+    auto frame_misses = [&]() {
+        u64 misses = gpu.bg_cache_misses;
+        gpu.frame_drawn = false;
+        while (!gpu.frame_drawn) {
+            scheduler.now = scheduler.next_deadline();
+            scheduler.pop_due();
+            gpu.update_mode();
+        }
+        return gpu.bg_cache_misses - misses;
+    };
+
+    // 20 x 18 cells on screen
+    REQUIRE(frame_misses() == 360);
+    REQUIRE(gpu.bg_cache_hits == 144 * 20 - 360);
+    REQUIRE(frame_misses() == 0);
+
+    gpu.write(0x9800, 1);
+    REQUIRE(frame_misses() == 1);
+    // Every other cell is still tile 0
+    gpu.write(0x8000, 0xff);
+    REQUIRE(frame_misses() == 359);
+    // Writing the same value changes nothing
+    gpu.write(0x8000, 0xff);
+    gpu.write(0x9800, 1);
+    REQUIRE(frame_misses() == 0);
+
+    const u8 *line_0 = video.frame().data();
+    REQUIRE(line_0[0] == 0);
+    REQUIRE(line_0[8] == 1);
+}
+
+namespace
+{
+    /*  Run 6 frames with STAT interrupts on LYC and every mode, writing SCX during mode 3 of some
+        lines. Returns the time, STAT, LY, IF and first VRAM byte as seen by the CPU after every
+        event, and the number of frames passed to the video sink
+    */
+    std::vector<u64> run_frames(GPU::RenderPolicy policy, int interval, long &frames_drawn)
+    {
+        Interrupts interrupts;
+        Scheduler scheduler;
+        BufferVideoSink video;
+        GPU gpu(&interrupts, &scheduler, &video);
+        gpu.set_render_policy(policy, interval);
+        gpu.write(0x8000, 0x5a);
+        gpu.write(reg::LYC, 70);
+        gpu.write(reg::STAT, 0x78);
+        gpu.write(reg::LCDC, 0x93);
+
+        std::vector<u64> trace;
+        for (int frame = 0; frame < 6; frame++) {
+            gpu.frame_drawn = false;
+            while (!gpu.frame_drawn) {
+                scheduler.now = scheduler.next_deadline();
+                scheduler.pop_due();
+                gpu.update_mode();
+                if ((gpu.read(reg::STAT) & 3) == 3 && gpu.read(reg::LY) % 4 == 0) {
+                    gpu.write(reg::SCROLLX, gpu.read(reg::LY));
+                }
+                trace.push_back(scheduler.now);
+                trace.push_back(gpu.read(reg::STAT) | gpu.read(reg::LY) << 8 
+                    | interrupts.read() << 16 | (u64)gpu.read(0x8000) << 24);
+                interrupts.write(0);
+            }
+        }
+        frames_drawn = video.frame_count();
+        return trace;
+    }
+}
+
+TEST_CASE("Skipped frames keep the same timing and interrupts", "[gpu]")
+{
+    long frames_drawn;
+    std::vector<u64> trace = run_frames(GPU::RENDER_ALWAYS, 1, frames_drawn);
+    REQUIRE(frames_drawn == 6);
+
+    REQUIRE(run_frames(GPU::RENDER_EVERY_NTH, 3, frames_drawn) == trace);
+    REQUIRE(frames_drawn == 2);
+    REQUIRE(run_frames(GPU::RENDER_ON_REQUEST, 1, frames_drawn) == trace);
+    REQUIRE(frames_drawn == 0);
+    REQUIRE(run_frames(GPU::RENDER_NEVER, 1, frames_drawn) == trace);
+    REQUIRE(frames_drawn == 0);
+}
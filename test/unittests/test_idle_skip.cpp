@@ -0,0 +1,118 @@
+#include "catch.hpp"
+#include "gameboy.h"
+#include "headless.h"
+
+namespace
+{
+    /*  Waits in loop with the VBlank interrupt on and the timer running. The handler logs TIMA
+        to 0xc100 + n for the nth interrupt, so the log records when each was taken, and sets the
+        flag at 0xc000 that loops wait on
+    */
+    std::vector<u8> loop_rom(const std::vector<u8> &loop)
+    {
+        std::vector<u8> rom(0x8000, 0);
+        const std::vector<u8> handler = {
+            0xf5, 0xe5,             // push af, push hl
+            0xfa, 0x01, 0xc0,       // ld a, (0xc001)
+            0x6f, 0x26, 0xc1,       // ld l, a; ld h, 0xc1
+            0xf0, 0x05, 0x77,       // ldh a, (TIMA); ld (hl), a
+            0x7d, 0x3c,             // ld a, l; inc a
+            0xea, 0x01, 0xc0,       // ld (0xc001), a
+            0x3e, 0x01,             // ld a, 1
+            0xea, 0x00, 0xc0,       // ld (0xc000), a
+            0xe1, 0xf1, 0xd9        // pop hl, pop af, reti
+        };
+        std::vector<u8> program = {
+            0x31, 0xf0, 0xdf,       // ld sp, 0xdff0
+            0x3e, 0x05, 0xe0, 0x07, // TAC = timer on, 16 cycles per tick
+            0x3e, 0x01, 0xe0, 0xff, // IE = VBlank
+            0x3e, 0x91, 0xe0, 0x40, // LCDC = display and background on
+            0xfb                    // ei
+        };
+        program.insert(program.end(), loop.begin(), loop.end());
+
+        std::copy(handler.begin(), handler.end(), rom.begin() + 0x40);
+        rom[0x100] = 0xc3;
+        rom[0x101] = 0x50;
+        rom[0x102] = 0x01;
+        std::copy(program.begin(), program.end(), rom.begin() + 0x150);
+        return rom;
+    }
+
+    void require_same_state(GameBoy &a, GameBoy &b)
+    {
+        a.cpu.sync_flags();
+        b.cpu.sync_flags();
+        REQUIRE(a.cycles() == b.cycles());
+        REQUIRE(a.cpu.AF.value == b.cpu.AF.value);
+        REQUIRE(a.cpu.BC.value == b.cpu.BC.value);
+        REQUIRE(a.cpu.DE.value == b.cpu.DE.value);
+        REQUIRE(a.cpu.HL.value == b.cpu.HL.value);
+        REQUIRE(a.cpu.SP.value == b.cpu.SP.value);
+        REQUIRE(a.cpu.PC.value == b.cpu.PC.value);
+        REQUIRE(a.memory.internal_RAM == b.memory.internal_RAM);
+        REQUIRE(a.memory.high_RAM == b.memory.high_RAM);
+        REQUIRE(a.interrupts.read() == b.interrupts.read());
+    }
+}
+
+TEST_CASE("Idle loop skipping keeps the same timing", "[idle_skip]")
+{
+    // Waits for the flag, reading only WRAM, so can be skipped
+    const std::vector<u8> vblank_wait = {
+        0xfa, 0x00, 0xc0,   // loop: ld a, (0xc000)
+        0xa7,               // and a
+        0x28, 0xfa,         // jr z, loop
+        0xaf,               // xor a
+        0xea, 0x00, 0xc0,   // ld (0xc000), a
+        0x18, 0xf4          // jr loop
+    };
+    // Polls DIV, which changes without any event
+    const std::vector<u8> div_poll = {
+        0xf0, 0x04,         // loop: ldh a, (DIV)
+        0xfe, 0x40,         // cp 0x40
+        0x20, 0xfa,         // jr nz, loop
+        0x04,               // inc b
+        0x18, 0xf7          // jr loop
+    };
+    // Waits for the flag like vblank_wait, but writes memory every iteration
+    const std::vector<u8> writing_wait = {
+        0xea, 0x10, 0xc0,   // loop: ld (0xc010), a
+        0xfa, 0x00, 0xc0,   // ld a, (0xc000)
+        0xa7,               // and a
+        0x28, 0xf7,         // jr z, loop
+        0xaf,               // xor a
+        0xea, 0x00, 0xc0,   // ld (0xc000), a
+        0x18, 0xf1          // jr loop
+    };
+    // Spins in place and leaves everything to the handler, so can be skipped
+    const std::vector<u8> self_jump = {
+        0x18, 0xfe          // loop: jr loop
+    };
+    const std::vector<u8> loops[] = {vblank_wait, div_poll, writing_wait, self_jump};
+
+    NullVideoSink video;
+    NullAudioSink audio;
+    for (int i = 0; i < 4; i++) {
+        INFO("loop " << i);
+        std::vector<u8> rom = loop_rom(loops[i]);
+        GameBoy skipping(RomImage::from_data(rom), &video, &audio);
+        GameBoy stepping(RomImage::from_data(rom), &video, &audio);
+        stepping.cpu.enable_idle_skip = false;
+
+        for (int frame = 0; frame < 10; frame++) {
+            skipping.run_frame();
+            stepping.run_frame();
+            require_same_state(skipping, stepping);
+        }
+        // At least one interrupt was logged
+        REQUIRE(skipping.memory.internal_RAM[1] > 0);
+        REQUIRE(stepping.cpu.idle_cycles_skipped == 0);
+        if (i == 0 || i == 3) {
+            REQUIRE(skipping.cpu.idle_cycles_skipped > 0);
+        }
+        else {
+            REQUIRE(skipping.cpu.idle_cycles_skipped == 0);
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#include "catch.hpp"
+#include "input_movie.h"
+#include "joypad.h"
+
+TEST_CASE("Input movie parsing", "[movie]")
+{
+    InputMovie movie;
+    REQUIRE(movie.parse("# frame buttons\n"
+                        "10 start\n"
+                        "\n"
+                        "12 -\n"
+                        "20 A+Right   # comment\n"));
+
+    REQUIRE(movie.buttons(0) == 0);
+    REQUIRE(movie.buttons(10) == 1 << Joypad::START);
+    REQUIRE(movie.buttons(11) == 1 << Joypad::START);
+    REQUIRE(movie.buttons(12) == 0);
+    REQUIRE(movie.buttons(1000) == ((1 << Joypad::A) | (1 << Joypad::RIGHT)));
+
+    REQUIRE_FALSE(movie.parse("10 jump\n"));
+    REQUIRE_FALSE(movie.parse("10 a\n5 b\n"));
+    REQUIRE_FALSE(movie.parse("10\n"));
+}
+
+TEST_CASE("Input movie drives joypad", "[movie]")
+{
+    InputMovie movie;
+    REQUIRE(movie.parse("0 a+up\n1 b\n"));
+    Joypad pad;
+
+    movie.apply(&pad, 0);
+    // Buttons and directions are active low, selected by bit 4 or 5
+    REQUIRE((pad.get_state(false) & 0xf) == 0xe);
+    REQUIRE((pad.get_state(true) & 0xf) == 0xb);
+
+    movie.apply(&pad, 1);
+    REQUIRE((pad.get_state(false) & 0xf) == 0xd);
+    REQUIRE((pad.get_state(true) & 0xf) == 0xf);
+}
@@ -0,0 +1,192 @@
+#include "catch.hpp"
+#include "gameboy.h"
+#include "headless.h"
+#include "instructions.h"
+
+TEST_CASE("Instruction table is consistent", "[instructions]")
+{
+    REQUIRE(std::string(instr::table[0x00].mnemonic) == "NOP");
+    REQUIRE(std::string(instr::table[instr::CB_PREFIX | 0x7c].mnemonic) == "BIT 7, H");
+    REQUIRE(instr::table[0xcb].kind == instr::PREFIX);
+
+    for (int i = 0; i < instr::NUM_INSTRUCTIONS; i++) {
+        const instr::Instruction &ins = instr::table[i];
+        // Only conditional instructions may take longer when taken
+        if (ins.cond == instr::ALWAYS) {
+            REQUIRE(ins.cycles == ins.cycles_taken);
+        }
+        else {
+            REQUIRE(ins.cycles < ins.cycles_taken);
+        }
+    }
+}
+
+TEST_CASE("Handlers take the cycles in the instruction table", "[instructions]")
+{
+    std::vector<u8> rom(0x8000, 0);
+    const std::vector<u8> program = {
+        0xaf,               // xor a
+        0x20, 0x05,         // jr nz, +5 (not taken)
+        0x28, 0x00,         // jr z, +0 (taken)
+        0xcb, 0x7c,         // bit 7, h
+        0xcb, 0x46,         // bit 0, (hl)
+        0xc4, 0x00, 0x00    // call nz, 0 (not taken)
+    };
+    std::copy(program.begin(), program.end(), rom.begin() + 0x100);
+
+    NullVideoSink video;
+    NullAudioSink audio;
+    GameBoy gb(RomImage::from_data(rom), &video, &audio);
+
+    REQUIRE(gb.cpu.step() == 4 * instr::table[0xaf].cycles);
+    REQUIRE(gb.cpu.step() == 4 * instr::table[0x20].cycles);
+    REQUIRE(gb.cpu.step() == 4 * instr::table[0x28].cycles_taken);
+    REQUIRE(gb.cpu.step() == 4 * instr::table[instr::CB_PREFIX | 0x7c].cycles);
+    REQUIRE(gb.cpu.step() == 4 * instr::table[instr::CB_PREFIX | 0x46].cycles);
+    REQUIRE(gb.cpu.step() == 4 * instr::table[0xc4].cycles);
+    REQUIRE(gb.cpu.PC.value == 0x10c);
+}
+
+TEST_CASE("Instruction lengths match the bytes handlers fetch", "[instructions]")
+{
+    NullVideoSink video;
+    NullAudioSink audio;
+    GameBoy gb(RomImage::from_data(std::vector<u8>(0x8000, 0)), &video, &audio);
+
+    for (int opcode = 0; opcode < instr::NUM_INSTRUCTIONS; opcode++) {
+        const instr::Instruction &ins = instr::table[opcode];
+        switch (ins.kind)
+        {
+        // Control flow doesn't fall through to the next instruction
+        case instr::JP: case instr::JR: case instr::CALL: case instr::RET: case instr::RETI:
+        case instr::RST: case instr::HALT: case instr::STOP: case instr::INVALID: 
+        case instr::PREFIX:
+            continue;
+        default:
+            break;
+        }
+        if (opcode >= instr::CB_PREFIX) {
+            gb.memory.write(0xc000, 0xcb);
+            gb.memory.write(0xc001, opcode & 0xff);
+        }
+        else {
+            gb.memory.write(0xc000, opcode);
+        }
+        gb.cpu.PC.value = 0xc000;
+        gb.cpu.SP.value = 0xdff0;
+        gb.cpu.HL.value = 0xc100;
+        gb.cpu.execute_next();
+        REQUIRE(gb.cpu.PC.value == 0xc000 + ins.length);
+    }
+}
+
+namespace
+{
+    // Result and flags of 8-bit arithmetic and logic on A and B, worked out one flag at a time
+    u16 expected_af(int opcode, u8 a, u8 b, u8 f)
+    {
+        bool carry = f & Processor::CARRY;
+        int result = a;
+        bool z = f & Processor::ZERO, n = false, h = false, c = carry;
+        switch (opcode)
+        {
+        case 0x80: case 0x88:
+            // ADD, ADC
+            carry &= opcode == 0x88;
+            result = a + b + carry;
+            h = (a & 0xf) + (b & 0xf) + carry > 0xf;
+            c = result > 0xff;
+            break;
+        case 0x90: case 0x98: case 0xb8:
+            // SUB, SBC, CP
+            carry &= opcode == 0x98;
+            result = a - b - carry;
+            n = true;
+            h = (a & 0xf) < (b & 0xf) + carry;
+            c = a < b + carry;
+            break;
+        case 0xa0:
+            result = a & b;
+            h = true;
+            c = false;
+            break;
+        case 0xa8:
+            result = a ^ b;
+            c = false;
+            break;
+        case 0xb0:
+            result = a | b;
+            c = false;
+            break;
+        case 0x3c:
+            // INC A, carry unaffected
+            result = a + 1;
+            h = (a & 0xf) == 0xf;
+            break;
+        case 0x3d:
+            // DEC A
+            result = a - 1;
+            n = true;
+            h = (a & 0xf) == 0;
+            break;
+        case 0x2f:
+            // CPL, zero and carry unaffected
+            result = ~a;
+            n = h = true;
+            break;
+        case 0x37:
+            // SCF
+            c = true;
+            break;
+        case 0x3f:
+            // CCF
+            c = !carry;
+            break;
+        case 0x17:
+            // RLA, zero always reset
+            result = (a << 1) | carry;
+            c = a >> 7;
+            z = false;
+            break;
+        }
+        if (opcode >= 0x80 || opcode == 0x3c || opcode == 0x3d) {
+            z = (result & 0xff) == 0;
+        }
+        if (opcode == 0xb8) {
+            result = a;
+        }
+        u8 flags = (z ? Processor::ZERO : 0) | (n ? Processor::SUBTRACT : 0)
+            | (h ? Processor::HALF_CARRY : 0) | (c ? Processor::CARRY : 0);
+        return ((result & 0xff) << 8) | flags;
+    }
+}
+
+TEST_CASE("Lazily evaluated flags match flags set one at a time", "[instructions]")
+{
+    NullVideoSink video;
+    NullAudioSink audio;
+    GameBoy gb(RomImage::from_data(std::vector<u8>(0x8000, 0)), &video, &audio);
+    const int opcodes[] = {0x80, 0x88, 0x90, 0x98, 0xa0, 0xa8, 0xb0, 0xb8, 0x3c, 0x3d, 0x2f, 0x37,
+        0x3f, 0x17};
+    const u8 flags[] = {0x00, 0x10, 0x80, 0x90, 0x60, 0xf0};
+
+    for (int opcode: opcodes) {
+        gb.memory.write(0xc000, opcode);
+        // Only the ALU operations at 0x80-0xbf take a second operand
+        int num_b = opcode >= 0x80 ? 0x100 : 1;
+        for (int a = 0; a < 0x100; a++) {
+            for (int b = 0; b < num_b; b++) {
+                for (u8 f: flags) {
+                    gb.cpu.PC.value = 0xc000;
+                    gb.cpu.A = a;
+                    gb.cpu.B = b;
+                    gb.cpu.F = f;
+                    gb.cpu.load_flags();
+                    gb.cpu.execute_next();
+                    gb.cpu.sync_flags();
+                    REQUIRE(gb.cpu.AF.value == expected_af(opcode, a, b, f));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,129 @@
+#include "catch.hpp"
+#include "gameboy.h"
+#include "headless.h"
+#include "instructions.h"
+#include <random>
+
+namespace
+{
+    /*  Loop of random instructions, mostly ones the JIT translates, with untranslated ones that
+        read flags (DAA, conditional jumps, rotates through carry) mixed in. Pointers are reset
+        into WRAM at the top of every iteration
+    */
+    std::vector<u8> random_rom(std::mt19937 &rng)
+    {
+        std::vector<u8> rom(0x8000, 0);
+        std::vector<u8> program = {
+            0x31, 0xf0, 0xdf,   // ld sp, 0xdff0
+            0x21, 0x00, 0xc1,   // ld hl, 0xc100
+            0x01, 0x80, 0xc1,   // ld bc, 0xc180
+            0x11, 0xa0, 0xff,   // ld de, 0xffa0
+        };
+        const u8 untranslated[] = {0x27, 0x17, 0x1f, 0x07};
+
+        std::uniform_int_distribution<int> byte(0, 0xff);
+        std::uniform_int_distribution<int> size(4, 40);
+        int length = size(rng);
+        for (int i = 0; i < length; i++) {
+            int roll = byte(rng);
+            if (roll < 8) {
+                program.push_back(untranslated[roll & 3]);
+                continue;
+            }
+            if (roll < 12) {
+                // jr nz/z/nc/c, +0
+                program.push_back(0x20 + 8 * (roll & 3));
+                program.push_back(0);
+                continue;
+            }
+            int opcode;
+            instr::Kind kind;
+            do {
+                opcode = byte(rng);
+                if (opcode == 0xcb) {
+                    opcode = instr::CB_PREFIX | byte(rng);
+                }
+                kind = instr::table[opcode].kind;
+                // Keep pointers in WRAM and HRAM, and the stack balanced
+            } while (kind == instr::PREFIX || kind == instr::INVALID || kind == instr::HALT
+                || kind == instr::STOP || kind == instr::DI || kind == instr::EI
+                || kind == instr::JP || kind == instr::JR || kind == instr::CALL
+                || kind == instr::RET || kind == instr::RETI || kind == instr::RST
+                || kind == instr::LD_IMM || kind == instr::LD_ABS || kind == instr::LD_HIGH
+                || kind == instr::LD_NN_SP || kind == instr::LD_HL_SP || kind == instr::PUSH
+                || kind == instr::POP || (kind == instr::LD && instr::table[opcode].dst == instr::SP)
+                || (kind == instr::ADD && instr::table[opcode].dst == instr::SP)
+                || (instr::is_pair(instr::table[opcode].dst) && kind != instr::LD_MEM)
+                || instr::table[opcode].dst == instr::H || instr::table[opcode].dst == instr::B
+                || instr::table[opcode].dst == instr::D);
+
+            if (opcode >= instr::CB_PREFIX) {
+                program.push_back(0xcb);
+            }
+            program.push_back(opcode & 0xff);
+            for (int j = 1; j < instr::table[opcode].length - (opcode >= instr::CB_PREFIX); j++) {
+                program.push_back(byte(rng));
+            }
+        }
+        // push/pop pairs, high page reads and writes, then loop
+        const std::vector<u8> tail = {
+            0xc5, 0xd5, 0xe5, 0xf5, 0xc1, 0xd1, 0xe1, 0xf1,
+            0xe0, 0x90, 0xf0, 0x91, 0xe2, 0xf2,
+            0xea, 0x00, 0xc2, 0xfa, 0x01, 0xc2,
+            0x3e, (u8)byte(rng), 0x06, (u8)byte(rng)
+        };
+        program.insert(program.end(), tail.begin(), tail.end());
+        program.push_back(0x18);
+        program.push_back((u8)(-(int)program.size() - 1));
+
+        rom[0x100] = 0xc3;
+        rom[0x101] = 0x50;
+        rom[0x102] = 0x01;
+        std::copy(program.begin(), program.end(), rom.begin() + 0x150);
+        return rom;
+    }
+
+    void require_same_state(GameBoy &a, GameBoy &b)
+    {
+        a.cpu.sync_flags();
+        b.cpu.sync_flags();
+        REQUIRE(a.cycles() == b.cycles());
+        REQUIRE(a.cpu.AF.value == b.cpu.AF.value);
+        REQUIRE(a.cpu.BC.value == b.cpu.BC.value);
+        REQUIRE(a.cpu.DE.value == b.cpu.DE.value);
+        REQUIRE(a.cpu.HL.value == b.cpu.HL.value);
+        REQUIRE(a.cpu.SP.value == b.cpu.SP.value);
+        REQUIRE(a.cpu.PC.value == b.cpu.PC.value);
+        REQUIRE(a.memory.internal_RAM == b.memory.internal_RAM);
+        REQUIRE(a.memory.high_RAM == b.memory.high_RAM);
+    }
+}
+
+TEST_CASE("JIT runs random code exactly as the interpreter", "[jit]")
+{
+    std::mt19937 rng(1234);
+    NullVideoSink video;
+    NullAudioSink audio;
+    u64 compiled = 0;
+
+    for (int i = 0; i < 100; i++) {
+        std::vector<u8> rom = random_rom(rng);
+        GameBoy interpreted(RomImage::from_data(rom), &video, &audio);
+        interpreted.cpu.attach_block_cache(nullptr);
+        GameBoy blocks(RomImage::from_data(rom), &video, &audio);
+        blocks.cpu.attach_jit(nullptr);
+        GameBoy jit(RomImage::from_data(rom), &video, &audio);
+
+        for (int frame = 0; frame < 2; frame++) {
+            interpreted.run_frame();
+            blocks.run_frame();
+            jit.run_frame();
+            require_same_state(interpreted, blocks);
+            require_same_state(interpreted, jit);
+        }
+        compiled += jit.jit.instructions_compiled;
+    }
+    if (GameBoy(RomImage::from_data(std::vector<u8>(0x8000, 0)), &video, &audio).jit.supported()) {
+        REQUIRE(compiled > 0);
+    }
+}
@@ -0,0 +1,139 @@
+#include "catch.hpp"
+#include "cartridge.h"
+#include "mbc.h"
+#include <vector>
+
+// ROM where every byte holds the number of the bank it is in
+std::vector<u8> make_banked_rom(int num_banks)
+{
+    std::vector<u8> rom(num_banks * 0x4000);
+    for (int i = 0; i < (int)rom.size(); i++) {
+        rom[i] = i / 0x4000;
+    }
+    return rom;
+}
+
+TEST_CASE("MBC1 bank switching", "[mbc1]")
+{
+    std::vector<u8> rom = make_banked_rom(64);
+    std::vector<u8> ram(4 * 0x2000, 0);
+    MBC1Controller mbc(rom.data(), rom.size(), ram);
+
+    REQUIRE(mbc.rom0_base[0] == 0);
+    REQUIRE(mbc.romx_base[0] == 1);
+    REQUIRE(mbc.sram_base == nullptr);
+
+    // Bank 0 maps to bank 1
+    mbc.write_control(0x2000, 0);
+    REQUIRE(mbc.romx_base[0] == 1);
+    mbc.write_control(0x2000, 0x12);
+    REQUIRE(mbc.romx_base[0x3fff] == 0x12);
+
+    // Upper bits apply to 0x0000 - 0x3fff only in mode 1
+    mbc.write_control(0x4000, 1);
+    REQUIRE(mbc.romx_base[0] == 0x32);
+    REQUIRE(mbc.rom0_base[0] == 0);
+    mbc.write_control(0x6000, 1);
+    REQUIRE(mbc.rom0_base[0] == 0x20);
+
+    mbc.write_control(0x0000, 0x0a);
+    REQUIRE(mbc.sram_base == ram.data() + 0x2000);
+    mbc.write_control(0x0000, 0);
+    REQUIRE(mbc.sram_base == nullptr);
+}
+
+TEST_CASE("MBC2 built-in RAM", "[mbc2]")
+{
+    std::vector<u8> rom = make_banked_rom(16);
+    std::vector<u8> ram;
+    MBC2Controller mbc(rom.data(), rom.size(), ram);
+
+    // Address bit 8 selects the ROM bank register
+    mbc.write_control(0x2100, 5);
+    REQUIRE(mbc.romx_base[0] == 5);
+    mbc.write_control(0x2000, 7);
+    REQUIRE(mbc.romx_base[0] == 5);
+
+    REQUIRE(mbc.read_ram(0xa000) == 0xff);
+    mbc.write_control(0x0000, 0x0a);
+    mbc.write_ram(0xa001, 0xab);
+    REQUIRE(mbc.read_ram(0xa001) == 0xfb);
+    // RAM is mirrored every 512 bytes
+    REQUIRE(mbc.read_ram(0xa201) == 0xfb);
+}
+
+TEST_CASE("MBC3 RAM and RTC banks", "[mbc3]")
+{
+    std::vector<u8> rom = make_banked_rom(128);
+    std::vector<u8> ram(4 * 0x2000, 0);
+    MBC3Controller mbc(rom.data(), rom.size(), ram);
+
+    mbc.write_control(0x2000, 0x7f);
+    REQUIRE(mbc.romx_base[0] == 0x7f);
+
+    mbc.write_control(0x0000, 0x0a);
+    mbc.write_control(0x4000, 2);
+    REQUIRE(mbc.sram_base == ram.data() + 2 * 0x2000);
+
+    // RTC registers are not plain memory
+    mbc.write_control(0x4000, 0x08);
+    REQUIRE(mbc.sram_base == nullptr);
+    mbc.write_ram(0xa000, 42);
+    REQUIRE(mbc.read_ram(0xa000) == 42);
+
+    // Other values don't wrap onto a RAM bank or register
+    mbc.write_control(0x4000, 0x0d);
+    REQUIRE(mbc.sram_base == nullptr);
+    mbc.write_ram(0xa000, 7);
+    REQUIRE(mbc.read_ram(0xa000) == 0xff);
+    mbc.write_control(0x4000, 0x08);
+    REQUIRE(mbc.read_ram(0xa000) == 42);
+}
+
+TEST_CASE("MBC5 9-bit ROM bank", "[mbc5]")
+{
+    std::vector<u8> rom = make_banked_rom(512);
+    std::vector<u8> ram(16 * 0x2000, 0);
+    MBC5Controller mbc(rom.data(), rom.size(), ram);
+
+    // Unlike MBC1, bank 0 can be mapped to 0x4000 - 0x7fff
+    mbc.write_control(0x2000, 0);
+    REQUIRE(mbc.romx_base == rom.data());
+
+    mbc.write_control(0x2000, 0x34);
+    mbc.write_control(0x3000, 1);
+    REQUIRE(mbc.romx_base == rom.data() + 0x134 * 0x4000);
+
+    mbc.write_control(0x0000, 0x0a);
+    mbc.write_control(0x4000, 0xf);
+    REQUIRE(mbc.sram_base == ram.data() + 0xf * 0x2000);
+}
+
+TEST_CASE("Unsupported cartridge types run without a controller", "[mbc]")
+{
+    std::vector<u8> rom = make_banked_rom(2);
+    rom[0x147] = 0xfc;
+    Cartridge cart(RomImage::from_data(rom));
+
+    REQUIRE(cart.mbc == Cartridge::NONE);
+    REQUIRE(cart.read(0x4000) == 1);
+    cart.write(0x2000, 0);
+    REQUIRE(cart.read(0x4000) == 1);
+}
+
+TEST_CASE("Cartridge writes report bank switches", "[mbc]")
+{
+    std::vector<u8> rom = make_banked_rom(4);
+    rom[0x147] = 0x03;
+    rom[0x148] = 0x01;
+    rom[0x149] = 0x02;
+    Cartridge cart(RomImage::from_data(rom));
+
+    REQUIRE(cart.write(0x2000, 2));
+    REQUIRE(cart.read(0x4000) == 2);
+    // Selecting the same bank again changes nothing
+    REQUIRE_FALSE(cart.write(0x2000, 2));
+    REQUIRE(cart.write(0x0000, 0x0a));
+    REQUIRE_FALSE(cart.write(0xa000, 0x42));
+    REQUIRE(cart.read(0xa000) == 0x42);
+}
@@ -0,0 +1,54 @@
+#include "catch.hpp"
+#include "pacer.h"
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+using namespace std::chrono;
+
+namespace
+{
+    // Cycles in a number of milliseconds, rounded up so they never take less time
+    u64 ms_cycles(int ms) { return (u64)std::ceil(Pacer::CLOCK_RATE * ms / 1000); }
+
+    double ms_since(steady_clock::time_point start)
+    {
+        return duration<double, std::milli>(steady_clock::now() - start).count();
+    }
+}
+
+TEST_CASE("Pacer waits until the emulated time has passed", "[pacer]")
+{
+    Pacer pacer;
+    auto start = steady_clock::now();
+    pacer.wait(1000);
+    for (int frame = 1; frame <= 5; frame++) {
+        pacer.wait(1000 + ms_cycles(10 * frame));
+        REQUIRE(ms_since(start) >= 10 * frame);
+    }
+    REQUIRE(pacer.jitter().frames == 5);
+
+    // Too far behind, so timing starts over rather than racing to catch up
+    std::this_thread::sleep_for(milliseconds(200));
+    // Taken before the restart, which times the next wait from some point after it
+    start = steady_clock::now();
+    pacer.wait(1000 + ms_cycles(60));
+    pacer.wait(1000 + ms_cycles(70));
+    REQUIRE(ms_since(start) >= 10);
+}
+
+TEST_CASE("Frame time errors are summarized as percentiles", "[pacer]")
+{
+    std::vector<double> frame_ms, ideal_ms;
+    for (int i = 100; i > 0; i--) {
+        frame_ms.push_back(20 + (i % 2 ? i : -i) / 10.0);
+        ideal_ms.push_back(20);
+    }
+    Pacer::Jitter jitter = Pacer::summarize(frame_ms, ideal_ms);
+    REQUIRE(jitter.frames == 100);
+    REQUIRE(jitter.mean_frame_ms == Approx(19.95));
+    REQUIRE(jitter.p50 == Approx(5.1));
+    REQUIRE(jitter.p90 == Approx(9.1));
+    REQUIRE(jitter.p99 == Approx(10));
+    REQUIRE(jitter.max == Approx(10));
+}
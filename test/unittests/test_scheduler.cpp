@@ -0,0 +1,200 @@
+#include "catch.hpp"
+#include "interrupts.h"
+#include "registers.h"
+#include "scheduler.h"
+#include "timer.h"
+#include <random>
+
+TEST_CASE("Scheduler orders events by deadline", "[scheduler]")
+{
+    Scheduler sched;
+    REQUIRE(sched.next_deadline() == Scheduler::NEVER);
+
+    sched.schedule(Scheduler::TIMER, 300);
+    sched.schedule(Scheduler::PPU_MODE, 100);
+    sched.schedule(Scheduler::DMA_END, 200);
+    sched.schedule(Scheduler::APU_FRAME_SEQUENCER, 50);
+    REQUIRE(sched.next_deadline() == 50);
+
+    // Rescheduling replaces the previous deadline
+    sched.schedule(Scheduler::APU_FRAME_SEQUENCER, 400);
+    sched.cancel(Scheduler::DMA_END);
+    REQUIRE_FALSE(sched.scheduled(Scheduler::DMA_END));
+    REQUIRE(sched.next_deadline() == 100);
+
+    // Nothing is due until now reaches the deadline
+    sched.now = 99;
+    REQUIRE(sched.pop_due() == Scheduler::NUM_EVENTS);
+    sched.now = 350;
+    REQUIRE(sched.pop_due() == Scheduler::PPU_MODE);
+    REQUIRE(sched.pop_due() == Scheduler::TIMER);
+    REQUIRE(sched.pop_due() == Scheduler::NUM_EVENTS);
+    REQUIRE(sched.next_deadline() == 400);
+}
+
+TEST_CASE("Timer overflow is scheduled", "[timer]")
+{
+    Scheduler sched;
+    Interrupts interrupts;
+    Timer timer(&interrupts, &sched);
+
+    sched.now = 0x1234;
+    REQUIRE(timer.read(reg::DIV) == 0x12);
+    timer.write(reg::DIV, 0);
+    REQUIRE(timer.read(reg::DIV) == 0);
+
+    // 16 cycles per increment, overflowing after 2 increments
+    timer.write(reg::TIMA, 0xfe);
+    timer.write(reg::TMA, 0x80);
+    timer.write(reg::TAC, 0x05);
+    REQUIRE(sched.next_deadline() == 0x1234 + 32);
+
+    // TIMA counts up without any events
+    sched.now = 0x1234 + 16;
+    REQUIRE(timer.read(reg::TIMA) == 0xff);
+    REQUIRE(sched.pop_due() == Scheduler::NUM_EVENTS);
+
+    sched.now = sched.next_deadline();
+    REQUIRE(sched.pop_due() == Scheduler::TIMER);
+    timer.overflow();
+    REQUIRE(timer.read(reg::TIMA) == 0x80);
+    REQUIRE((interrupts.read() & (1 << Interrupts::TIMER_bit)) != 0);
+    REQUIRE(sched.next_deadline() == 0x1234 + 32 + 128 * 16);
+
+    // Stopping the timer cancels the event
+    timer.write(reg::TAC, 0x01);
+    REQUIRE_FALSE(sched.scheduled(Scheduler::TIMER));
+}
+
+TEST_CASE("Falling edges from DIV and TAC writes increment TIMA", "[timer]")
+{
+    Scheduler sched;
+    Interrupts interrupts;
+    Timer timer(&interrupts, &sched);
+
+    // 64 cycles per increment, from counter bit 5
+    timer.write(reg::TAC, 0x06);
+    sched.now = 0x20;
+    REQUIRE(timer.read(reg::TIMA) == 0);
+    // Bit 5 set, so resetting the counter is a falling edge
+    timer.write(reg::DIV, 0);
+    REQUIRE(timer.read(reg::TIMA) == 1);
+    // The next edge is a full period after the reset
+    sched.now = 0x20 + 63;
+    REQUIRE(timer.read(reg::TIMA) == 1);
+    sched.now = 0x20 + 64;
+    REQUIRE(timer.read(reg::TIMA) == 2);
+
+    // Bit 5 clear, so no edge
+    timer.write(reg::DIV, 0);
+    REQUIRE(timer.read(reg::TIMA) == 2);
+
+    // Disabling the timer with bit 5 set is an edge, but not with it clear
+    sched.now += 0x20;
+    timer.write(reg::TAC, 0x02);
+    REQUIRE(timer.read(reg::TIMA) == 3);
+    timer.write(reg::TAC, 0x06);
+    sched.now += 0x20;
+    REQUIRE(timer.read(reg::TIMA) == 4);
+    timer.write(reg::TAC, 0x02);
+    REQUIRE(timer.read(reg::TIMA) == 4);
+}
+
+namespace
+{
+    // Timer stepped one cycle at a time, with TIMA incremented on each falling edge
+    struct ReferenceTimer
+    {
+        u16 counter = 0;
+        u8 tima = 0, tma = 0, tac = 0;
+        bool interrupt = false;
+
+        bool signal() const
+        {
+            static const int counter_bit[] = {9, 3, 5, 7};
+            return (tac & 4) && ((counter >> counter_bit[tac & 3]) & 1);
+        }
+
+        void increment()
+        {
+            if (++tima == 0) {
+                tima = tma;
+                interrupt = true;
+            }
+        }
+
+        void run(u64 cycles)
+        {
+            for (u64 i = 0; i < cycles; i++) {
+                bool was_set = signal();
+                counter++;
+                if (was_set && !signal()) {
+                    increment();
+                }
+            }
+        }
+
+        void write(u16 addr, u8 data)
+        {
+            bool was_set = signal();
+            if (addr == reg::DIV) counter = 0;
+            else if (addr == reg::TIMA) tima = data;
+            else if (addr == reg::TMA) tma = data;
+            else tac = data & 7;
+            if (was_set && !signal()) {
+                increment();
+            }
+        }
+    };
+}
+
+TEST_CASE("Timer matches a timer stepped every cycle", "[timer]")
+{
+    std::mt19937 rng(42);
+    Scheduler sched;
+    Interrupts interrupts;
+    Timer timer(&interrupts, &sched);
+    ReferenceTimer reference;
+
+    for (int i = 0; i < 20000; i++) {
+        // Run up to a random time, handling overflows on the way
+        u64 target = sched.now + rng() % 600;
+        while (sched.next_deadline() <= target) {
+            reference.run(sched.next_deadline() - sched.now);
+            sched.now = sched.next_deadline();
+            REQUIRE(sched.pop_due() == Scheduler::TIMER);
+            timer.overflow();
+        }
+        reference.run(target - sched.now);
+        sched.now = target;
+
+        u8 data = rng();
+        switch (rng() % 8)
+        {
+        case 0:
+            timer.write(reg::DIV, data);
+            reference.write(reg::DIV, data);
+            break;
+        case 1:
+            timer.write(reg::TIMA, data);
+            reference.write(reg::TIMA, data);
+            break;
+        case 2:
+            timer.write(reg::TMA, data);
+            reference.write(reg::TMA, data);
+            break;
+        case 3:
+            timer.write(reg::TAC, data);
+            reference.write(reg::TAC, data);
+            break;
+        default:
+            break;
+        }
+        REQUIRE(timer.read(reg::DIV) == reference.counter >> 8);
+        REQUIRE(timer.read(reg::TIMA) == reference.tima);
+        bool requested = (interrupts.read() >> Interrupts::TIMER_bit) & 1;
+        REQUIRE(requested == reference.interrupt);
+        interrupts.clear(Interrupts::TIMER_bit);
+        reference.interrupt = false;
+    }
+}